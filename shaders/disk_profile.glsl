@@ -0,0 +1,53 @@
+// Radial profile of the accretion disk and the layout of the baked disk textures
+// (DiskTextures): shared by raymarchDisk (trace_common.glsl) and disk_bake.comp, so both
+// paths shade the same disk. Needs Rs (geodesic.glsl) and hash2 (sky.glsl).
+
+// Turbulence: two octaves of value noise over (angle, radius) at DISK_NOISE_FREQ cells
+// per unit. The baked texture covers DISK_NOISE_CELLS base cells, clamped across the
+// angle (raymarchDisk's angle stays below 2.2 cells) and wrapping along the radius, so
+// the time scroll is a texture offset. Sizes must match DiskTextures::kNoise*.
+const float DISK_NOISE_FREQ  = 70.0;
+const vec2  DISK_NOISE_CELLS = vec2(4.0, 64.0);
+const int   DISK_NOISE_TEXELS_PER_CELL = 16;
+
+// Emission table: rgb gravitational redshift, a the radial fade; DISK_EMISSION_SAMPLES
+// texel centres over r in [0, DISK_EMISSION_R], clamped beyond (the fade is zero there).
+// The place for a physical (e.g. Novikov-Thorne) emission profile.
+const float DISK_EMISSION_R       = 10.0 * Rs;
+const int   DISK_EMISSION_SAMPLES = 512;
+
+// Inner and outer edge fade of the disk density at radius r
+float diskFade(float r) {
+    float fade = clamp((r - Rs * 0.75) * (1.0/Rs) * 1.5, 0.0, 1.0);
+    fade *= clamp((Rs * 10.0 - r) * (1.0/Rs) * 0.20, 0.0, 1.0);
+    return fade * fade;
+}
+
+// Per-channel colour shift of emission at radius r
+vec3 diskRedshift(float r) {
+    float f = max(1.0 - Rs / r, 0.01);
+    float z = 1.0 / sqrt(f) - 1.0;
+    return vec3(1.0 + z * 0.5, 1.0 + z * 0.2, 1.0 - z * 0.3);
+}
+
+// Value noise with its lattice wrapped every period cells along y (the procedural path
+// uses value() in sky.glsl, which does not tile)
+float tiledValue(vec2 p, float period) {
+    vec2 c = floor(p);
+    float y0 = mod(c.y, period);
+    float y1 = mod(c.y + 1.0, period);
+    float bl = hash2(vec2(c.x,       y0));
+    float br = hash2(vec2(c.x + 1.0, y0));
+    float tl = hash2(vec2(c.x,       y1));
+    float tr = hash2(vec2(c.x + 1.0, y1));
+
+    vec2 fr = fract(p);
+    fr = (3.0 - 2.0*fr)*fr*fr;
+    return mix(mix(bl, br, fr.x), mix(tl, tr, fr.x), fr.y);
+}
+
+// The disk turbulence at p in base cells, tiling every DISK_NOISE_CELLS.y along y
+float diskNoise(vec2 p) {
+    return 0.66 * tiledValue(p, DISK_NOISE_CELLS.y)
+         + 0.33 * tiledValue(p * 2.0, DISK_NOISE_CELLS.y * 2.0);
+}
@@ -0,0 +1,416 @@
+// Shared geodesic model: used by the per-pixel trace (gargantua.comp), the wavefront
+// stages and the deflection LUT bake (deflection_lut.comp), so all integrate identical
+// paths. The metric is a specialization constant; the integrators only see it through
+// positionRate() / momentumRate() and the photon accessors below.
+
+const float Rs = 1.0;  // Schwarzschild radius in geometric units (the unit of length)
+const float M  = Rs * 0.5;
+
+// Quality switches, specialized per TraceVariant (constant_id 10+ so they never clash
+// with the including shader's own). The LUT bake is specialized like the trace.
+layout (constant_id = 10) const int   MAX_GEODESIC_STEPS = 1200;
+layout (constant_id = 11) const float STEP_SIZE   = 0.08;   // outer step tier
+layout (constant_id = 12) const bool  GLOW        = true;   // gravitational glow
+layout (constant_id = 13) const bool  PHOTON_RING = true;   // photon sphere highlight
+
+// Metric (the trace's GeodesicMetric; the LUT bake keeps Schwarzschild). Kerr's spin comes
+// from the frame's scene slot (SceneState.hole.x), set once per invocation by the including
+// main() with setSpin().
+const int METRIC_SCHWARZSCHILD = 0;
+const int METRIC_KERR          = 1;
+layout (constant_id = 15) const int METRIC = METRIC_SCHWARZSCHILD;
+
+float kerrA = 0.0;   // a = spin * M
+
+void setSpin(float spin) {
+    if (METRIC == METRIC_KERR) kerrA = clamp(spin, -0.998, 0.998) * M;
+}
+
+// Trace termination radii
+const float HORIZON_R = Rs * 1.05;
+const float ESCAPE_R  = 100.0;
+
+// Schwarzschild: Cartesian position and velocity, E and L for reference.
+// Kerr: pos = Boyer-Lindquist (r, theta, phi) with the spin along +y, vel = (p_r, p_theta,
+// L = p_phi) with E = 1; the Carter constant Q is implied by the initial p_theta.
+struct Photon {
+    vec3 pos;      // Position (x, y, z)
+    vec3 vel;      // 3-velocity (dx/dλ, dy/dλ, dz/dλ)
+    float E;       // Energy (conserved)
+    float L;       // Angular momentum magnitude (conserved)
+};
+
+// === SCHWARZSCHILD GEODESIC INTEGRATION ===
+
+// Schwarzschild metric factor
+float metricFactor(float r) {
+    return max(1.0 - Rs / r, 0.001);
+}
+
+// Geodesic acceleration in Cartesian coordinates
+vec3 geodesicAcceleration(vec3 pos, vec3 vel) {
+    float r = length(pos);
+    if (r < Rs * 1.01) return vec3(0.0);
+
+    float r2 = r * r;
+    float r3 = r2 * r;
+
+    vec3 rhat = pos / r;
+    float vr = dot(vel, rhat);
+    float vt2 = dot(vel, vel) - vr * vr;  // Tangential velocity squared
+
+    float f = metricFactor(r);
+    float f_prime = Rs / r2;  // df/dr
+
+    // Geodesic equation in Schwarzschild (Cartesian form)
+
+    // Radial component
+    vec3 acc_radial = -(f_prime / (2.0 * f)) * (f * (1.0 + dot(vel, vel)) - vr * vr / f) * rhat;
+
+    // Angular component
+    vec3 acc_angular = -(Rs / r3) * (vel - vr * rhat);
+
+    return acc_radial + acc_angular;
+}
+
+// === KERR GEODESIC INTEGRATION ===
+// Hamiltonian form in Boyer-Lindquist coordinates, first order in (r, theta, phi,
+// p_r, p_theta) with E and L constant: 2 Sigma H = Delta p_r^2 - P^2 / Delta
+// + p_theta^2 + T^2 = 0, P = r^2 + a^2 - a L, T = L / sin(theta) - a sin(theta).
+// The on-shell H = 0 drops the dSigma terms of the momentum equations.
+
+// sin(theta), kept away from zero on the axis (sign preserved)
+float kerrSin(float theta) {
+    float s = sin(theta);
+    return (s >= 0.0) ? max(s, 1e-4) : min(s, -1e-4);
+}
+
+vec3 kerrPositionRate(vec3 x, vec3 p) {
+    float r = x.x;
+    float st = kerrSin(x.y);
+    float ct = cos(x.y);
+    float a = kerrA;
+    float sigma = r * r + a * a * ct * ct;
+    float delta = max(r * r - 2.0 * M * r + a * a, 1e-6);
+    float P = r * r + a * a - a * p.z;
+    float T = p.z / st - a * st;
+    return vec3(delta * p.x, p.y, a * P / delta + T / st) / sigma;
+}
+
+vec3 kerrMomentumRate(vec3 x, vec3 p) {
+    float r = x.x;
+    float st = kerrSin(x.y);
+    float ct = cos(x.y);
+    float a = kerrA;
+    float sigma = r * r + a * a * ct * ct;
+    float delta = max(r * r - 2.0 * M * r + a * a, 1e-6);
+    float dDelta = 2.0 * (r - M);
+    float P = r * r + a * a - a * p.z;
+    float T = p.z / st - a * st;
+
+    float dNdr = dDelta * p.x * p.x - 4.0 * r * P / delta + P * P * dDelta / (delta * delta);
+    return vec3(-0.5 * dNdr, T * ct * (p.z / (st * st) + a), 0.0) / sigma;
+}
+
+// Oblate spheroidal (Boyer-Lindquist) to Cartesian, spin along +y
+vec3 kerrCartesian(vec3 x) {
+    float rho = sqrt(x.x * x.x + kerrA * kerrA);
+    return vec3(rho * sin(x.y) * cos(x.z), x.x * cos(x.y), rho * sin(x.y) * sin(x.z));
+}
+
+// d(kerrCartesian)/dλ; the coordinate basis vectors are orthogonal
+vec3 kerrCartesianVelocity(vec3 x, vec3 p) {
+    vec3 d = kerrPositionRate(x, p);
+    float r = x.x;
+    float rho = sqrt(r * r + kerrA * kerrA);
+    float st = sin(x.y), ct = cos(x.y), sp = sin(x.z), cp = cos(x.z);
+    vec3 er = vec3(r / rho * st * cp, ct, r / rho * st * sp);
+    vec3 et = vec3(rho * ct * cp, -r * st, rho * ct * sp);
+    vec3 ep = vec3(-rho * st * sp, 0.0, rho * st * cp);
+    return d.x * er + d.y * et + d.z * ep;
+}
+
+// Photon at Cartesian pos moving along dir (the direction in the coordinate frame),
+// made null and normalised to E = 1
+Photon kerrPhoton(vec3 pos, vec3 dir) {
+    float a = kerrA;
+    float w = dot(pos, pos) - a * a;
+    float r = sqrt(0.5 * (w + sqrt(w * w + 4.0 * a * a * pos.y * pos.y)));
+    float theta = acos(clamp(pos.y / r, -1.0, 1.0));
+    float phi = atan(pos.z, pos.x);
+
+    float rho2 = r * r + a * a;
+    float rho = sqrt(rho2);
+    float st = kerrSin(theta), ct = cos(theta), sp = sin(phi), cp = cos(phi);
+    float sigma = r * r + a * a * ct * ct;
+    float delta = max(r * r - 2.0 * M * r + a * a, 1e-6);
+
+    // Coordinate velocities: dir projected on the (orthogonal) basis
+    float rd  = dot(dir, vec3(r / rho * st * cp, ct, r / rho * st * sp)) * rho2 / sigma;
+    float thd = dot(dir, vec3(rho * ct * cp, -r * st, rho * ct * sp)) / sigma;
+    float phd = dot(dir, vec3(-sp, 0.0, cp)) / (rho * st);
+
+    float gtt = -(1.0 - 2.0 * M * r / sigma);
+    float gtp = -2.0 * M * a * r * st * st / sigma;
+    float gpp = (rho2 + 2.0 * M * a * a * r * st * st / sigma) * st * st;
+    float grr = sigma / delta;
+
+    // Future-directed dt/dλ of the null vector, then p_mu = g_mu_nu dx^nu / E
+    float S = grr * rd * rd + sigma * thd * thd + gpp * phd * phd;
+    float td = (-gtp * phd - sqrt(gtp * gtp * phd * phd - gtt * S)) / gtt;
+    float E = -(gtt * td + gtp * phd);
+
+    Photon photon;
+    photon.pos = vec3(r, theta, phi);
+    photon.vel = vec3(grr * rd, sigma * thd, gtp * td + gpp * phd) / E;
+    photon.E = 1.0;
+    photon.L = photon.vel.z;
+    return photon;
+}
+
+// === METRIC INTERFACE ===
+// Everything outside this file handles photons through these.
+
+vec3 positionRate(vec3 x, vec3 p) {
+    return (METRIC == METRIC_KERR) ? kerrPositionRate(x, p) : p;
+}
+
+vec3 momentumRate(vec3 x, vec3 p) {
+    return (METRIC == METRIC_KERR) ? kerrMomentumRate(x, p) : geodesicAcceleration(x, p);
+}
+
+Photon makePhoton(vec3 pos, vec3 dir) {
+    if (METRIC == METRIC_KERR) return kerrPhoton(pos, dir);
+    Photon photon;
+    photon.pos = pos;
+    photon.vel = dir;
+    photon.E = metricFactor(length(pos));   // Energy at infinity normalized
+    photon.L = length(cross(pos, dir));     // Angular momentum
+    return photon;
+}
+
+// Boyer-Lindquist r for Kerr (the oblate radius; |pos| far out)
+float photonRadius(Photon photon) {
+    return (METRIC == METRIC_KERR) ? photon.pos.x : length(photon.pos);
+}
+
+vec3 photonPosition(Photon photon) {
+    return (METRIC == METRIC_KERR) ? kerrCartesian(photon.pos) : photon.pos;
+}
+
+// Cartesian direction of motion (not normalised)
+vec3 photonDirection(Photon photon) {
+    return (METRIC == METRIC_KERR) ? kerrCartesianVelocity(photon.pos, photon.vel) : photon.vel;
+}
+
+bool photonOutgoing(Photon photon) {
+    return (METRIC == METRIC_KERR) ? photon.vel.x > 0.0 : dot(photon.pos, photon.vel) > 0.0;
+}
+
+// Capture radius: 5% outside the (outer) event horizon
+float horizonRadius() {
+    if (METRIC == METRIC_KERR) return 1.05 * (M + sqrt(max(M * M - kerrA * kerrA, 0.0)));
+    return HORIZON_R;
+}
+
+// Step error of a position difference e at x, relative to the radius, and of a
+// velocity (momentum) difference; p_theta grows with r like an angular momentum
+float positionError(vec3 x, vec3 e) {
+    if (METRIC == METRIC_KERR) {
+        float r = x.x;
+        return length(vec3(e.x, r * e.y, r * sin(x.y) * e.z)) / max(r, 1.0);
+    }
+    return length(e) / max(length(x), 1.0);
+}
+
+float velocityError(vec3 x, vec3 e) {
+    return (METRIC == METRIC_KERR) ? length(vec2(e.x, e.y / max(x.x, 1.0))) : length(e);
+}
+
+// === INTEGRATORS ===
+
+// RK4 integration step
+void rk4Step(inout Photon p, float h) {
+    vec3 p0 = p.pos;
+    vec3 v0 = p.vel;
+
+    // k1
+    vec3 k1v = momentumRate(p0, v0);
+    vec3 k1p = positionRate(p0, v0);
+
+    // k2
+    vec3 p1 = p0 + 0.5 * h * k1p;
+    vec3 v1 = v0 + 0.5 * h * k1v;
+    vec3 k2v = momentumRate(p1, v1);
+    vec3 k2p = positionRate(p1, v1);
+
+    // k3
+    vec3 p2 = p0 + 0.5 * h * k2p;
+    vec3 v2 = v0 + 0.5 * h * k2v;
+    vec3 k3v = momentumRate(p2, v2);
+    vec3 k3p = positionRate(p2, v2);
+
+    // k4
+    vec3 p3 = p0 + h * k3p;
+    vec3 v3 = v0 + h * k3v;
+    vec3 k4v = momentumRate(p3, v3);
+    vec3 k4p = positionRate(p3, v3);
+
+    // Update
+    p.pos += (h / 6.0) * (k1p + 2.0 * k2p + 2.0 * k3p + k4p);
+    p.vel += (h / 6.0) * (k1v + 2.0 * k2v + 2.0 * k3v + k4v);
+}
+
+// Dormand-Prince 5(4) step with embedded error estimate and step-size control.
+// accel carries the first stage across calls (FSAL): initialise it with
+// momentumRate(pos, vel) and leave it alone afterwards. On return h holds the
+// next step to try and taken the step actually applied (0 if the step was rejected).
+const float DP_H_MIN = 1e-3;
+const float DP_H_MAX = 2.0;
+
+bool dp45Step(inout Photon p, inout vec3 accel, inout float h, float tol, out float taken) {
+    vec3 y0 = p.pos;
+    vec3 v0 = p.vel;
+
+    vec3 k1p = positionRate(y0, v0);
+    vec3 k1v = accel;
+
+    vec3 pp = y0 + h * (1.0/5.0) * k1p;
+    vec3 vv = v0 + h * (1.0/5.0) * k1v;
+    vec3 k2p = positionRate(pp, vv);
+    vec3 k2v = momentumRate(pp, vv);
+
+    pp = y0 + h * ((3.0/40.0) * k1p + (9.0/40.0) * k2p);
+    vv = v0 + h * ((3.0/40.0) * k1v + (9.0/40.0) * k2v);
+    vec3 k3p = positionRate(pp, vv);
+    vec3 k3v = momentumRate(pp, vv);
+
+    pp = y0 + h * ((44.0/45.0) * k1p - (56.0/15.0) * k2p + (32.0/9.0) * k3p);
+    vv = v0 + h * ((44.0/45.0) * k1v - (56.0/15.0) * k2v + (32.0/9.0) * k3v);
+    vec3 k4p = positionRate(pp, vv);
+    vec3 k4v = momentumRate(pp, vv);
+
+    pp = y0 + h * ((19372.0/6561.0) * k1p - (25360.0/2187.0) * k2p + (64448.0/6561.0) * k3p - (212.0/729.0) * k4p);
+    vv = v0 + h * ((19372.0/6561.0) * k1v - (25360.0/2187.0) * k2v + (64448.0/6561.0) * k3v - (212.0/729.0) * k4v);
+    vec3 k5p = positionRate(pp, vv);
+    vec3 k5v = momentumRate(pp, vv);
+
+    pp = y0 + h * ((9017.0/3168.0) * k1p - (355.0/33.0) * k2p + (46732.0/5247.0) * k3p + (49.0/176.0) * k4p - (5103.0/18656.0) * k5p);
+    vv = v0 + h * ((9017.0/3168.0) * k1v - (355.0/33.0) * k2v + (46732.0/5247.0) * k3v + (49.0/176.0) * k4v - (5103.0/18656.0) * k5v);
+    vec3 k6p = positionRate(pp, vv);
+    vec3 k6v = momentumRate(pp, vv);
+
+    // 5th order solution
+    vec3 y1 = y0 + h * ((35.0/384.0) * k1p + (500.0/1113.0) * k3p + (125.0/192.0) * k4p - (2187.0/6784.0) * k5p + (11.0/84.0) * k6p);
+    vec3 v1 = v0 + h * ((35.0/384.0) * k1v + (500.0/1113.0) * k3v + (125.0/192.0) * k4v - (2187.0/6784.0) * k5v + (11.0/84.0) * k6v);
+    vec3 k7p = positionRate(y1, v1);
+    vec3 k7v = momentumRate(y1, v1);
+
+    // Difference to the embedded 4th order solution
+    vec3 ep = h * ((71.0/57600.0) * k1p - (71.0/16695.0) * k3p + (71.0/1920.0) * k4p - (17253.0/339200.0) * k5p + (22.0/525.0) * k6p - (1.0/40.0) * k7p);
+    vec3 ev = h * ((71.0/57600.0) * k1v - (71.0/16695.0) * k3v + (71.0/1920.0) * k4v - (17253.0/339200.0) * k5v + (22.0/525.0) * k6v - (1.0/40.0) * k7v);
+
+    // Position error relative to radius (far-field rays may take long steps), velocity absolute
+    float r = (METRIC == METRIC_KERR) ? y0.x : length(y0);
+    float err = max(positionError(y0, ep), velocityError(y0, ev)) / tol;
+
+    // Never step further than a quarter of the radius, so the horizon can't be skipped
+    float hMax = min(DP_H_MAX, 0.25 * r);
+    float factor = (err > 0.0) ? clamp(0.9 * pow(err, -0.2), 0.2, 5.0) : 5.0;
+
+    if (err <= 1.0 || h <= DP_H_MIN) {
+        p.pos = y1;
+        p.vel = v1;
+        accel = k7v;
+        taken = h;
+        h = clamp(h * factor, DP_H_MIN, hMax);
+        return true;
+    }
+    taken = 0.0;
+    h = clamp(h * factor, DP_H_MIN, hMax);
+    return false;
+}
+
+// === WEAK-FIELD SHORTCUTS ===
+// Far from the hole rays are straight lines plus a first-order bend: the deflection
+// between two points on a line of impact parameter b is (Rs / b)(sin phi2 - sin phi1),
+// phi measured from closest approach (so 2 Rs / b over the whole line).
+
+// Rotates dir towards the hole by the first-order deflection between two line points
+// whose signed distances from closest approach over |pos| are sin1 and sin2.
+vec3 bendTowardsHole(vec3 pos, vec3 dir, float b, float sin1, float sin2) {
+    if (b < 1e-3) return dir;                  // radial: no bend
+    float alpha = (Rs / b) * (sin2 - sin1);
+    vec3 towards = -(pos - dot(pos, dir) * dir) / b;
+    return normalize(cos(alpha) * dir + sin(alpha) * towards);
+}
+
+// Direction at infinity of a ray leaving the weak-field region from pos along dir
+vec3 asymptoticDirection(vec3 pos, vec3 vel) {
+    vec3 dir = normalize(vel);
+    float r = length(pos);
+    float b = length(cross(pos, dir));
+    return bendTowardsHole(pos, dir, b, dot(pos, dir) / r, 1.0);
+}
+
+// Moves a ray that starts outside radius R straight to the sphere, bending it to first
+// order on the way. Returns false if it misses; dir is then already the asymptotic one.
+bool enterInteractionSphere(inout vec3 pos, inout vec3 dir, float R) {
+    float r0 = length(pos);
+    if (r0 <= R) return true;
+
+    float s = dot(pos, dir);                   // < 0 when heading inwards
+    float b = length(cross(pos, dir));
+    if (s >= 0.0 || b >= R) {
+        dir = asymptoticDirection(pos, dir);
+        return false;
+    }
+
+    float t = -s - sqrt(R * R - b * b);
+    vec3 hit = pos + t * dir;
+    dir = bendTowardsHole(pos, dir, b, s / r0, dot(hit, dir) / R);
+    pos = hit;
+    return true;
+}
+
+// Fixed step tiers, finer near the photon sphere
+float stepSize(float r) {
+    float h = STEP_SIZE;
+    if (r < Rs * 3.0) h *= 0.3;
+    if (r < Rs * 2.0) h *= 0.3;
+    return h;
+}
+
+// Glow picked up at radius r on one integration step (not step-length weighted,
+// so it must be summed over the same steps as the trace)
+vec3 glowAt(float r) {
+    vec3 glow = vec3(0.0);
+
+    // Gravitational glow, made tighter and less spread
+    float rNorm = r / Rs;
+    if (GLOW && rNorm > 1.05 && rNorm < 6.0) {
+        float glowIntensity = 0.0015 / (r * r * r); // ~1/r^3 falloff
+        float focus = smoothstep(1.1, 2.5, rNorm) * (1.0 - smoothstep(3.5, 6.0, rNorm));
+        glow += vec3(1.25, 1.15, 1.05) * glowIntensity * focus;
+    }
+
+    // Photon sphere highlight, slightly reduced
+    if (PHOTON_RING && r > Rs * 1.48 && r < Rs * 1.52) {
+        glow += vec3(0.5, 0.4, 0.3) * 0.005;
+    }
+    return glow;
+}
+
+// Deflection LUT layout (Schwarzschild only; see DeflectionLut).
+// Columns: impact parameter L in [0, camera radius]. Rows of the path image: radius r
+// at orbital angle phi = row * LUT_PHI_MAX / (LUT_PHI_SAMPLES - 1) from the camera.
+const int   LUT_L_SAMPLES   = 1024;
+const int   LUT_PHI_SAMPLES = 512;
+const float LUT_PHI_MAX     = 4.0 * 3.14159265;
+
+// Summary image (LUT_L_SAMPLES x 2). Row 0: (phi at termination, r at termination,
+// velocity angle relative to phi, outcome), row 1: (summed glow, 0).
+const float LUT_ESCAPED    = 0.0;
+const float LUT_CAPTURED   = 1.0;
+const float LUT_UNRESOLVED = 2.0;   // step limit or wound past LUT_PHI_MAX: trace instead
+
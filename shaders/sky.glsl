@@ -0,0 +1,77 @@
+// Procedural sky: value noise stars, nebula and a coordinate grid as a function of the
+// escape direction. Evaluated per ray by the trace when the baked cubemap is off, and
+// once per texel by sky_bake.comp otherwise (always fp32 there).
+
+// Shading precision. Built with HALF_SHADING (the *_fp16 SPIR-V, used where the device
+// has shaderFloat16) the sky and disk colour and noise math runs in float16; hashes,
+// angles and positions stay fp32 (hash arguments and the grid phase need the range), and
+// so does everything in geodesic.glsl. Without it these are plain float types.
+#ifdef HALF_SHADING
+#define hfloat float16_t
+#define hvec2  f16vec2
+#define hvec3  f16vec3
+#define hvec4  f16vec4
+#else
+#define hfloat float
+#define hvec2  vec2
+#define hvec3  vec3
+#define hvec4  vec4
+#endif
+#define H(x) hfloat(x)
+
+float hash(float x) { return fract(sin(x)*152754.742); }
+float hash2(vec2 x) { return hash(x.x + hash(x.y)); }
+
+hfloat value(vec2 p, float f) {
+    hfloat bl = hfloat(hash2(floor(p*f + vec2(0.,0.))));
+    hfloat br = hfloat(hash2(floor(p*f + vec2(1.,0.))));
+    hfloat tl = hfloat(hash2(floor(p*f + vec2(0.,1.))));
+    hfloat tr = hfloat(hash2(floor(p*f + vec2(1.,1.))));
+
+    hvec2 fr = hvec2(fract(p*f));
+    fr = (H(3.0) - H(2.0)*fr)*fr*fr;
+    hfloat b = mix(bl, br, fr.x);
+    hfloat t = mix(tl, tr, fr.x);
+    return mix(b, t, fr.y);
+}
+
+vec4 background(vec3 ray) {
+    vec2 uv = ray.xy;
+
+    if (abs(ray.x) > 0.5)
+    uv.x = ray.z;
+    else if (abs(ray.y) > 0.5)
+    uv.y = ray.z;
+
+    // pow(x, 256) amplifies the log2 error of a half pow; keep the star mask fp32
+    float brightness = value(uv*3.0, 100.0);
+    hfloat color = value(uv*2.0, 20.0);
+    brightness = pow(brightness, 256.0);
+    brightness = brightness * 100.0;
+    brightness = clamp(brightness, 0.0, 1.0);
+
+    hvec3 stars = hfloat(brightness) * mix(hvec3(1.0, 0.6, 0.2), hvec3(0.2, 0.6, 1.0), color);
+
+    hvec3 nebula = hvec3(0.02, 0.01, 0.03);
+    hfloat n1 = value(uv * 1.5, 10.0);
+    hfloat n2 = value(uv * 3.0, 20.0);
+    nebula += hvec3(n1 * H(0.1), n2 * H(0.05), n1 * n2 * H(0.08));
+
+    float gridScale = 0.04;
+    float theta = atan(ray.y, ray.x);
+    float phi = asin(clamp(ray.z, -1.0, 1.0));
+
+    float gridTheta = abs(fract(theta / gridScale) - 0.5);
+    float gridPhi = abs(fract(phi / gridScale) - 0.5);
+
+    float gridWidth = 0.004;
+    hfloat grid = H(0.0);
+
+    if (gridTheta < gridWidth || gridPhi < gridWidth) {
+        grid = H(1.0);
+    }
+
+    nebula += hvec3(0.08, 0.1, 0.15) * grid;
+
+    return vec4(vec3(nebula + stars), 1.0);
+}
@@ -0,0 +1,263 @@
+// Shading shared by the per-pixel trace (gargantua.comp) and the wavefront stages
+// (wavefront.comp): specialization constants, sky, disk raymarch, ray fates,
+// primary rays and tone mapping. Both pipelines are specialized from the same
+// TraceSpecConstants, so a variant renders identically either way.
+
+// Set by ComputePipeline when writing a UNORM swapchain directly, so the result matches
+// the UNORM -> SRGB blit of the storage image path.
+layout (constant_id = 0) const bool ENCODE_SRGB = false;
+
+// Samples per pixel axis. 1 under temporal accumulation (temporal.comp resolves the
+// jittered samples over frames), 2 for the brute-force 2x2 supersampled path.
+layout (constant_id = 1) const int AA = 2;
+
+// Integrator: 0 = fixed-tier RK4 (reference), 1 = adaptive Dormand-Prince 5(4)
+layout (constant_id = 3) const int   INTEGRATOR = 0;
+layout (constant_id = 4) const float TOLERANCE  = 1e-4;   // DP45 local error per step
+// Interaction radius: outside it rays move analytically (see geodesic.glsl). <= 0: integrate
+// all the way to ESCAPE_R. Must stay clear of the disk, which extends to 10 Rs.
+layout (constant_id = 5) const float FAR_FIELD_R = 20.0;
+
+// Quality and feature switches (TraceVariant); a feature that is off is dead code
+layout (constant_id = 6) const bool DISK       = true;   // accretion disk
+layout (constant_id = 7) const int  DISK_STEPS = 12;     // raymarch samples per disk crossing
+// 0 = shaded; 1 = ray fate (red: disk coverage, green: escaped, blue: step limit,
+// black: captured); 2 = escape direction as colour (lensing map), untonemapped;
+// 3 = step-count heatmap (gargantua.comp only)
+layout (constant_id = 8) const int  DEBUG_VIEW = 0;
+
+#include "geodesic.glsl"
+#include "sky.glsl"
+#include "disk_profile.glsl"
+
+// Per-frame scene state: ComputePipeline's ring holds one slot per frame in flight and the
+// push constant camera.scene_slot picks this frame's. Must match SceneUniforms in
+// compute_pipeline.cpp.
+struct SceneState {
+    mat4 cameraToWorld;   // rotation in columns 0-2, camera position in column 3
+    vec4 lens;            // x: focal length of the (uv, f) view ray
+    vec4 hole;            // x: Kerr a/M (unused for Schwarzschild)
+    vec4 disk;            // x: rotation speed, y: emission scale
+    vec4 tone;            // x: exposure, y: gamma, z: saturation, w: contrast
+};
+const int SCENE_SLOTS = 8;
+layout (std140, binding = 4) uniform SceneRing { SceneState scenes[SCENE_SLOTS]; };
+
+// Baked sky (SkyEnvironment): background() rendered once into a mipmapped cubemap, so an
+// escaped ray costs one filtered fetch. Off: background() per ray.
+layout (constant_id = 9) const bool SKY_CUBEMAP = false;
+layout (set = 2, binding = 0) uniform samplerCube skyMap;
+
+// Mip level for one sample's angular pitch at the view centre (ray = (uv, lens.x) with uv
+// steps of 1 / height, over samplesPerAxis samples). Lensing stretches or squeezes the
+// footprint; the unlensed pitch is a fair default. Set once per invocation by main().
+float skyLod = 0.0;
+
+void setSkyFootprint(float imageHeight, int samplesPerAxis) {
+    if (!SKY_CUBEMAP) return;
+    float sampleAngle = 1.0 / (scenes[camera.scene_slot].lens.x * imageHeight * float(samplesPerAxis));
+    float texelAngle = 1.5707963 / float(textureSize(skyMap, 0).x);
+    skyLod = max(log2(sampleAngle / texelAngle), 0.0);
+}
+
+vec4 sky(vec3 dir) {
+    return SKY_CUBEMAP ? textureLod(skyMap, dir, skyLod) : background(dir);
+}
+
+// Baked disk (DiskTextures): the raymarch samples turbulence and the radial emission
+// table (disk_profile.glsl) instead of evaluating noise, sqrt and fades per step.
+layout (constant_id = 14) const bool DISK_TEXTURES = false;
+layout (set = 3, binding = 0) uniform sampler2D diskNoiseMap;    // r: turbulence
+layout (set = 3, binding = 1) uniform sampler2D diskEmissionMap; // rgb: redshift, a: fade
+
+hvec3 applyGravitationalRedshift(hvec3 color, vec3 shift) {
+    return clamp(color * hvec3(shift), H(0.0), H(2.0));
+}
+
+vec4 raymarchDisk(vec3 ray, vec3 zeroPos, float iTime) {
+    float steps = float(DISK_STEPS);
+    vec3 position = zeroPos;
+    float lengthPos = length(position.xz);
+    float dist = min(1.0, lengthPos*(1.0/Rs) * 0.5) * Rs * 0.4 * (1.0/steps) / abs(ray.y);
+
+    position += dist * steps * ray * 0.5;
+
+    vec2 deltaPos;
+    deltaPos.x = -zeroPos.z*0.01 + zeroPos.x;
+    deltaPos.y = zeroPos.x*0.01 + zeroPos.z;
+    deltaPos = normalize(deltaPos - zeroPos.xz);
+
+    float parallel = dot(ray.xz, deltaPos);
+    parallel /= sqrt(lengthPos);
+    parallel *= 0.5;
+    float redShift = parallel + 0.3;
+    redShift *= redShift;
+    redShift = clamp(redShift, 0.0, 1.0);
+
+    float disMix = clamp((lengthPos - Rs * 2.0) * (1.0/Rs) * 0.24, 0.0, 1.0);
+    hvec3 insideCol = mix(hvec3(1.0, 0.8, 0.0), hvec3(0.5, 0.13, 0.02) * H(0.2), hfloat(disMix));
+
+    insideCol *= mix(hvec3(0.4, 0.2, 0.1), hvec3(1.6, 2.4, 4.0), hfloat(redShift));
+    insideCol *= H(1.25);
+    redShift += 0.12;
+    redShift *= redShift;
+
+    hvec4 o = hvec4(0.0);
+
+    // The disk's rotation is the same for every step
+    float rot = mod(iTime * scenes[camera.scene_slot].disk.x, 8192.0);
+    float sinRot = sin(rot);
+    float cosRot = cos(rot);
+
+    for (float i = 0.0; i < steps; i += 1.0) {
+        position -= dist * ray;
+
+        float intensity = clamp(1.0 - abs((i - 0.8) * (1.0/steps) * 2.0), 0.0, 1.0);
+        float lengthPos2 = length(position.xz);
+
+        float distMult;
+        vec3 shift;
+        if (DISK_TEXTURES) {
+            vec4 emission = textureLod(diskEmissionMap, vec2(lengthPos2 / DISK_EMISSION_R, 0.5), 0.0);
+            shift = emission.rgb;
+            distMult = emission.a;
+        } else {
+            shift = diskRedshift(lengthPos2);
+            distMult = diskFade(lengthPos2);
+        }
+
+        float u = lengthPos2 + iTime * Rs * 0.3 + intensity * Rs * 0.2;
+
+        vec2 xy;
+        xy.x = -position.z * sinRot + position.x * cosRot;
+        xy.y = position.x * sinRot + position.z * cosRot;
+
+        float x = abs(xy.x / xy.y);
+        float angle = 0.02 * atan(x);
+
+        vec2 noisePos = vec2(angle, u * (1.0/Rs) * 0.05);
+        hfloat noise;
+        if (DISK_TEXTURES) {
+            // The radius coordinate wraps (REPEAT); the time scroll is part of u
+            noise = hfloat(textureLod(diskNoiseMap, noisePos * DISK_NOISE_FREQ / DISK_NOISE_CELLS, 0.0).r);
+        } else {
+            noise = value(noisePos, DISK_NOISE_FREQ);
+            noise = noise * H(0.66) + H(0.33) * value(noisePos, DISK_NOISE_FREQ * 2.0);
+        }
+
+        hfloat extraWidth = noise * hfloat(1.0 - clamp(i * (1.0/steps) * 2.0 - 1.0, 0.0, 1.0));
+
+        // Geometric factor first, in fp32: dist * distMult can be small
+        hfloat density = hfloat(((1.0/Rs) * 10.0 + 0.01) * dist * distMult);
+        hfloat alpha = clamp(noise * (hfloat(intensity) + extraWidth) * density, H(0.0), H(1.0));
+
+        hvec3 col = H(2.0) * mix(hvec3(0.3, 0.2, 0.15) * insideCol, insideCol, hfloat(min(1.0, intensity * 2.0)));
+
+        col = applyGravitationalRedshift(col, shift);
+
+        o = clamp(hvec4(col * alpha + o.rgb * (H(1.0) - alpha), o.a * (H(1.0) - alpha) + alpha), hvec4(0.0), hvec4(1.0));
+
+        float lengthPos3 = lengthPos2 * (1.0/Rs);
+        o.rgb += hfloat(redShift * (intensity * 1.0 + 0.5) * (1.0/steps) * 100.0 * distMult / (lengthPos3 * lengthPos3));
+    }
+
+    o.rgb = clamp(o.rgb - H(0.005), H(0.0), H(1.0));
+    return vec4(vec3(o.rgb) * scenes[camera.scene_slot].disk.y, o.a);
+}
+
+vec3 linearToSrgb(vec3 c) {
+    vec3 lo = c * 12.92;
+    vec3 hi = 1.055 * pow(c, vec3(1.0 / 2.4)) - 0.055;
+    return mix(hi, lo, lessThanEqual(c, vec3(0.0031308)));
+}
+
+// Simple saturation and contrast adjustment
+vec3 adjustSaturationContrast(vec3 color, float saturation, float contrast) {
+    float lum = dot(color, vec3(0.2126, 0.7152, 0.0722));
+    vec3 gray = vec3(lum);
+    vec3 satColor = mix(gray, color, saturation);
+    vec3 contrasted = (satColor - 0.5) * contrast + 0.5;
+    return clamp(contrasted, 0.0, 1.0);
+}
+
+void compositeDisk(inout vec4 diskColor, vec4 disk) {
+    diskColor = vec4(
+    disk.rgb * (1.0 - diskColor.a) + diskColor.rgb,
+    diskColor.a + disk.a * (1.0 - diskColor.a)
+    );
+}
+
+vec4 shadeCaptured(vec4 diskColor, vec3 glow, float r) {
+    if (DEBUG_VIEW == 1) return vec4(diskColor.a, 0.0, 0.0, 1.0);
+    if (DEBUG_VIEW == 2) return vec4(0.0, 0.0, 0.0, 1.0);
+
+    float fade = smoothstep(Rs * 0.9, Rs * 1.2, r);
+    float darkness = mix(0.08, 1.0, fade);
+
+    vec3 shadowMix = (diskColor.rgb * diskColor.a + glow * (1.0 - diskColor.a)) * darkness;
+
+    shadowMix *= vec3(0.9, 0.85, 0.8);
+
+    return vec4(shadowMix, 1.0);
+}
+
+vec4 shadeEscaped(vec4 diskColor, vec3 glow, vec3 dir) {
+    if (DEBUG_VIEW == 1) return vec4(diskColor.a, 1.0 - diskColor.a, 0.0, 1.0);
+    if (DEBUG_VIEW == 2) return vec4(normalize(dir) * 0.5 + 0.5, 1.0);
+
+    vec4 bg = sky(normalize(dir));
+    return vec4(diskColor.rgb * diskColor.a + bg.rgb * (1.0 - diskColor.a) + glow * (1.0 - diskColor.a), 1.0);
+}
+
+// Step limit reached before the ray was captured or escaped
+vec4 shadeUnresolved(vec4 diskColor, vec3 glow, vec3 dir) {
+    if (DEBUG_VIEW == 1) return vec4(diskColor.a, 0.0, 1.0, 1.0);
+    if (DEBUG_VIEW == 2) return vec4(normalize(dir) * 0.5 + 0.5, 1.0);
+
+    vec4 bg = sky(normalize(dir));
+    return vec4(diskColor.rgb * diskColor.a + (1.0 - diskColor.a) * bg.rgb + glow, 1.0);
+}
+
+// Escape test for the integration loops: past the interaction radius and heading out
+// means no further interaction, so the remaining bend is resolved in closed form.
+// Kerr rays leave in the Schwarzschild weak-field approximation (spin terms fall off faster).
+bool hasEscaped(Photon photon, float r) {
+    if (FAR_FIELD_R > 0.0) return r > FAR_FIELD_R && photonOutgoing(photon);
+    return r > ESCAPE_R;
+}
+
+vec3 escapeDirection(Photon photon) {
+    vec3 dir = photonDirection(photon);
+    return (FAR_FIELD_R > 0.0) ? asymptoticDirection(photonPosition(photon), dir) : dir;
+}
+
+// Camera ray through image position p (in pixels; pixel (x, y) covers [x, x + 1) x [y, y + 1))
+void cameraRay(vec2 p, vec2 iResolution, out vec3 pos, out vec3 ray) {
+    vec2 uv = (p - iResolution * 0.5) / iResolution.y;
+    mat4 view = scenes[camera.scene_slot].cameraToWorld;
+    ray = mat3(view) * normalize(vec3(uv, scenes[camera.scene_slot].lens.x));
+    pos = view[3].xyz;
+}
+
+// Camera ray for sample (i, j) of an n x n grid (n = AA, or 1 for a block the
+// classification pre-pass found simple) in the full-image pixel fragCoord. Jitter is
+// seeded by the pixel and time, so tiles and wavefront slices match a plain frame.
+void primaryRay(vec2 fragCoord, vec2 iResolution, ivec2 sampleIndex, int samplesPerAxis, float iTime,
+                out vec3 pos, out vec3 ray) {
+    float seed = hash2(fragCoord + vec2(sampleIndex) + vec2(iTime));
+    vec2 jitter = vec2(seed, hash(seed + 13.37)) / float(samplesPerAxis);
+
+    cameraRay(fragCoord + (vec2(sampleIndex) + jitter) / float(samplesPerAxis), iResolution, pos, ray);
+}
+
+// Tone mapping with extra saturation and contrast (the scene's tone); debug views stay linear
+vec4 toneMap(vec4 col) {
+    if (DEBUG_VIEW == 0) {
+        vec4 tone = scenes[camera.scene_slot].tone;
+        col.rgb = pow(col.rgb, vec3(tone.y));
+        col.rgb = adjustSaturationContrast(col.rgb, tone.z, tone.w);
+        col.rgb *= tone.x;
+    }
+    col.rgb = clamp(col.rgb, 0.0, 1.0);
+    return col;
+}
@@ -0,0 +1,78 @@
+#include "camera_path.h"
+
+#include <stdexcept>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+
+namespace {
+    float catmullRom(float p0, float p1, float p2, float p3, float t) {
+        const float t2 = t * t;
+        const float t3 = t2 * t;
+        return 0.5f * ((2.0f * p1) + (-p0 + p2) * t
+                     + (2.0f * p0 - 5.0f * p1 + 4.0f * p2 - p3) * t2
+                     + (-p0 + 3.0f * p1 - 3.0f * p2 + p3) * t3);
+    }
+}
+
+CameraPath::CameraPath(std::vector<Keyframe> keyframes) : keys(std::move(keyframes)) {
+    if (keys.empty()) throw std::runtime_error("[CameraPath] Path needs at least one keyframe.");
+    for (size_t i = 1; i < keys.size(); ++i) {
+        if (keys[i].time <= keys[i - 1].time)
+            throw std::runtime_error("[CameraPath] Keyframe times must be strictly increasing.");
+    }
+}
+
+CameraPath CameraPath::load(const std::string& path) {
+    std::ifstream file(path);
+    if (!file) throw std::runtime_error("[CameraPath] Failed to open camera path: " + path);
+
+    std::vector<Keyframe> keys;
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(file, line)) {
+        ++lineNumber;
+        const size_t first = line.find_first_not_of(" \t\r");
+        if (first == std::string::npos || line[first] == '#') continue;
+
+        std::istringstream in(line);
+        Keyframe k;
+        if (!(in >> k.time >> k.x >> k.y >> k.zoom)) {
+            throw std::runtime_error("[CameraPath] " + path + ":" + std::to_string(lineNumber)
+                                     + ": expected \"time x y zoom\".");
+        }
+        keys.push_back(k);
+    }
+    return CameraPath(std::move(keys));
+}
+
+CameraPath CameraPath::defaultFlyThrough() {
+    return CameraPath({
+        {  0.0f,     0.0f,    0.0f, 1.00f },
+        {  4.0f,   600.0f, -120.0f, 0.85f },
+        {  8.0f,  1400.0f, -260.0f, 0.70f },
+        { 12.0f,  2400.0f, -200.0f, 0.80f },
+    });
+}
+
+CameraPath::Keyframe CameraPath::sample(float time) const {
+    if (keys.size() == 1 || time <= keys.front().time) return keys.front();
+    if (time >= keys.back().time) return keys.back();
+
+    const auto upper = std::upper_bound(keys.begin(), keys.end(), time,
+                                        [](float t, const Keyframe& k) { return t < k.time; });
+    const size_t i1 = static_cast<size_t>(upper - keys.begin()) - 1;
+    const size_t i2 = i1 + 1;
+    const size_t i0 = i1 > 0 ? i1 - 1 : i1;
+    const size_t i3 = std::min(i2 + 1, keys.size() - 1);
+
+    const float t = (time - keys[i1].time) / (keys[i2].time - keys[i1].time);
+
+    Keyframe out;
+    out.time = time;
+    out.x    = catmullRom(keys[i0].x,    keys[i1].x,    keys[i2].x,    keys[i3].x,    t);
+    out.y    = catmullRom(keys[i0].y,    keys[i1].y,    keys[i2].y,    keys[i3].y,    t);
+    out.zoom = catmullRom(keys[i0].zoom, keys[i1].zoom, keys[i2].zoom, keys[i3].zoom, t);
+    out.zoom = std::max(out.zoom, 0.2f);   // spline overshoot must not put the camera inside the photon sphere
+    return out;
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include <string>
+#include <vector>
+
+/**
+ * CameraPath
+ * ==========
+ * Scripted camera for offline (headless) renders: keyframes of time, orbit pan
+ * (x, y, same units as the interactive camera) and zoom, interpolated with a
+ * Catmull-Rom spline so fly-throughs have no velocity kinks at the keys.
+ *
+ * File format: one keyframe per line, "time x y zoom", times increasing.
+ * Blank lines and lines starting with '#' are ignored.
+ */
+class CameraPath {
+public:
+    struct Keyframe {
+        float time = 0.0f;
+        float x    = 0.0f;
+        float y    = 0.0f;
+        float zoom = 1.0f;
+    };
+
+    explicit CameraPath(std::vector<Keyframe> keys);
+
+    static CameraPath load(const std::string& path);
+    static CameraPath defaultFlyThrough();   // slow pan and push-in, ~12 s
+
+    // Clamped to the first/last key outside the path's time range
+    Keyframe sample(float time) const;
+    float    duration() const { return keys.back().time - keys.front().time; }
+    float    startTime() const { return keys.front().time; }
+
+private:
+    std::vector<Keyframe> keys;
+};
@@ -0,0 +1,53 @@
+#include "image_io.h"
+
+#include <stdexcept>
+#include <fstream>
+#include <filesystem>
+
+namespace image_io {
+
+void rgbaToRgb(const uint8_t* rgba, uint8_t* rgb, size_t pixels) {
+    for (size_t i = 0; i < pixels; ++i) {
+        rgb[i * 3 + 0] = rgba[i * 4 + 0];
+        rgb[i * 3 + 1] = rgba[i * 4 + 1];
+        rgb[i * 3 + 2] = rgba[i * 4 + 2];
+    }
+}
+
+void writePpm(const std::string& path, const uint8_t* rgb, uint32_t width, uint32_t height) {
+    const std::string tmp = path + ".tmp";
+    {
+        std::ofstream file(tmp, std::ios::binary | std::ios::trunc);
+        if (!file) throw std::runtime_error("[ImageIO] Failed to open output image: " + tmp);
+        file << "P6\n" << width << " " << height << "\n255\n";
+        file.write(reinterpret_cast<const char*>(rgb),
+                   static_cast<std::streamsize>(static_cast<size_t>(width) * height * 3));
+        if (!file) throw std::runtime_error("[ImageIO] Failed to write output image: " + tmp);
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(tmp, path, ec);
+    if (ec) throw std::runtime_error("[ImageIO] Failed to move " + tmp + " to " + path + ": " + ec.message());
+}
+
+bool readPpm(const std::string& path, std::vector<uint8_t>& rgb, uint32_t& width, uint32_t& height) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) return false;
+
+    std::string magic;
+    uint32_t w = 0, h = 0, maxValue = 0;
+    file >> magic >> w >> h >> maxValue;
+    if (!file || magic != "P6" || maxValue != 255 || w == 0 || h == 0) return false;
+    file.get();   // single whitespace after the header
+
+    std::vector<uint8_t> data(static_cast<size_t>(w) * h * 3);
+    file.read(reinterpret_cast<char*>(data.data()), static_cast<std::streamsize>(data.size()));
+    if (file.gcount() != static_cast<std::streamsize>(data.size())) return false;
+
+    rgb = std::move(data);
+    width = w;
+    height = h;
+    return true;
+}
+
+}
@@ -0,0 +1,16 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Minimal binary PPM (P6, 8-bit RGB) I/O for offline renders and resumable stills.
+namespace image_io {
+    void rgbaToRgb(const uint8_t* rgba, uint8_t* rgb, size_t pixels);
+
+    // Writes to path + ".tmp" and renames, so a crash never leaves a truncated image behind
+    void writePpm(const std::string& path, const uint8_t* rgb, uint32_t width, uint32_t height);
+
+    // False if the file is missing, not a P6/255 image, or truncated
+    bool readPpm(const std::string& path, std::vector<uint8_t>& rgb, uint32_t& width, uint32_t& height);
+}
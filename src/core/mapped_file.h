@@ -0,0 +1,39 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ * MappedFile
+ * ==========
+ * Read-only memory mapping of a whole file (mmap / MapViewOfFile). SPIR-V and
+ * pipeline-cache blobs are handed to Vulkan straight from the page cache, with
+ * no copy through a stream. The view is page-aligned, so it is valid as pCode.
+ */
+class MappedFile {
+public:
+    MappedFile() = default;
+    explicit MappedFile(const std::string& path);   // throws if missing, empty or unmappable
+    ~MappedFile();
+
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // Like the constructor, but an empty MappedFile instead of an exception
+    static MappedFile tryOpen(const std::string& path);
+
+    const uint8_t* data()  const { return static_cast<const uint8_t*>(view); }
+    size_t         size()  const { return length; }
+    bool           empty() const { return length == 0; }
+
+private:
+    void release() noexcept;
+
+    const void* view   = nullptr;
+    size_t      length = 0;
+#ifdef _WIN32
+    void*       mapping = nullptr;   // HANDLE of the file mapping object
+#endif
+};
@@ -3,11 +3,32 @@
 #include <iostream>
 #include <stdexcept>
 #include <vector>
+#include <string>
+#include <cstring>
+#include <cstdlib>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <algorithm>
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <filesystem>
+#include <iomanip>
 
 #include "core/window.h"
+#include "core/camera_path.h"
+#include "core/image_io.h"
 #include "renderer/vulkan_context.h"
 #include "renderer/swapchain.h"
 #include "renderer/compute_pipeline.h"
+#include "renderer/frame_scheduler.h"
+#include "renderer/offscreen_target.h"
+#include "renderer/frame_readback.h"
+#include "renderer/tiled_renderer.h"
+#include "renderer/present_pacer.h"
+#include "renderer/benchmark.h"
+#include "reference/reference_tracer.h"
 
 #ifndef GARGANTUA_SHADER_DIR
 #define GARGANTUA_SHADER_DIR "."
@@ -31,8 +52,33 @@ struct Camera {
 
 static Camera camera;
 
+// Runtime shader variant: 1-4 pick a quality preset, V cycles the debug views, G toggles the disk;
+// T re-runs the workgroup benchmark; [ and ] change the Kerr spin
+static TraceVariant requestedVariant;
+static bool         variantRequested = false;
+static bool         autotuneRequested = false;
+static float        spinChange = 0.0f;
+
+// First camera input not yet sampled by a frame (input-to-present latency, PresentPacer)
+static bool                                  inputPending = false;
+static std::chrono::steady_clock::time_point inputTime;
+
 static void keyCallback(GLFWwindow* window, int key, int scancode, int action, int mods) {
+    if (action == GLFW_PRESS) {
+        const TraceVariant before = requestedVariant;
+        if (key >= GLFW_KEY_1 && key <= GLFW_KEY_4) {
+            requestedVariant = requestedVariant.withPreset(static_cast<QualityPreset>(key - GLFW_KEY_1));
+            std::cout << "[Main] Quality: " << qualityPresetName(static_cast<QualityPreset>(key - GLFW_KEY_1)) << "\n";
+        }
+        if (key == GLFW_KEY_V) {
+            requestedVariant.debugView = static_cast<DebugView>((static_cast<int32_t>(requestedVariant.debugView) + 1) % 4);
+        }
+        if (key == GLFW_KEY_G) requestedVariant.disk = !requestedVariant.disk;
+        if (key == GLFW_KEY_T) autotuneRequested = true;
+        variantRequested = variantRequested || !(requestedVariant == before);
+    }
     if (action == GLFW_PRESS || action == GLFW_REPEAT) {
+        const Camera before = camera;
         float speed = 5000.0f;
         if (key == GLFW_KEY_W) camera.y += speed;
         if (key == GLFW_KEY_S) camera.y -= speed;
@@ -41,13 +87,477 @@ static void keyCallback(GLFWwindow* window, int key, int scancode, int action, i
         if (key == GLFW_KEY_Q) camera.zoom *= 1.1f;
         if (key == GLFW_KEY_E) camera.zoom *= 0.9f;
         if (key == GLFW_KEY_R) { camera.x = 0; camera.y = 0; camera.zoom = 1.0f; }
+        if (key == GLFW_KEY_LEFT_BRACKET)  spinChange -= 0.05f;
+        if (key == GLFW_KEY_RIGHT_BRACKET) spinChange += 0.05f;
+        const bool moved = camera.x != before.x || camera.y != before.y || camera.zoom != before.zoom;
+        if (moved && !inputPending) {
+            inputPending = true;
+            inputTime = std::chrono::steady_clock::now();
+        }
+    }
+}
+
+// Offline rendering without a window: --headless [frames] and its companions
+struct HeadlessSettings {
+    bool        enabled    = false;
+    uint32_t    frameCount = 0;          // 0: the whole camera path
+    uint32_t    width      = 1920;
+    uint32_t    height     = 1080;
+    float       fps        = 30.0f;
+    uint32_t    ringSize   = 6;          // readback buffers queued for the writer thread
+    std::string outputDir  = "frames";
+    std::string cameraPath;              // empty: CameraPath::defaultFlyThrough()
+    uint32_t    gpuCount   = 1;          // --gpus: 0 uses every suitable device
+
+    // --still <file.ppm>: one tiled image at --size instead of a sequence
+    std::string stillPath;
+    uint32_t    tileSize          = 512;
+    float       stillTime         = 0.0f;    // camera path time (and shader time) of the still
+    float       checkpointSeconds = 30.0f;
+    bool        resume            = true;
+
+    // --benchmark: canned scenarios with GPU timestamps instead of images
+    bool              benchmark = false;
+    BenchmarkSettings benchmarkSettings;
+
+    // --reference <file.ppm>: the still traced on the CPU (ReferenceTracer), no GPU needed
+    std::string referencePath;
+    std::string comparePath;               // --compare <file.ppm>: a GPU render to diff against it
+    float       comparePsnr        = 0.0f; // --compare-psnr: fail below this many dB; 0 only reports
+    uint32_t    referenceSubsteps  = 1;
+    uint32_t    referenceThreads   = 0;    // 0: every hardware thread
+    bool        referenceSimd      = true;
+};
+
+// Interactive presentation: --present-mode and --low-latency [frames]
+struct WindowSettings {
+    SwapchainOptions swapchain;
+    bool             lowLatency = false;
+    uint32_t         maxQueuedPresents = 1;   // presents allowed to wait for display when input is sampled
+};
+
+static ComputePipelineOptions parseOptions(int argc, char** argv, HeadlessSettings& headless,
+                                           WindowSettings& windowed) {
+    ComputePipelineOptions options;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--headless") == 0) {
+            headless.enabled = true;
+            // Optional frame count
+            if (i + 1 < argc && argv[i + 1][0] != '-') {
+                headless.frameCount = static_cast<uint32_t>(std::atoi(argv[++i]));
+            }
+        } else if (std::strcmp(argv[i], "--still") == 0 && i + 1 < argc) {
+            headless.enabled = true;
+            headless.stillPath = argv[++i];
+        } else if (std::strcmp(argv[i], "--benchmark") == 0) {
+            headless.enabled = true;
+            headless.benchmark = true;
+            // Optional comma-separated scenario names
+            if (i + 1 < argc && argv[i + 1][0] != '-') {
+                std::string list = argv[++i];
+                for (size_t start = 0; start <= list.size();) {
+                    const size_t end = std::min(list.find(',', start), list.size());
+                    if (end > start) headless.benchmarkSettings.scenarios.push_back(list.substr(start, end - start));
+                    start = end + 1;
+                }
+            }
+        } else if (std::strcmp(argv[i], "--benchmark-frames") == 0 && i + 1 < argc) {
+            headless.benchmarkSettings.frames = static_cast<uint32_t>(std::max(std::atoi(argv[++i]), 1));
+        } else if (std::strcmp(argv[i], "--benchmark-warmup") == 0 && i + 1 < argc) {
+            headless.benchmarkSettings.warmupFrames = static_cast<uint32_t>(std::max(std::atoi(argv[++i]), 0));
+        } else if (std::strcmp(argv[i], "--benchmark-out") == 0 && i + 1 < argc) {
+            headless.benchmarkSettings.outputPath = argv[++i];
+        } else if (std::strcmp(argv[i], "--reference") == 0 && i + 1 < argc) {
+            headless.enabled = true;
+            headless.referencePath = argv[++i];
+        } else if (std::strcmp(argv[i], "--compare") == 0 && i + 1 < argc) {
+            headless.comparePath = argv[++i];
+        } else if (std::strcmp(argv[i], "--compare-psnr") == 0 && i + 1 < argc) {
+            headless.comparePsnr = static_cast<float>(std::atof(argv[++i]));
+        } else if (std::strcmp(argv[i], "--reference-substeps") == 0 && i + 1 < argc) {
+            headless.referenceSubsteps = static_cast<uint32_t>(std::max(std::atoi(argv[++i]), 1));
+        } else if (std::strcmp(argv[i], "--reference-threads") == 0 && i + 1 < argc) {
+            headless.referenceThreads = static_cast<uint32_t>(std::max(std::atoi(argv[++i]), 0));
+        } else if (std::strcmp(argv[i], "--reference-scalar") == 0) {
+            headless.referenceSimd = false;
+        } else if (std::strcmp(argv[i], "--tile-size") == 0 && i + 1 < argc) {
+            headless.tileSize = static_cast<uint32_t>(std::max(std::atoi(argv[++i]), 16));
+        } else if (std::strcmp(argv[i], "--time") == 0 && i + 1 < argc) {
+            headless.stillTime = static_cast<float>(std::atof(argv[++i]));
+        } else if (std::strcmp(argv[i], "--checkpoint") == 0 && i + 1 < argc) {
+            headless.checkpointSeconds = static_cast<float>(std::atof(argv[++i]));
+        } else if (std::strcmp(argv[i], "--no-resume") == 0) {
+            headless.resume = false;
+        } else if (std::strcmp(argv[i], "--out") == 0 && i + 1 < argc) {
+            headless.outputDir = argv[++i];
+        } else if (std::strcmp(argv[i], "--camera-path") == 0 && i + 1 < argc) {
+            headless.cameraPath = argv[++i];
+        } else if (std::strcmp(argv[i], "--fps") == 0 && i + 1 < argc) {
+            headless.fps = std::max(static_cast<float>(std::atof(argv[++i])), 1.0f);
+        } else if (std::strcmp(argv[i], "--gpus") == 0 && i + 1 < argc) {
+            headless.gpuCount = static_cast<uint32_t>(std::max(std::atoi(argv[++i]), 0));
+        } else if (std::strcmp(argv[i], "--readback-ring") == 0 && i + 1 < argc) {
+            headless.ringSize = std::max(std::atoi(argv[++i]), 1);
+        } else if (std::strcmp(argv[i], "--size") == 0 && i + 1 < argc) {
+            unsigned w = 0, h = 0;
+            if (std::sscanf(argv[++i], "%ux%u", &w, &h) == 2 && w > 0 && h > 0) {
+                headless.width = w;
+                headless.height = h;
+            } else {
+                std::cerr << "[Main] Ignoring malformed --size (expected WxH): " << argv[i] << "\n";
+            }
+        } else if (std::strcmp(argv[i], "--present-mode") == 0 && i + 1 < argc) {
+            if (!parsePresentMode(argv[++i], windowed.swapchain.presentMode)) {
+                std::cerr << "[Main] Ignoring unknown --present-mode (immediate|mailbox|fifo|fifo-relaxed): "
+                          << argv[i] << "\n";
+            }
+        } else if (std::strcmp(argv[i], "--low-latency") == 0) {
+            windowed.lowLatency = true;
+            // Optional number of presents that may be queued
+            if (i + 1 < argc && argv[i + 1][0] != '-') {
+                windowed.maxQueuedPresents = static_cast<uint32_t>(std::max(std::atoi(argv[++i]), 1));
+            }
+        } else if (std::strcmp(argv[i], "--dynamic-res") == 0) {
+            options.dynamicResolution = true;
+            // Optional GPU budget in milliseconds
+            if (i + 1 < argc && argv[i + 1][0] != '-') {
+                options.targetFrameMs = static_cast<float>(std::atof(argv[++i]));
+            }
+        } else if (std::strcmp(argv[i], "--rk45") == 0) {
+            options.integrator = GeodesicIntegrator::DormandPrince;
+            // Optional local error tolerance
+            if (i + 1 < argc && argv[i + 1][0] != '-') {
+                options.integratorTolerance = static_cast<float>(std::atof(argv[++i]));
+            }
+        } else if (std::strcmp(argv[i], "--kerr") == 0) {
+            options.metric = GeodesicMetric::Kerr;
+            // Optional spin a/M
+            if (i + 1 < argc && (argv[i + 1][0] != '-' || std::isdigit(static_cast<unsigned char>(argv[i + 1][1])))) {
+                options.spin = static_cast<float>(std::atof(argv[++i]));
+            }
+        } else if (std::strcmp(argv[i], "--far-field") == 0 && i + 1 < argc) {
+            options.farFieldRadius = static_cast<float>(std::atof(argv[++i]));   // 0 disables
+        } else if (std::strcmp(argv[i], "--profile") == 0) {
+            options.profiling = true;
+        } else if (std::strcmp(argv[i], "--profile-stats") == 0) {
+            options.profiling = true;
+            options.pipelineStatistics = true;
+        } else if (std::strcmp(argv[i], "--ray-stats") == 0) {
+            options.profiling = true;
+            options.rayStatistics = true;
+        } else if (std::strcmp(argv[i], "--lut") == 0) {
+            options.deflectionLut = true;
+        } else if (std::strcmp(argv[i], "--quality") == 0 && i + 1 < argc) {
+            QualityPreset quality{};
+            if (parseQualityPreset(argv[++i], quality)) {
+                options.variant = options.variant.withPreset(quality);
+            } else {
+                std::cerr << "[Main] Ignoring unknown --quality (low|medium|high|ultra): " << argv[i] << "\n";
+            }
+        } else if (std::strcmp(argv[i], "--debug-view") == 0 && i + 1 < argc) {
+            if (!parseDebugView(argv[++i], options.variant.debugView)) {
+                std::cerr << "[Main] Ignoring unknown --debug-view (none|fate|direction|steps): " << argv[i] << "\n";
+            }
+        } else if (std::strcmp(argv[i], "--fp32-shading") == 0) {
+            options.halfShading = false;
+        } else if (std::strcmp(argv[i], "--wavefront") == 0) {
+            options.wavefront = true;
+        } else if (std::strcmp(argv[i], "--classify") == 0) {
+            options.blockClassification = true;
+        } else if (std::strcmp(argv[i], "--adaptive") == 0) {
+            options.adaptiveSampling = true;
+            // Optional luminance-range threshold
+            if (i + 1 < argc && argv[i + 1][0] != '-') {
+                options.adaptiveThreshold = static_cast<float>(std::atof(argv[++i]));
+            }
+        } else if (std::strcmp(argv[i], "--sky-size") == 0 && i + 1 < argc) {
+            options.skyFaceSize = static_cast<uint32_t>(std::max(std::atoi(argv[++i]), 0));   // 0: procedural
+        } else if (std::strcmp(argv[i], "--procedural-disk") == 0) {
+            options.diskTextures = false;
+        } else if (std::strcmp(argv[i], "--autotune") == 0) {
+            options.workgroupTuning = WorkgroupTuning::Force;
+        } else if (std::strcmp(argv[i], "--no-autotune") == 0) {
+            options.workgroupTuning = WorkgroupTuning::Off;
+        } else if (std::strcmp(argv[i], "--workgroup") == 0 && i + 1 < argc) {
+            unsigned w = 0, h = 0;
+            if (std::sscanf(argv[++i], "%ux%u", &w, &h) == 2 && w > 0 && h > 0) {
+                options.variant.groupWidth = w;
+                options.variant.groupHeight = h;
+                options.workgroupTuning = WorkgroupTuning::Off;
+            } else {
+                std::cerr << "[Main] Ignoring malformed --workgroup (expected WxH): " << argv[i] << "\n";
+            }
+        } else if (std::strcmp(argv[i], "--no-disk") == 0) {
+            options.variant.disk = false;
+        } else if (std::strcmp(argv[i], "--no-temporal") == 0) {
+            options.temporalAccumulation = false;   // back to 2x2 supersampling every frame
+        } else {
+            std::cerr << "[Main] Ignoring unknown argument: " << argv[i] << "\n";
+        }
     }
+    return options;
+}
+
+// One headless context per GPU, best device first; requestedCount 0 takes all of them
+static std::vector<std::unique_ptr<VulkanContext>> createHeadlessContexts(uint32_t requestedCount) {
+    std::vector<std::unique_ptr<VulkanContext>> contexts;
+    contexts.push_back(std::make_unique<VulkanContext>(true, VK_NULL_HANDLE, true, 0));
+
+    const uint32_t available = contexts.front()->getSuitableDeviceCount();
+    const uint32_t count = requestedCount == 0 ? available : std::min(requestedCount, available);
+    if (requestedCount > available) {
+        std::cerr << "[Main] Only " << available << " suitable GPU(s); using " << count << "\n";
+    }
+    for (uint32_t i = 1; i < count; ++i) {
+        contexts.push_back(std::make_unique<VulkanContext>(true, VK_NULL_HANDLE, true, static_cast<int>(i)));
+    }
+    return contexts;
+}
+
+// Renders a single poster-size still tile by tile (resumable), with no window.
+static int runStill(const ComputePipelineOptions& options, const HeadlessSettings& settings) {
+    const size_t MAX_FRAMES = 3;
+
+    const auto contexts = createHeadlessContexts(settings.gpuCount);
+    std::vector<VulkanContext*> devices;
+    for (const auto& context : contexts) devices.push_back(context.get());
+
+    TiledRenderSettings tiled;
+    tiled.imageSize = VkExtent2D{ settings.width, settings.height };
+    tiled.tileSize = settings.tileSize;
+    tiled.ringSize = settings.ringSize;
+    tiled.outputPath = settings.stillPath;
+    tiled.checkpointSeconds = settings.checkpointSeconds;
+    tiled.resume = settings.resume;
+
+    std::string shaderPath = std::string(GARGANTUA_SHADER_DIR) + "/gargantua.comp.spv";
+    TiledRenderer renderer(devices, static_cast<uint32_t>(MAX_FRAMES), shaderPath, options, tiled);
+
+    const CameraPath path = settings.cameraPath.empty() ? CameraPath::defaultFlyThrough()
+                                                        : CameraPath::load(settings.cameraPath);
+    const CameraPath::Keyframe key = path.sample(settings.stillTime);
+    renderer.render(CameraData{ key.x, key.y, key.zoom, settings.stillTime });
+    return 0;
+}
+
+// Times the canned benchmark scenarios on the best GPU and writes a JSON or CSV report.
+static int runBenchmark(const ComputePipelineOptions& options, const HeadlessSettings& settings) {
+    const size_t MAX_FRAMES = 3;
+
+    const auto contexts = createHeadlessContexts(1);
+
+    BenchmarkSettings benchmark = settings.benchmarkSettings;
+    benchmark.fps = settings.fps;
+
+    std::string shaderPath = std::string(GARGANTUA_SHADER_DIR) + "/gargantua.comp.spv";
+    Benchmark runner(*contexts.front(), static_cast<uint32_t>(MAX_FRAMES), shaderPath, options, benchmark);
+    runner.run(Benchmark::defaultScenarios(VkExtent2D{ settings.width, settings.height }));
+    return 0;
 }
 
-int main() {
+// Traces the still of --time and --size on the CPU and, with --compare, reports how far a GPU
+// render of the same still (--still with the same options) is from it.
+static int runReference(const ComputePipelineOptions& options, const HeadlessSettings& settings) {
+    if (options.metric != GeodesicMetric::Schwarzschild) {
+        throw std::runtime_error("[Reference] Only the Schwarzschild metric is traced on the CPU.");
+    }
+    if (options.variant.debugView != DebugView::None) {
+        throw std::runtime_error("[Reference] Debug views are not traced on the CPU.");
+    }
+
+    ReferenceSettings reference;
+    reference.width = settings.width;
+    reference.height = settings.height;
+    reference.samplesPerAxis = options.variant.samplesPerAxis;
+    reference.diskSteps = options.variant.diskSteps;
+    reference.glow = options.variant.glow;
+    reference.photonRing = options.variant.photonRing;
+    reference.geodesic.maxSteps = options.variant.maxSteps;
+    reference.geodesic.stepSize = options.variant.stepSize;
+    reference.geodesic.farFieldRadius = options.farFieldRadius;
+    reference.geodesic.disk = options.variant.disk;
+    reference.geodesic.substeps = settings.referenceSubsteps;
+    const SceneParams& scene = options.scene;
+    reference.scene = { scene.exposure, scene.gamma, scene.saturation, scene.contrast, scene.diskSpeed,
+                        scene.diskBrightness, scene.focalLength, scene.pitch, scene.orbitRate };
+    reference.threads = settings.referenceThreads;
+    reference.simd = settings.referenceSimd;
+
+    ReferenceTracer tracer(reference);
+
+    const CameraPath path = settings.cameraPath.empty() ? CameraPath::defaultFlyThrough()
+                                                        : CameraPath::load(settings.cameraPath);
+    const CameraPath::Keyframe key = path.sample(settings.stillTime);
+    std::cout << "[Reference] Tracing " << settings.width << "x" << settings.height << ", "
+              << reference.samplesPerAxis * reference.samplesPerAxis << " samples per pixel on "
+              << tracer.getThreadCount() << " thread(s), " << tracer.getKernelName() << " x"
+              << tracer.getKernelLanes() << " packets\n";
+
+    const std::vector<uint8_t> image = tracer.render(ReferenceView{ key.x, key.y, key.zoom, settings.stillTime });
+    image_io::writePpm(settings.referencePath, image.data(), settings.width, settings.height);
+
+    const double seconds = tracer.getLastSeconds();
+    const double samples = static_cast<double>(tracer.getLastSamples());
+    std::cout << std::fixed << std::setprecision(2) << "[Reference] Wrote " << settings.referencePath << " in "
+              << seconds << " s: " << (seconds > 0.0 ? samples / seconds / 1e6 : 0.0) << " Msamples/s, "
+              << std::setprecision(1) << static_cast<double>(tracer.getLastSteps()) / samples << " RK4 steps per sample\n";
+
+    if (settings.comparePath.empty()) return 0;
+
+    std::vector<uint8_t> gpu;
+    uint32_t width = 0, height = 0;
+    if (!image_io::readPpm(settings.comparePath, gpu, width, height)) {
+        throw std::runtime_error("[Reference] Failed to read " + settings.comparePath);
+    }
+    if (width != settings.width || height != settings.height) {
+        throw std::runtime_error("[Reference] " + settings.comparePath + " is " + std::to_string(width) + "x" +
+                                 std::to_string(height) + ", the reference " + std::to_string(settings.width) + "x" +
+                                 std::to_string(settings.height));
+    }
+
+    std::vector<uint8_t> diff;
+    const ImageDifference d = compareImages(image, gpu, 8, &diff);
+    const std::string diffPath = std::filesystem::path(settings.referencePath).replace_extension(".diff.ppm").string();
+    image_io::writePpm(diffPath, diff.data(), settings.width, settings.height);
+
+    std::cout << std::setprecision(2) << "[Reference] " << settings.comparePath << ": PSNR " << d.psnr << " dB, RMSE "
+              << d.rmse << ", mean " << d.meanAbs << ", max " << d.maxAbs << ", " << d.outliers * 100.0
+              << "% of pixels off by more than 8\n";
+    std::cout << "[Reference] Wrote the difference (x8) to " << diffPath << "\n";
+    if (settings.comparePsnr > 0.0f && d.psnr < settings.comparePsnr) {
+        std::cerr << "[Reference] PSNR is below the required " << settings.comparePsnr << " dB\n";
+        return -1;
+    }
+    return 0;
+}
+
+// Traces frames first, first + stride, ... of a camera path on one device (alternate-frame
+// rendering when several GPUs share a sequence). Frame indices, and so file names, are global.
+static uint32_t renderSequenceOnDevice(VulkanContext& context, const ComputePipelineOptions& options,
+                                       const HeadlessSettings& settings, const CameraPath& path,
+                                       uint32_t frameCount, uint32_t first, uint32_t stride,
+                                       std::atomic<uint32_t>& traced, const std::atomic<bool>& aborted) {
+    const size_t MAX_FRAMES = 3;
+    VkDevice device = context.getDevice();
+
+    FrameScheduler scheduler(context, static_cast<uint32_t>(MAX_FRAMES));
+    OffscreenTarget target(context, VkExtent2D{ settings.width, settings.height }, static_cast<uint32_t>(MAX_FRAMES));
+
+    std::string shaderPath = std::string(GARGANTUA_SHADER_DIR) + "/gargantua.comp.spv";
+    ComputePipeline compute(context, target, scheduler, shaderPath, options);
+
+    std::vector<VkSemaphore> tracedSems(MAX_FRAMES);
+    for (auto& sem : tracedSems) sem = createSemaphore(device);
+
+    uint32_t written = 0;
+    std::string error;
+    {
+        FrameReadback readback(context, scheduler, target.getExtent(), settings.ringSize, settings.outputDir);
+
+        try {
+            for (uint32_t i = first; i < frameCount && !aborted; i += stride) {
+                // Target image i % MAX_FRAMES is free once its previous trace and copy retired
+                const uint32_t slot = scheduler.beginFrame();
+
+                const float t = path.startTime() + static_cast<float>(i) / settings.fps;
+                const CameraPath::Keyframe key = path.sample(t);
+                CameraData camData{ key.x, key.y, key.zoom, t };
+
+                compute.dispatch(slot, VK_NULL_HANDLE, tracedSems[slot], camData);
+                readback.capture(target.getImage(slot), tracedSems[slot], i);
+
+                scheduler.endFrame();
+
+                const uint32_t done = ++traced;
+                if (done % 30 == 0 || done == frameCount) {
+                    std::cout << "[Headless] " << done << "/" << frameCount << " traced\n";
+                    if (options.profiling && compute.getProfiler()) compute.getProfiler()->report(std::cout);
+                }
+            }
+            readback.flush();
+        } catch (const std::exception& e) {
+            error = e.what();
+        }
+        written = readback.getFramesWritten();
+    }
+
+    scheduler.waitIdle();
+    for (auto sem : tracedSems) vkDestroySemaphore(device, sem, nullptr);
+    if (!error.empty()) throw std::runtime_error(error);
+    return written;
+}
+
+// Renders a camera path to numbered images with no window, surface or swapchain.
+// Tracing runs ahead of the disk: frames leave through FrameReadback's ring and writer thread.
+// With --gpus, every device renders every n-th frame on its own host thread.
+static int runHeadless(ComputePipelineOptions options, const HeadlessSettings& settings) {
+    // Every frame moves the camera, so history would reset anyway; supersample spatially
+    // instead, and keep a fixed resolution so every frame gets the same quality.
+    options.temporalAccumulation = false;
+    options.dynamicResolution = false;
+
+    const auto contexts = createHeadlessContexts(settings.gpuCount);
+    const uint32_t stride = static_cast<uint32_t>(contexts.size());
+
+    const CameraPath path = settings.cameraPath.empty() ? CameraPath::defaultFlyThrough()
+                                                        : CameraPath::load(settings.cameraPath);
+    const uint32_t frameCount = settings.frameCount
+        ? settings.frameCount
+        : static_cast<uint32_t>(path.duration() * settings.fps) + 1;
+
+    std::cout << "[Headless] Rendering " << frameCount << " frames at " << settings.width << "x"
+              << settings.height << ", " << settings.fps << " fps on " << stride << " GPU(s)\n";
+    const auto start = std::chrono::steady_clock::now();
+
+    std::atomic<uint32_t> traced{0};
+    std::atomic<uint32_t> written{0};
+    std::atomic<bool> aborted{false};
+    std::vector<std::string> errors(stride);
+    std::vector<std::thread> threads;
+    for (uint32_t d = 0; d < stride; ++d) {
+        threads.emplace_back([&, d] {
+            try {
+                written += renderSequenceOnDevice(*contexts[d], options, settings, path,
+                                                  frameCount, d, stride, traced, aborted);
+            } catch (const std::exception& e) {
+                errors[d] = e.what();
+                aborted = true;
+            }
+        });
+    }
+    for (auto& t : threads) t.join();
+
+    int result = 0;
+    for (const auto& e : errors) {
+        if (!e.empty()) { std::cerr << "\n[Error] " << e << "\n"; result = -1; }
+    }
+
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    std::cout << "[Headless] Wrote " << written.load() << " frames to " << settings.outputDir
+              << " in " << elapsed.count() << " s\n";
+    return result;
+}
+
+int main(int argc, char** argv) {
     std::cout << "Gargantua - Black Hole Raytracer\n";
     std::cout << "=================================\n";
-    std::cout << "Controls: WASD=Pan, Q/E=Zoom, R=Reset\n\n";
+
+    HeadlessSettings headless;
+    WindowSettings windowed;
+    const ComputePipelineOptions options = parseOptions(argc, argv, headless, windowed);
+
+    if (headless.enabled) {
+        try {
+            if (!headless.referencePath.empty()) return runReference(options, headless);
+            if (headless.benchmark) return runBenchmark(options, headless);
+            return headless.stillPath.empty() ? runHeadless(options, headless) : runStill(options, headless);
+        } catch (const std::exception& e) {
+            std::cerr << "\n[Error] " << e.what() << "\n";
+            return -1;
+        }
+    }
+
+    std::cout << "Controls: WASD=Pan, Q/E=Zoom, R=Reset, 1-4=Quality, V=Debug view, G=Disk\n\n";
 
     try {
         Window window(1920, 1080, "Gargantua - Black Hole Raytracer");
@@ -56,13 +566,22 @@ int main() {
         VkSurfaceKHR surface = window.createSurface(context.getInstance());
         context.initializeForSurface(surface);
 
-        Swapchain swapchain(context, window);
+        VkDevice device = context.getDevice();
+        const size_t MAX_FRAMES = 3;
+
+        // Before the swapchain: it retires old chains through the scheduler, which runs
+        // any still pending when it is destroyed after it
+        FrameScheduler scheduler(context, static_cast<uint32_t>(MAX_FRAMES));
+
+        Swapchain swapchain(context, window, scheduler, windowed.swapchain);
+        PresentPacer pacer(swapchain, windowed.maxQueuedPresents);
+        if (windowed.lowLatency && !pacer.isPacing()) {
+            std::cerr << "[Main] Warning: VK_KHR_present_wait unavailable; --low-latency only samples input late.\n";
+        }
 
         std::string shaderPath = std::string(GARGANTUA_SHADER_DIR) + "/gargantua.comp.spv";
-        ComputePipeline compute(context, swapchain, shaderPath);
+        ComputePipeline compute(context, swapchain, scheduler, shaderPath, options);
 
-        VkDevice device = context.getDevice();
-        const size_t MAX_FRAMES = 3;
         std::vector<VkSemaphore> imageAvailableSems(MAX_FRAMES);
         std::vector<VkSemaphore> renderFinishedSems(MAX_FRAMES);
 
@@ -71,8 +590,8 @@ int main() {
             renderFinishedSems[i] = createSemaphore(device);
         }
 
-        uint32_t currentFrame = 0;
-
+        // Start from what the pipeline settled on, including a tuned workgroup shape
+        requestedVariant = compute.getVariant();
         glfwSetKeyCallback(window.getHandle(), keyCallback);
 
         double fpsTimer = 0.0;
@@ -84,24 +603,69 @@ int main() {
             fpsTimer += dt;
             ++frames;
 
+            // No device idle: the compute pipeline follows the swapchain's generation on
+            // its next dispatch, and both retire the old resources as their frames finish
             if (window.wasResized()) {
-                vkDeviceWaitIdle(device);
                 swapchain.recreate();
-                compute.recreate();
                 window.resetResizeFlag();
             }
 
+            if (variantRequested) {
+                compute.setVariant(requestedVariant);
+                variantRequested = false;
+            }
+            if (autotuneRequested) {
+                compute.autotuneWorkgroup();
+                requestedVariant = compute.getVariant();
+                autotuneRequested = false;
+            }
+            if (spinChange != 0.0f) {
+                compute.setSpin(compute.getSpin() + spinChange);
+                spinChange = 0.0f;
+                if (compute.getMetric() == GeodesicMetric::Kerr) {
+                    std::cout << "[Main] Spin: " << compute.getSpin() << "\n";
+                }
+            }
+
+            // Throttle to MAX_FRAMES ahead of the GPU; also frees this slot's semaphores for reuse
+            const auto waitStart = std::chrono::steady_clock::now();
+            const uint32_t currentFrame = scheduler.beginFrame();
+
+            if (windowed.lowLatency) pacer.pace();
+
             uint32_t imageIndex = swapchain.acquireNextImage(imageAvailableSems[currentFrame]);
 
+            if (GpuProfiler* profiler = compute.getProfiler()) {
+                const std::chrono::duration<float, std::milli> waited = std::chrono::steady_clock::now() - waitStart;
+                profiler->addHostWait(waited.count());
+            }
+
+            // Low latency: take the input that arrived while pacing and acquiring, right
+            // before the camera goes into the frame
+            if (windowed.lowLatency) window.pollEvents();
+            if (inputPending) {
+                pacer.inputSampled(inputTime);
+                inputPending = false;
+            }
+
             CameraData camData{camera.x, camera.y, camera.zoom, static_cast<float>(glfwGetTime())};
             compute.dispatch(imageIndex, imageAvailableSems[currentFrame], renderFinishedSems[currentFrame], camData);
             swapchain.present(imageIndex, renderFinishedSems[currentFrame]);
+            pacer.presented();
 
-            currentFrame = (currentFrame + 1) % MAX_FRAMES;
+            scheduler.endFrame();
 
             if (fpsTimer >= 1.0) {
                 std::cout << "[FPS] " << frames << " | Cam: ("
-                         << camera.x << ", " << camera.y << ") Zoom: " << camera.zoom << "\n";
+                         << camera.x << ", " << camera.y << ") Zoom: " << camera.zoom;
+                if (options.dynamicResolution) {
+                    VkExtent2D r = compute.getRenderExtent();
+                    std::cout << " | Res: " << r.width << "x" << r.height
+                              << " (" << compute.getLastGpuMs() << " ms GPU)";
+                }
+                pacer.report(std::cout);
+                std::cout << "\n";
+                if (options.profiling && compute.getProfiler()) compute.getProfiler()->report(std::cout);
                 fpsTimer -= 1.0;
                 frames = 0;
             }
@@ -0,0 +1,50 @@
+#include "geodesic_packet_impl.h"
+
+#if defined(GARGANTUA_REFERENCE_AVX2) && defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#if defined(GARGANTUA_REFERENCE_AVX2)
+// geodesic_packet_avx2.cpp, compiled with AVX2 enabled; only called after cpuHasAvx2()
+void integrateRaysAvx2(const GeodesicSettings& settings, const DiskShading& shading, TracedRay* rays, size_t count);
+#endif
+
+namespace {
+#if (defined(__ARM_NEON) && defined(__aarch64__)) || defined(_M_ARM64)
+    using Portable = lanes::Neon;          // NEON is part of the 64-bit ARM baseline
+#elif defined(__SSE2__) || defined(_M_X64)
+    using Portable = lanes::Sse2;
+#else
+    using Portable = lanes::Generic<4>;
+#endif
+    using Scalar = lanes::Generic<1>;
+
+#if defined(GARGANTUA_REFERENCE_AVX2)
+    bool cpuHasAvx2() {
+#if defined(_MSC_VER)
+        int info[4];
+        __cpuid(info, 0);
+        if (info[0] < 7) return false;
+        __cpuid(info, 1);
+        const bool osxsave = (info[2] & (1 << 27)) != 0;
+        const bool avx     = (info[2] & (1 << 28)) != 0;
+        const bool fma     = (info[2] & (1 << 12)) != 0;
+        if (!osxsave || !avx || !fma) return false;
+        if ((_xgetbv(0) & 6) != 6) return false;   // the OS saves the YMM registers
+        __cpuidex(info, 7, 0);
+        return (info[1] & (1 << 5)) != 0;
+#else
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#endif
+    }
+#endif
+}
+
+GeodesicKernel selectGeodesicKernel(bool simd) {
+    if (!simd) return { Scalar::kName, Scalar::kLanes, &integrateRays<Scalar> };
+#if defined(GARGANTUA_REFERENCE_AVX2)
+    if (cpuHasAvx2()) return { "avx2", 4, &integrateRaysAvx2 };
+#endif
+    return { Portable::kName, Portable::kLanes, &integrateRays<Portable> };
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// The reference tracer's geodesic integration: traceGeodesic's Schwarzschild RK4 loop
+// (gargantua.comp, geodesic.glsl) in double precision, run over SIMD packets of rays.
+// Shading stays scalar (reference_shading.h); only disk crossings call back into it.
+
+// geodesic.glsl's quality constants for one trace
+struct GeodesicSettings {
+    int32_t  maxSteps       = 1200;    // MAX_GEODESIC_STEPS
+    double   stepSize       = 0.08;    // STEP_SIZE, outer step tier
+    double   farFieldRadius = 20.0;    // FAR_FIELD_R; <= 0 integrates out to ESCAPE_R
+    bool     disk           = true;
+    // RK4 steps per shader step: every tier's step is divided by this and the step budget
+    // multiplied, so the same path converges towards the exact geodesic as it grows
+    uint32_t substeps       = 1;
+};
+
+enum class RayFate : int32_t { Horizon = 0, Escape = 1, Limit = 2 };   // gargantua.comp FATE_*
+
+// One camera sample through the integrator. In: pos on (or inside) the interaction sphere,
+// vel the unit direction. Out: the last position and velocity, how the ray ended and what
+// it collected on the way.
+struct TracedRay {
+    double   pos[3];
+    double   vel[3];
+    double   disk[4]  = { 0.0, 0.0, 0.0, 0.0 };   // composited disk colour, alpha in [3]
+    double   glow     = 0.0;   // sum of glowAt()'s 1/r^3 term over the steps, unweighted
+    double   ring     = 0.0;   // steps inside the photon-ring shell
+    double   r        = 0.0;   // radius at termination
+    int32_t  steps    = 0;     // RK4 steps taken (substeps included)
+    RayFate  fate     = RayFate::Limit;
+    uint32_t sample   = 0;     // caller's index of the sample this ray shades
+};
+
+// Composites one disk crossing at pos (velocity vel) into ray.disk when it falls in the
+// shaded annulus; defined with the shading, called by the kernels
+struct DiskShading;
+void compositeDiskCrossing(const DiskShading& shading, const double pos[3], const double vel[3], double disk[4]);
+
+using GeodesicKernelFn = void (*)(const GeodesicSettings& settings, const DiskShading& shading,
+                                  TracedRay* rays, size_t count);
+
+struct GeodesicKernel {
+    const char*      name  = "scalar";
+    int              lanes = 1;
+    GeodesicKernelFn integrate = nullptr;
+};
+
+// The widest packet kernel this CPU runs (AVX2 when built in and supported, else SSE2 on
+// x86-64, NEON on 64-bit ARM or four plain lanes); simd false picks the one-lane
+// scalar kernel, the baseline the packets are measured against.
+GeodesicKernel selectGeodesicKernel(bool simd);
@@ -0,0 +1,11 @@
+// Built with -mavx2 (/arch:AVX2 on MSVC) when GARGANTUA_REFERENCE_AVX2 is defined, see
+// CMakeLists.txt. Nothing else may live here: any code in this file can use AVX2.
+#include "geodesic_packet_impl.h"
+
+#if !defined(__AVX2__)
+#error "geodesic_packet_avx2.cpp must be compiled with AVX2 enabled"
+#endif
+
+void integrateRaysAvx2(const GeodesicSettings& settings, const DiskShading& shading, TracedRay* rays, size_t count) {
+    integrateRays<lanes::Avx2>(settings, shading, rays, count);
+}
@@ -0,0 +1,192 @@
+#pragma once
+#include "geodesic_packet.h"
+#include "simd_lanes.h"
+
+// The packet kernel, instantiated per lane type by geodesic_packet.cpp and, built with
+// AVX2 enabled, geodesic_packet_avx2.cpp. Internal linkage like simd_lanes.h.
+//
+// Each lane carries one ray; a lane whose ray ends takes the next ray of the batch at
+// once, so a packet stays full while its rays need very different step counts (a grazing
+// ray takes ten times the steps of a sky ray). Lanes without work left are parked on a
+// harmless outward ray until the packet drains.
+namespace {
+
+constexpr double kHorizonR = 1.05;    // HORIZON_R (Rs = 1)
+constexpr double kEscapeR  = 100.0;   // ESCAPE_R
+constexpr double kParkedR  = 50.0;
+
+template <class V>
+struct Lanes3 {
+    V x, y, z;
+
+    friend Lanes3 operator+(const Lanes3& a, const Lanes3& b) { return { a.x + b.x, a.y + b.y, a.z + b.z }; }
+    friend Lanes3 operator*(V s, const Lanes3& a)             { return { s * a.x, s * a.y, s * a.z }; }
+};
+
+template <class V>
+V dot(const Lanes3<V>& a, const Lanes3<V>& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+
+template <class V>
+V smoothstep(double e0, double e1, V x) {
+    const V t = min(max((x - V::splat(e0)) / V::splat(e1 - e0), V::splat(0.0)), V::splat(1.0));
+    return t * t * (V::splat(3.0) - V::splat(2.0) * t);
+}
+
+// geodesicAcceleration (geodesic.glsl)
+template <class V>
+Lanes3<V> geodesicAcceleration(const Lanes3<V>& pos, const Lanes3<V>& vel) {
+    const V one  = V::splat(1.0);
+    const V r    = sqrt(dot(pos, pos));
+    const V invR = one / r;
+    const Lanes3<V> rhat = invR * pos;
+
+    const V vr = dot(vel, rhat);
+    const V f  = max(one - invR, V::splat(0.001));
+    const V fPrime = invR * invR;
+
+    const V radial  = V::splat(0.0) - (fPrime / (V::splat(2.0) * f)) * (f * (one + dot(vel, vel)) - vr * vr / f);
+    const V angular = V::splat(0.0) - fPrime * invR;
+    const Lanes3<V> tangential{ vel.x - vr * rhat.x, vel.y - vr * rhat.y, vel.z - vr * rhat.z };
+    const Lanes3<V> acc = radial * rhat + angular * tangential;
+
+    const auto inside = r < V::splat(1.01);
+    const V zero = V::splat(0.0);
+    return { select(inside, zero, acc.x), select(inside, zero, acc.y), select(inside, zero, acc.z) };
+}
+
+// rk4Step (geodesic.glsl); the position rate is the velocity
+template <class V>
+void rk4Step(Lanes3<V>& pos, Lanes3<V>& vel, V h) {
+    const V half = V::splat(0.5) * h;
+    const V two  = V::splat(2.0);
+
+    const Lanes3<V> k1v = geodesicAcceleration(pos, vel);
+    const Lanes3<V> k1p = vel;
+
+    const Lanes3<V> p1 = pos + half * k1p;
+    const Lanes3<V> v1 = vel + half * k1v;
+    const Lanes3<V> k2v = geodesicAcceleration(p1, v1);
+    const Lanes3<V> k2p = v1;
+
+    const Lanes3<V> p2 = pos + half * k2p;
+    const Lanes3<V> v2 = vel + half * k2v;
+    const Lanes3<V> k3v = geodesicAcceleration(p2, v2);
+    const Lanes3<V> k3p = v2;
+
+    const Lanes3<V> p3 = pos + h * k3p;
+    const Lanes3<V> v3 = vel + h * k3v;
+    const Lanes3<V> k4v = geodesicAcceleration(p3, v3);
+    const Lanes3<V> k4p = v3;
+
+    const V sixth = h / V::splat(6.0);
+    pos = pos + sixth * (k1p + two * k2p + two * k3p + k4p);
+    vel = vel + sixth * (k1v + two * k2v + two * k3v + k4v);
+}
+
+template <class V>
+void integrateRays(const GeodesicSettings& settings, const DiskShading& shading, TracedRay* rays, size_t count) {
+    constexpr int W = V::kLanes;
+    const int32_t substeps = static_cast<int32_t>(settings.substeps > 0 ? settings.substeps : 1);
+    const int32_t limit    = settings.maxSteps * substeps;
+    const double  farField = settings.farFieldRadius;
+
+    alignas(32) double px[W], py[W], pz[W], vx[W], vy[W], vz[W], glow[W], ring[W];
+    int32_t    steps[W];
+    TracedRay* lane[W];
+    uint32_t   active = 0;
+    size_t     next = 0;
+
+    const auto issue = [&](int l) {
+        if (next < count) {
+            TracedRay& ray = rays[next++];
+            px[l] = ray.pos[0]; py[l] = ray.pos[1]; pz[l] = ray.pos[2];
+            vx[l] = ray.vel[0]; vy[l] = ray.vel[1]; vz[l] = ray.vel[2];
+            lane[l] = &ray;
+            active |= 1u << l;
+        } else {
+            px[l] = kParkedR; py[l] = 0.0; pz[l] = 0.0;
+            vx[l] = 1.0;      vy[l] = 0.0; vz[l] = 0.0;
+            lane[l] = nullptr;
+            active &= ~(1u << l);
+        }
+        glow[l] = 0.0;
+        ring[l] = 0.0;
+        steps[l] = 0;
+    };
+    const auto retire = [&](int l, RayFate fate, double r) {
+        TracedRay& ray = *lane[l];
+        ray.pos[0] = px[l]; ray.pos[1] = py[l]; ray.pos[2] = pz[l];
+        ray.vel[0] = vx[l]; ray.vel[1] = vy[l]; ray.vel[2] = vz[l];
+        ray.glow = glow[l];
+        ray.ring = ring[l];
+        ray.r = r;
+        ray.steps = steps[l];
+        ray.fate = fate;
+        issue(l);
+    };
+    for (int l = 0; l < W; ++l) issue(l);
+
+    while (active) {
+        // The top of traceGeodesic's loop: step limit, horizon, escape. Repeated until no
+        // lane retires, so a ray that just took a lane is tested before its first step.
+        Lanes3<V> pos, vel;
+        V r;
+        for (;;) {
+            pos = { V::load(px), V::load(py), V::load(pz) };
+            vel = { V::load(vx), V::load(vy), V::load(vz) };
+            r = sqrt(dot(pos, pos));
+
+            const uint32_t captured = bits(r < V::splat(kHorizonR));
+            const uint32_t escaped  = farField > 0.0 ? bits((r > V::splat(farField)) & (dot(pos, vel) > V::splat(0.0)))
+                                                     : bits(r > V::splat(kEscapeR));
+            alignas(32) double radius[W];
+            r.store(radius);
+
+            uint32_t retired = 0;
+            for (int l = 0; l < W; ++l) {
+                const uint32_t bit = 1u << l;
+                if (!(active & bit)) continue;
+                if (steps[l] >= limit)  retire(l, RayFate::Limit, radius[l]);
+                else if (captured & bit) retire(l, RayFate::Horizon, radius[l]);
+                else if (escaped & bit)  retire(l, RayFate::Escape, radius[l]);
+                else continue;
+                retired |= bit;
+            }
+            if (!retired) break;
+        }
+        if (!active) break;
+
+        // stepSize(): finer tiers inside 3 Rs and 2 Rs
+        const V one = V::splat(1.0), tier = V::splat(0.3);
+        V h = V::splat(settings.stepSize / substeps);
+        h = h * select(r < V::splat(3.0), tier, one);
+        h = h * select(r < V::splat(2.0), tier, one);
+
+        const V prevY = pos.y;
+        rk4Step(pos, vel, h);
+        pos.x.store(px); pos.y.store(py); pos.z.store(pz);
+        vel.x.store(vx); vel.y.store(vy); vel.z.store(vz);
+
+        // Equatorial plane crossings are rare; shade them lane by lane
+        if (settings.disk) {
+            const uint32_t crossed = bits(prevY * pos.y < V::splat(0.0)) & active;
+            for (int l = 0; crossed && l < W; ++l) {
+                if (!(crossed & (1u << l))) continue;
+                const double p[3] = { px[l], py[l], pz[l] };
+                const double v[3] = { vx[l], vy[l], vz[l] };
+                compositeDiskCrossing(shading, p, v, lane[l]->disk);
+            }
+        }
+
+        // glowAt() at the radius the step started from; the shading applies the weights
+        const V zero = V::splat(0.0);
+        const V focus = smoothstep(1.1, 2.5, r) * (one - smoothstep(3.5, 6.0, r));
+        const V falloff = V::splat(0.0015) / (r * r * r);
+        (V::load(glow) + select((r > V::splat(1.05)) & (r < V::splat(6.0)), falloff * focus, zero)).store(glow);
+        (V::load(ring) + select((r > V::splat(1.48)) & (r < V::splat(1.52)), one, zero)).store(ring);
+
+        for (int l = 0; l < W; ++l) steps[l] += (active >> l) & 1u;
+    }
+}
+
+}
@@ -0,0 +1,242 @@
+#include "reference_shading.h"
+#include "geodesic_packet.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace shading {
+
+namespace {
+    // GLSL built-ins
+    float  fractf(float x)                        { return x - std::floor(x); }
+    double clamp01(double x)                      { return std::clamp(x, 0.0, 1.0); }
+    double mix(double a, double b, double t)      { return a + (b - a) * t; }
+    Vec3   mix(Vec3 a, Vec3 b, double t)          { return a + t * (b - a); }
+    Vec3   clamp(Vec3 c, double lo, double hi)    {
+        return { std::clamp(c.x, lo, hi), std::clamp(c.y, lo, hi), std::clamp(c.z, lo, hi) };
+    }
+    double smoothstep(double e0, double e1, double x) {
+        const double t = clamp01((x - e0) / (e1 - e0));
+        return t * t * (3.0 - 2.0 * t);
+    }
+    double glslMod(double x, double y)            { return x - y * std::floor(x / y); }
+
+    // value() from sky.glsl, all in float like the shader's hash arguments
+    float value(float px, float py, float f) {
+        const float x = px * f, y = py * f;
+        const float fx0 = std::floor(x), fy0 = std::floor(y);
+        const float bl = hash2(fx0,        fy0);
+        const float br = hash2(fx0 + 1.0f, fy0);
+        const float tl = hash2(fx0,        fy0 + 1.0f);
+        const float tr = hash2(fx0 + 1.0f, fy0 + 1.0f);
+
+        float frx = fractf(x), fry = fractf(y);
+        frx = (3.0f - 2.0f * frx) * frx * frx;
+        fry = (3.0f - 2.0f * fry) * fry * fry;
+        const float b = bl + (br - bl) * frx;
+        const float t = tl + (tr - tl) * frx;
+        return b + (t - b) * fry;
+    }
+
+    // disk_profile.glsl
+    double diskFade(double r) {
+        double fade = clamp01((r - 0.75) * 1.5);
+        fade *= clamp01((10.0 - r) * 0.20);
+        return fade * fade;
+    }
+
+    Vec3 diskRedshift(double r) {
+        const double f = std::max(1.0 - 1.0 / r, 0.01);
+        const double z = 1.0 / std::sqrt(f) - 1.0;
+        return { 1.0 + z * 0.5, 1.0 + z * 0.2, 1.0 - z * 0.3 };
+    }
+
+    Vec3 bendTowardsHole(Vec3 pos, Vec3 dir, double b, double sin1, double sin2) {
+        if (b < 1e-3) return dir;
+        const double alpha = (sin2 - sin1) / b;
+        const Vec3 towards = (-1.0 / b) * (pos - dot(pos, dir) * dir);
+        return normalize(std::cos(alpha) * dir + std::sin(alpha) * towards);
+    }
+
+    // raymarchDisk (trace_common.glsl) on the procedural path
+    Vec4 raymarchDisk(const DiskShading& shading, Vec3 ray, Vec3 zeroPos) {
+        const double steps = static_cast<double>(shading.steps);
+        Vec3 position = zeroPos;
+        const double lengthPos = std::hypot(position.x, position.z);
+        const double dist = std::min(1.0, lengthPos * 0.5) * 0.4 * (1.0 / steps) / std::abs(ray.y);
+
+        position = position + (dist * steps * 0.5) * ray;
+
+        // (deltaPos - zeroPos.xz) of the shader, normalized
+        double dx = -zeroPos.z * 0.01, dz = zeroPos.x * 0.01;
+        const double dl = std::hypot(dx, dz);
+        dx /= dl;
+        dz /= dl;
+
+        double parallel = ray.x * dx + ray.z * dz;
+        parallel /= std::sqrt(lengthPos);
+        parallel *= 0.5;
+        double redShift = parallel + 0.3;
+        redShift *= redShift;
+        redShift = clamp01(redShift);
+
+        const double disMix = clamp01((lengthPos - 2.0) * 0.24);
+        Vec3 insideCol = mix(Vec3{ 1.0, 0.8, 0.0 }, 0.2 * Vec3{ 0.5, 0.13, 0.02 }, disMix);
+        insideCol = insideCol * mix(Vec3{ 0.4, 0.2, 0.1 }, Vec3{ 1.6, 2.4, 4.0 }, redShift);
+        insideCol = 1.25 * insideCol;
+        redShift += 0.12;
+        redShift *= redShift;
+
+        Vec4 o;
+        const double rot = glslMod(shading.time * shading.speed, 8192.0);
+        const double sinRot = std::sin(rot), cosRot = std::cos(rot);
+
+        for (double i = 0.0; i < steps; i += 1.0) {
+            position = position - dist * ray;
+
+            const double intensity = clamp01(1.0 - std::abs((i - 0.8) * (1.0 / steps) * 2.0));
+            const double lengthPos2 = std::hypot(position.x, position.z);
+            const Vec3 shift = diskRedshift(lengthPos2);
+            const double distMult = diskFade(lengthPos2);
+
+            const double u = lengthPos2 + shading.time * 0.3 + intensity * 0.2;
+            const double xyX = -position.z * sinRot + position.x * cosRot;
+            const double xyY = position.x * sinRot + position.z * cosRot;
+            const double angle = 0.02 * std::atan(std::abs(xyX / xyY));
+
+            const float nx = static_cast<float>(angle), ny = static_cast<float>(u * 0.05);
+            double noise = value(nx, ny, 70.0f);
+            noise = noise * 0.66 + 0.33 * value(nx, ny, 140.0f);
+
+            const double extraWidth = noise * (1.0 - clamp01(i * (1.0 / steps) * 2.0 - 1.0));
+            const double density = (10.0 + 0.01) * dist * distMult;
+            const double alpha = clamp01(noise * (intensity + extraWidth) * density);
+
+            Vec3 col = 2.0 * mix(Vec3{ 0.3, 0.2, 0.15 } * insideCol, insideCol, std::min(1.0, intensity * 2.0));
+            col = clamp(col * shift, 0.0, 2.0);
+
+            const Vec3 rgb = clamp(alpha * col + (1.0 - alpha) * Vec3{ o.x, o.y, o.z }, 0.0, 1.0);
+            o = { rgb.x, rgb.y, rgb.z, clamp01(o.w * (1.0 - alpha) + alpha) };
+
+            const double glow = redShift * (intensity + 0.5) * (1.0 / steps) * 100.0 * distMult / (lengthPos2 * lengthPos2);
+            o.x += glow;
+            o.y += glow;
+            o.z += glow;
+        }
+
+        const Vec3 rgb = clamp(Vec3{ o.x - 0.005, o.y - 0.005, o.z - 0.005 }, 0.0, 1.0);
+        return { rgb.x * shading.brightness, rgb.y * shading.brightness, rgb.z * shading.brightness, o.w };
+    }
+}
+
+double length(Vec3 a) { return std::sqrt(dot(a, a)); }
+Vec3   normalize(Vec3 a) { return (1.0 / length(a)) * a; }
+
+float hash(float x) { return fractf(std::sin(x) * 152754.742f); }
+float hash2(float x, float y) { return hash(x + hash(y)); }
+
+Vec3 background(Vec3 ray) {
+    const float rx = static_cast<float>(ray.x), ry = static_cast<float>(ray.y), rz = static_cast<float>(ray.z);
+    float ux = rx, uy = ry;
+    if (std::abs(rx) > 0.5f)
+        ux = rz;
+    else if (std::abs(ry) > 0.5f)
+        uy = rz;
+
+    double brightness = value(ux * 3.0f, uy * 3.0f, 100.0f);
+    const double color = value(ux * 2.0f, uy * 2.0f, 20.0f);
+    brightness = clamp01(std::pow(brightness, 256.0) * 100.0);
+
+    const Vec3 stars = brightness * mix(Vec3{ 1.0, 0.6, 0.2 }, Vec3{ 0.2, 0.6, 1.0 }, color);
+
+    const double n1 = value(ux * 1.5f, uy * 1.5f, 10.0f);
+    const double n2 = value(ux * 3.0f, uy * 3.0f, 20.0f);
+    Vec3 nebula = Vec3{ 0.02, 0.01, 0.03 } + Vec3{ n1 * 0.1, n2 * 0.05, n1 * n2 * 0.08 };
+
+    const float gridScale = 0.04f;
+    const float theta = std::atan2(ry, rx);
+    const float phi = std::asin(std::clamp(rz, -1.0f, 1.0f));
+    const float gridTheta = std::abs(fractf(theta / gridScale) - 0.5f);
+    const float gridPhi = std::abs(fractf(phi / gridScale) - 0.5f);
+    const float gridWidth = 0.004f;
+    if (gridTheta < gridWidth || gridPhi < gridWidth) nebula = nebula + Vec3{ 0.08, 0.1, 0.15 };
+
+    return nebula + stars;
+}
+
+Vec3 asymptoticDirection(Vec3 pos, Vec3 vel) {
+    const Vec3 dir = normalize(vel);
+    const double r = length(pos);
+    const double b = length(cross(pos, dir));
+    return bendTowardsHole(pos, dir, b, dot(pos, dir) / r, 1.0);
+}
+
+bool enterInteractionSphere(Vec3& pos, Vec3& dir, double radius) {
+    const double r0 = length(pos);
+    if (r0 <= radius) return true;
+
+    const double s = dot(pos, dir);
+    const double b = length(cross(pos, dir));
+    if (s >= 0.0 || b >= radius) {
+        dir = asymptoticDirection(pos, dir);
+        return false;
+    }
+
+    const double t = -s - std::sqrt(radius * radius - b * b);
+    const Vec3 hit = pos + t * dir;
+    dir = bendTowardsHole(pos, dir, b, s / r0, dot(hit, dir) / radius);
+    pos = hit;
+    return true;
+}
+
+Vec3 shadeCaptured(const Vec4& diskColor, Vec3 glow, double r) {
+    const double darkness = mix(0.08, 1.0, smoothstep(0.9, 1.2, r));
+    const Vec3 disk{ diskColor.x, diskColor.y, diskColor.z };
+    const Vec3 shadowMix = darkness * (diskColor.w * disk + (1.0 - diskColor.w) * glow);
+    return shadowMix * Vec3{ 0.9, 0.85, 0.8 };
+}
+
+Vec3 shadeEscaped(const Vec4& diskColor, Vec3 glow, Vec3 dir) {
+    const Vec3 bg = background(normalize(dir));
+    const Vec3 disk{ diskColor.x, diskColor.y, diskColor.z };
+    return diskColor.w * disk + (1.0 - diskColor.w) * bg + (1.0 - diskColor.w) * glow;
+}
+
+Vec3 shadeUnresolved(const Vec4& diskColor, Vec3 glow, Vec3 dir) {
+    const Vec3 bg = background(normalize(dir));
+    const Vec3 disk{ diskColor.x, diskColor.y, diskColor.z };
+    return diskColor.w * disk + (1.0 - diskColor.w) * bg + glow;
+}
+
+Vec3 toneMap(Vec3 color, const Tone& tone) {
+    color = { std::pow(color.x, tone.gamma), std::pow(color.y, tone.gamma), std::pow(color.z, tone.gamma) };
+
+    // adjustSaturationContrast
+    const double lum = dot(color, Vec3{ 0.2126, 0.7152, 0.0722 });
+    const Vec3 satColor = mix(Vec3{ lum, lum, lum }, color, tone.saturation);
+    const Vec3 contrasted = clamp(tone.contrast * (satColor - Vec3{ 0.5, 0.5, 0.5 }) + Vec3{ 0.5, 0.5, 0.5 }, 0.0, 1.0);
+
+    return clamp(tone.exposure * contrasted, 0.0, 1.0);
+}
+
+Vec3 linearToSrgb(Vec3 c) {
+    const auto encode = [](double v) { return v <= 0.0031308 ? v * 12.92 : 1.055 * std::pow(v, 1.0 / 2.4) - 0.055; };
+    return { encode(c.x), encode(c.y), encode(c.z) };
+}
+
+}
+
+void compositeDiskCrossing(const DiskShading& shading, const double pos[3], const double vel[3], double disk[4]) {
+    using namespace shading;
+    if (disk[3] >= 0.95) return;
+    const double diskR = std::hypot(pos[0], pos[2]);
+    if (diskR <= 1.5 || diskR >= 8.0) return;
+
+    // compositeDisk: the new layer goes behind what the ray already passed through
+    const Vec4 layer = raymarchDisk(shading, normalize(Vec3{ vel[0], vel[1], vel[2] }), Vec3{ pos[0], pos[1], pos[2] });
+    const double behind = 1.0 - disk[3];
+    disk[0] += layer.x * behind;
+    disk[1] += layer.y * behind;
+    disk[2] += layer.z * behind;
+    disk[3] += layer.w * behind;
+}
@@ -0,0 +1,61 @@
+#pragma once
+#include <cstdint>
+
+// Scalar mirror of trace_common.glsl, sky.glsl and disk_profile.glsl for the reference
+// tracer: the procedural sky and disk (not the baked cubemap and disk textures), the ray
+// fates' shading and the tone map. Positions and colours are double; the value-noise
+// hashes are float like the shader's, since sin(x) * 152754.742 only reproduces the GPU's
+// pattern at the same precision.
+namespace shading {
+
+struct Vec3 {
+    double x = 0.0, y = 0.0, z = 0.0;
+};
+
+struct Vec4 {
+    double x = 0.0, y = 0.0, z = 0.0, w = 0.0;
+};
+
+inline Vec3   operator+(Vec3 a, Vec3 b)   { return { a.x + b.x, a.y + b.y, a.z + b.z }; }
+inline Vec3   operator-(Vec3 a, Vec3 b)   { return { a.x - b.x, a.y - b.y, a.z - b.z }; }
+inline Vec3   operator*(double s, Vec3 a) { return { s * a.x, s * a.y, s * a.z }; }
+inline Vec3   operator*(Vec3 a, Vec3 b)   { return { a.x * b.x, a.y * b.y, a.z * b.z }; }
+inline double dot(Vec3 a, Vec3 b)         { return a.x * b.x + a.y * b.y + a.z * b.z; }
+inline Vec3   cross(Vec3 a, Vec3 b)       { return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x }; }
+double        length(Vec3 a);
+Vec3          normalize(Vec3 a);
+
+// SceneState.tone
+struct Tone {
+    double exposure   = 1.05;
+    double gamma      = 0.7;
+    double saturation = 1.25;
+    double contrast   = 1.15;
+};
+
+float hash(float x);
+float hash2(float x, float y);
+
+// The procedural sky, background()
+Vec3 background(Vec3 dir);
+
+// geodesic.glsl's weak-field shortcuts (Rs = 1)
+Vec3 asymptoticDirection(Vec3 pos, Vec3 vel);
+bool enterInteractionSphere(Vec3& pos, Vec3& dir, double radius);
+
+Vec3 shadeCaptured(const Vec4& diskColor, Vec3 glow, double r);
+Vec3 shadeEscaped(const Vec4& diskColor, Vec3 glow, Vec3 dir);
+Vec3 shadeUnresolved(const Vec4& diskColor, Vec3 glow, Vec3 dir);
+
+Vec3 toneMap(Vec3 color, const Tone& tone);   // DEBUG_VIEW 0, clamped
+Vec3 linearToSrgb(Vec3 color);
+
+}
+
+// What raymarchDisk reads from the variant and SceneState.disk
+struct DiskShading {
+    int32_t steps      = 12;     // DISK_STEPS
+    double  time       = 0.0;    // iTime
+    double  speed      = 3.0;    // rotation rate
+    double  brightness = 1.0;    // emission scale
+};
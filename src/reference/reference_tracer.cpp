@@ -0,0 +1,209 @@
+#include "reference_tracer.h"
+#include "reference_shading.h"
+#include "work_stealing_pool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+using shading::Vec3;
+using shading::Vec4;
+
+namespace {
+    constexpr float kCameraDistance = 8.0f;   // ComputePipeline's camera radius per unit zoom
+}
+
+// SceneState.cameraToWorld and lens, as writeScene builds them
+struct ReferenceTracer::Camera {
+    Vec3   right, up, forward, position;
+    double focalLength = 1.2;
+};
+
+struct ReferenceTracer::Scratch {
+    std::vector<TracedRay> rays;
+    std::vector<Vec3>      samples;   // shaded, before tone mapping
+    uint64_t               steps = 0;
+};
+
+ReferenceTracer::ReferenceTracer(const ReferenceSettings& referenceSettings)
+    : settings(referenceSettings), kernel(selectGeodesicKernel(referenceSettings.simd)) {
+    if (settings.width == 0 || settings.height == 0) throw std::runtime_error("[Reference] Image size must not be zero.");
+    settings.samplesPerAxis = std::max(settings.samplesPerAxis, 1);
+    settings.tileSize = std::max(settings.tileSize, 1u);
+    settings.geodesic.substeps = std::max(settings.geodesic.substeps, 1u);
+
+    pool = std::make_unique<WorkStealingPool>(settings.threads);
+    scratch.resize(pool->getThreadCount());
+}
+
+ReferenceTracer::~ReferenceTracer() = default;
+
+uint32_t ReferenceTracer::getThreadCount() const { return pool->getThreadCount(); }
+
+std::vector<uint8_t> ReferenceTracer::render(const ReferenceView& view) {
+    // writeScene, in the same float precision
+    const float yaw   = view.time * settings.scene.orbitRate + view.x * 0.001f;
+    const float pitch = settings.scene.pitch + view.y * 0.001f;
+    const float cx = std::cos(yaw),   sx = std::sin(yaw);
+    const float cy = std::cos(pitch), sy = std::sin(pitch);
+    const float d  = kCameraDistance * view.zoom;
+
+    Camera camera;
+    camera.right    = { cx, 0.0f, sx };
+    camera.up       = { -sx * sy, cy, cx * sy };
+    camera.forward  = { -sx * cy, -sy, cx * cy };
+    camera.position = { d * sx * cy, d * sy, -d * cx * cy };
+    camera.focalLength = settings.scene.focalLength;
+
+    const DiskShading disk{ settings.diskSteps, view.time, settings.scene.diskSpeed, settings.scene.diskBrightness };
+
+    const uint32_t tile   = settings.tileSize;
+    const size_t   tilesX = (settings.width  + tile - 1) / tile;
+    const size_t   tilesY = (settings.height + tile - 1) / tile;
+    std::vector<uint8_t> image(static_cast<size_t>(settings.width) * settings.height * 3);
+    for (Scratch& s : scratch) s.steps = 0;
+
+    const auto start = std::chrono::steady_clock::now();
+    pool->run(tilesX * tilesY, [&](size_t index, uint32_t worker) {
+        traceTile(index, camera, disk, image.data(), scratch[worker]);
+    });
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    const uint64_t perPixel = static_cast<uint64_t>(settings.samplesPerAxis) * settings.samplesPerAxis;
+    lastSeconds = elapsed.count();
+    lastSamples = static_cast<uint64_t>(settings.width) * settings.height * perPixel;
+    lastSteps = 0;
+    for (const Scratch& s : scratch) lastSteps += s.steps;
+    return image;
+}
+
+void ReferenceTracer::traceTile(size_t index, const Camera& camera, const DiskShading& disk,
+                                uint8_t* image, Scratch& s) const {
+    const uint32_t tile   = settings.tileSize;
+    const uint32_t tilesX = (settings.width + tile - 1) / tile;
+    const uint32_t x0 = static_cast<uint32_t>(index % tilesX) * tile;
+    const uint32_t y0 = static_cast<uint32_t>(index / tilesX) * tile;
+    const uint32_t x1 = std::min(x0 + tile, settings.width);
+    const uint32_t y1 = std::min(y0 + tile, settings.height);
+
+    const int32_t n = settings.samplesPerAxis;
+    const uint32_t perPixel = static_cast<uint32_t>(n * n);
+    const double farField = settings.geodesic.farFieldRadius;
+    const Vec4 noDisk{};
+
+    s.rays.clear();
+    s.samples.assign(static_cast<size_t>(x1 - x0) * (y1 - y0) * perPixel, Vec3{});
+
+    // primaryRay and cameraRay (trace_common.glsl); seed and jitter in float like the shader
+    const float width = static_cast<float>(settings.width), height = static_cast<float>(settings.height);
+    const float time = static_cast<float>(disk.time);
+    uint32_t sample = 0;
+    for (uint32_t y = y0; y < y1; ++y)
+    for (uint32_t x = x0; x < x1; ++x)
+    for (int32_t j = 0; j < n; ++j)
+    for (int32_t i = 0; i < n; ++i, ++sample) {
+        const float fx = static_cast<float>(x), fy = static_cast<float>(y);
+        const float seed = shading::hash2(fx + static_cast<float>(i) + time, fy + static_cast<float>(j) + time);
+        const float jitterX = seed / static_cast<float>(n);
+        const float jitterY = shading::hash(seed + 13.37f) / static_cast<float>(n);
+        const float px = fx + (static_cast<float>(i) + jitterX) / static_cast<float>(n);
+        const float py = fy + (static_cast<float>(j) + jitterY) / static_cast<float>(n);
+
+        const Vec3 local = shading::normalize(Vec3{ (px - width * 0.5f) / height, (py - height * 0.5f) / height,
+                                                    camera.focalLength });
+        Vec3 dir = local.x * camera.right + local.y * camera.up + local.z * camera.forward;
+        Vec3 pos = camera.position;
+
+        // traceRay: zoomed out, rays missing the interaction sphere never reach the integrator
+        if (farField > 0.0 && !shading::enterInteractionSphere(pos, dir, farField)) {
+            s.samples[sample] = shading::shadeEscaped(noDisk, Vec3{}, dir);
+            continue;
+        }
+        TracedRay ray{};
+        ray.pos[0] = pos.x; ray.pos[1] = pos.y; ray.pos[2] = pos.z;
+        ray.vel[0] = dir.x; ray.vel[1] = dir.y; ray.vel[2] = dir.z;
+        ray.sample = sample;
+        s.rays.push_back(ray);
+    }
+
+    kernel.integrate(settings.geodesic, disk, s.rays.data(), s.rays.size());
+
+    // glowAt()'s weights; a substep collects 1 / substeps of a shader step's glow
+    const double perStep = 1.0 / static_cast<double>(settings.geodesic.substeps);
+    for (const TracedRay& ray : s.rays) {
+        s.steps += static_cast<uint64_t>(ray.steps);
+
+        Vec3 glow{};
+        if (settings.glow)       glow = glow + (ray.glow * perStep) * Vec3{ 1.25, 1.15, 1.05 };
+        if (settings.photonRing) glow = glow + (ray.ring * perStep * 0.005) * Vec3{ 0.5, 0.4, 0.3 };
+
+        const Vec4 diskColor{ ray.disk[0], ray.disk[1], ray.disk[2], ray.disk[3] };
+        const Vec3 pos{ ray.pos[0], ray.pos[1], ray.pos[2] };
+        const Vec3 vel{ ray.vel[0], ray.vel[1], ray.vel[2] };
+
+        Vec3& color = s.samples[ray.sample];
+        switch (ray.fate) {
+        case RayFate::Horizon:
+            color = shading::shadeCaptured(diskColor, glow, ray.r);
+            break;
+        case RayFate::Escape:
+            color = shading::shadeEscaped(diskColor, glow, farField > 0.0 ? shading::asymptoticDirection(pos, vel) : vel);
+            break;
+        case RayFate::Limit:
+            color = shading::shadeUnresolved(diskColor, glow, vel);
+            break;
+        }
+    }
+
+    // tracePixel's average of tone-mapped samples, then storePixel's sRGB encode and UNORM rounding
+    const shading::Tone tone{ settings.scene.exposure, settings.scene.gamma, settings.scene.saturation,
+                              settings.scene.contrast };
+    sample = 0;
+    for (uint32_t y = y0; y < y1; ++y)
+    for (uint32_t x = x0; x < x1; ++x) {
+        Vec3 sum{};
+        for (uint32_t k = 0; k < perPixel; ++k) sum = sum + shading::toneMap(s.samples[sample++], tone);
+        const Vec3 srgb = shading::linearToSrgb((1.0 / perPixel) * sum);
+
+        uint8_t* out = image + (static_cast<size_t>(y) * settings.width + x) * 3;
+        out[0] = static_cast<uint8_t>(std::lround(std::clamp(srgb.x, 0.0, 1.0) * 255.0));
+        out[1] = static_cast<uint8_t>(std::lround(std::clamp(srgb.y, 0.0, 1.0) * 255.0));
+        out[2] = static_cast<uint8_t>(std::lround(std::clamp(srgb.z, 0.0, 1.0) * 255.0));
+    }
+}
+
+ImageDifference compareImages(const std::vector<uint8_t>& reference, const std::vector<uint8_t>& image,
+                              int outlierThreshold, std::vector<uint8_t>* diff) {
+    if (reference.size() != image.size() || reference.size() % 3 != 0) {
+        throw std::runtime_error("[Reference] Compared images differ in size.");
+    }
+    if (diff) diff->assign(reference.size(), 0);
+
+    const size_t pixels = reference.size() / 3;
+    uint64_t sumAbs = 0, sumSq = 0, outliers = 0;
+    int maxAbs = 0;
+    for (size_t p = 0; p < pixels; ++p) {
+        int pixelMax = 0;
+        for (size_t c = p * 3; c < p * 3 + 3; ++c) {
+            const int d = std::abs(static_cast<int>(reference[c]) - static_cast<int>(image[c]));
+            sumAbs += static_cast<uint64_t>(d);
+            sumSq += static_cast<uint64_t>(d * d);
+            pixelMax = std::max(pixelMax, d);
+            if (diff) (*diff)[c] = static_cast<uint8_t>(std::min(d * 8, 255));
+        }
+        maxAbs = std::max(maxAbs, pixelMax);
+        if (pixelMax > outlierThreshold) ++outliers;
+    }
+
+    ImageDifference result;
+    if (pixels == 0) return result;
+    const double channels = static_cast<double>(reference.size());
+    result.meanAbs = static_cast<double>(sumAbs) / channels;
+    result.rmse = std::sqrt(static_cast<double>(sumSq) / channels);
+    result.psnr = result.rmse > 0.0 ? 20.0 * std::log10(255.0 / result.rmse) : std::numeric_limits<double>::infinity();
+    result.maxAbs = maxAbs;
+    result.outliers = static_cast<double>(outliers) / static_cast<double>(pixels);
+    return result;
+}
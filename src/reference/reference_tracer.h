@@ -0,0 +1,113 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "geodesic_packet.h"
+
+class WorkStealingPool;
+
+// CameraData's orbit camera (x / y drag, zoom, time), without the Vulkan headers
+struct ReferenceView {
+    float x = 0.0f, y = 0.0f, zoom = 1.0f, time = 0.0f;
+};
+
+struct ReferenceSettings {
+    uint32_t width  = 1920;
+    uint32_t height = 1080;
+
+    // The variant: AA x AA jittered samples per pixel, like a still or headless frame
+    int32_t          samplesPerAxis = 2;
+    int32_t          diskSteps      = 12;
+    bool             glow           = true;
+    bool             photonRing     = true;
+    GeodesicSettings geodesic;
+
+    // SceneParams, field for field
+    struct Scene {
+        float exposure       = 1.05f;
+        float gamma          = 0.7f;
+        float saturation     = 1.25f;
+        float contrast       = 1.15f;
+        float diskSpeed      = 3.0f;
+        float diskBrightness = 1.0f;
+        float focalLength    = 1.2f;
+        float pitch          = 1.2f;
+        float orbitRate      = 0.05f;
+    } scene;
+
+    uint32_t threads  = 0;      // 0: one per hardware thread
+    uint32_t tileSize = 32;     // pixel edge of a work item
+    bool     simd     = true;   // packet kernel; false: one ray at a time (the baseline)
+};
+
+// Per-channel differences of two 8-bit RGB images
+struct ImageDifference {
+    double meanAbs  = 0.0;
+    double rmse     = 0.0;
+    double psnr     = 0.0;    // dB; infinite for identical images
+    int    maxAbs   = 0;
+    double outliers = 0.0;    // fraction of pixels with a channel off by more than the threshold
+};
+
+/**
+ * ReferenceTracer
+ * ===============
+ * The trace on the CPU (--reference): ground truth for the GPU paths and a performance
+ * baseline. Mirrors gargantua.comp's per-pixel shading for the Schwarzschild metric with
+ * the fixed-tier RK4 integrator, the procedural sky and the procedural disk, in double
+ * precision; block classification, adaptive sampling, the deflection LUT, Dormand-Prince
+ * and the baked sky and disk are GPU approximations of exactly this image.
+ *
+ * The image is cut into tiles run on a WorkStealingPool. Within a tile, camera rays are
+ * generated and moved to the interaction sphere one by one, integrated in SIMD packets
+ * (geodesic_packet.h) and shaded one by one again. Rays, jitter and tone mapping follow
+ * tracePixel(), so output pixel (x, y) is the GPU's pixel (x, y), encoded to sRGB like
+ * the readback of an offscreen target.
+ *
+ * Not bit-exact: the value-noise hash (sin(x) * 152754.742) turns last-bit differences of
+ * the GPU's sin into different star and disk noise cells, and the GPU shades in fp32 or
+ * fp16. compareImages() reports how far apart two images are; GeodesicSettings::substeps
+ * refines the reference beyond what the GPU variant integrates.
+ */
+class ReferenceTracer {
+public:
+    explicit ReferenceTracer(const ReferenceSettings& settings);
+    ~ReferenceTracer();
+
+    ReferenceTracer(const ReferenceTracer&) = delete;
+    ReferenceTracer& operator=(const ReferenceTracer&) = delete;
+
+    // width x height 8-bit sRGB RGB, rows top to bottom; blocks until done
+    std::vector<uint8_t> render(const ReferenceView& view);
+
+    const char* getKernelName()   const { return kernel.name; }
+    int         getKernelLanes()  const { return kernel.lanes; }
+    uint32_t    getThreadCount()  const;
+
+    // The last render(): wall time, camera samples and integrated RK4 steps
+    double      getLastSeconds()  const { return lastSeconds; }
+    uint64_t    getLastSamples()  const { return lastSamples; }
+    uint64_t    getLastSteps()    const { return lastSteps; }
+
+private:
+    struct Camera;
+    struct Scratch;
+
+    void traceTile(size_t tile, const Camera& camera, const DiskShading& disk, uint8_t* image, Scratch& scratch) const;
+
+    ReferenceSettings                 settings;
+    GeodesicKernel                    kernel;
+    std::unique_ptr<WorkStealingPool> pool;
+    std::vector<Scratch>              scratch;   // one per worker
+
+    double   lastSeconds = 0.0;
+    uint64_t lastSamples = 0;
+    uint64_t lastSteps   = 0;
+};
+
+// image against reference, both width x height RGB. diff (optional) receives the absolute
+// difference amplified 8x. Throws if the sizes differ.
+ImageDifference compareImages(const std::vector<uint8_t>& reference, const std::vector<uint8_t>& image,
+                              int outlierThreshold = 8, std::vector<uint8_t>* diff = nullptr);
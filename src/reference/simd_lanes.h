@@ -0,0 +1,157 @@
+#pragma once
+#include <cmath>
+#include <cstdint>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+#if (defined(__ARM_NEON) && defined(__aarch64__)) || defined(_M_ARM64)
+#include <arm_neon.h>
+#endif
+
+// Double-precision SIMD lanes for the reference tracer's packet kernel (geodesic_packet.h).
+// Every backend offers the same small set: load/store/splat, + - * /, sqrt, min, max,
+// comparisons returning a Mask, select(mask, a, b) and bits(mask), one bit per lane.
+//
+// Included by translation units built with different instruction sets (the AVX2 kernel is
+// compiled with -mavx2 / /arch:AVX2), so everything here has internal linkage: the linker must
+// never merge an AVX2 copy of a function into the portable build.
+namespace {
+namespace lanes {
+
+// N lanes over plain arrays, for targets without one of the backends below. N = 1 is the
+// scalar baseline.
+template <int N>
+struct Generic {
+    static constexpr int kLanes = N;
+    static constexpr const char* kName = N == 1 ? "scalar" : "generic";
+
+    struct Mask { bool m[N]; };
+
+    double v[N];
+
+    static Generic load(const double* p) { Generic r; for (int i = 0; i < N; ++i) r.v[i] = p[i]; return r; }
+    static Generic splat(double x)       { Generic r; for (int i = 0; i < N; ++i) r.v[i] = x; return r; }
+    void store(double* p) const          { for (int i = 0; i < N; ++i) p[i] = v[i]; }
+
+#define LANES_GENERIC_OP(op) \
+    friend Generic operator op(Generic a, Generic b) { Generic r; for (int i = 0; i < N; ++i) r.v[i] = a.v[i] op b.v[i]; return r; }
+    LANES_GENERIC_OP(+)
+    LANES_GENERIC_OP(-)
+    LANES_GENERIC_OP(*)
+    LANES_GENERIC_OP(/)
+#undef LANES_GENERIC_OP
+
+    friend Generic sqrt(Generic a) { Generic r; for (int i = 0; i < N; ++i) r.v[i] = std::sqrt(a.v[i]); return r; }
+    friend Generic min(Generic a, Generic b) { Generic r; for (int i = 0; i < N; ++i) r.v[i] = a.v[i] < b.v[i] ? a.v[i] : b.v[i]; return r; }
+    friend Generic max(Generic a, Generic b) { Generic r; for (int i = 0; i < N; ++i) r.v[i] = a.v[i] > b.v[i] ? a.v[i] : b.v[i]; return r; }
+
+    friend Mask operator<(Generic a, Generic b) { Mask m; for (int i = 0; i < N; ++i) m.m[i] = a.v[i] < b.v[i]; return m; }
+    friend Mask operator>(Generic a, Generic b) { Mask m; for (int i = 0; i < N; ++i) m.m[i] = a.v[i] > b.v[i]; return m; }
+    friend Mask operator&(Mask a, Mask b) { Mask m; for (int i = 0; i < N; ++i) m.m[i] = a.m[i] && b.m[i]; return m; }
+
+    friend Generic select(Mask m, Generic a, Generic b) { Generic r; for (int i = 0; i < N; ++i) r.v[i] = m.m[i] ? a.v[i] : b.v[i]; return r; }
+    friend uint32_t bits(Mask m) { uint32_t b = 0; for (int i = 0; i < N; ++i) b |= m.m[i] ? 1u << i : 0u; return b; }
+};
+
+#if defined(__SSE2__) || defined(_M_X64)
+// Part of the x86-64 baseline: the portable packet width there
+struct Sse2 {
+    static constexpr int kLanes = 2;
+    static constexpr const char* kName = "sse2";
+
+    struct Mask { __m128d m; };
+
+    __m128d v;
+
+    static Sse2 load(const double* p) { return { _mm_loadu_pd(p) }; }
+    static Sse2 splat(double x)       { return { _mm_set1_pd(x) }; }
+    void store(double* p) const       { _mm_storeu_pd(p, v); }
+
+    friend Sse2 operator+(Sse2 a, Sse2 b) { return { _mm_add_pd(a.v, b.v) }; }
+    friend Sse2 operator-(Sse2 a, Sse2 b) { return { _mm_sub_pd(a.v, b.v) }; }
+    friend Sse2 operator*(Sse2 a, Sse2 b) { return { _mm_mul_pd(a.v, b.v) }; }
+    friend Sse2 operator/(Sse2 a, Sse2 b) { return { _mm_div_pd(a.v, b.v) }; }
+
+    friend Sse2 sqrt(Sse2 a)         { return { _mm_sqrt_pd(a.v) }; }
+    friend Sse2 min(Sse2 a, Sse2 b)  { return { _mm_min_pd(a.v, b.v) }; }
+    friend Sse2 max(Sse2 a, Sse2 b)  { return { _mm_max_pd(a.v, b.v) }; }
+
+    friend Mask operator<(Sse2 a, Sse2 b) { return { _mm_cmplt_pd(a.v, b.v) }; }
+    friend Mask operator>(Sse2 a, Sse2 b) { return { _mm_cmpgt_pd(a.v, b.v) }; }
+    friend Mask operator&(Mask a, Mask b) { return { _mm_and_pd(a.m, b.m) }; }
+
+    // No blendv before SSE4.1
+    friend Sse2 select(Mask m, Sse2 a, Sse2 b) { return { _mm_or_pd(_mm_and_pd(m.m, a.v), _mm_andnot_pd(m.m, b.v)) }; }
+    friend uint32_t bits(Mask m) { return static_cast<uint32_t>(_mm_movemask_pd(m.m)); }
+};
+#endif
+
+#if defined(__AVX2__)
+struct Avx2 {
+    static constexpr int kLanes = 4;
+    static constexpr const char* kName = "avx2";
+
+    struct Mask { __m256d m; };
+
+    __m256d v;
+
+    static Avx2 load(const double* p) { return { _mm256_loadu_pd(p) }; }
+    static Avx2 splat(double x)       { return { _mm256_set1_pd(x) }; }
+    void store(double* p) const       { _mm256_storeu_pd(p, v); }
+
+    friend Avx2 operator+(Avx2 a, Avx2 b) { return { _mm256_add_pd(a.v, b.v) }; }
+    friend Avx2 operator-(Avx2 a, Avx2 b) { return { _mm256_sub_pd(a.v, b.v) }; }
+    friend Avx2 operator*(Avx2 a, Avx2 b) { return { _mm256_mul_pd(a.v, b.v) }; }
+    friend Avx2 operator/(Avx2 a, Avx2 b) { return { _mm256_div_pd(a.v, b.v) }; }
+
+    friend Avx2 sqrt(Avx2 a)         { return { _mm256_sqrt_pd(a.v) }; }
+    friend Avx2 min(Avx2 a, Avx2 b)  { return { _mm256_min_pd(a.v, b.v) }; }
+    friend Avx2 max(Avx2 a, Avx2 b)  { return { _mm256_max_pd(a.v, b.v) }; }
+
+    friend Mask operator<(Avx2 a, Avx2 b) { return { _mm256_cmp_pd(a.v, b.v, _CMP_LT_OQ) }; }
+    friend Mask operator>(Avx2 a, Avx2 b) { return { _mm256_cmp_pd(a.v, b.v, _CMP_GT_OQ) }; }
+    friend Mask operator&(Mask a, Mask b) { return { _mm256_and_pd(a.m, b.m) }; }
+
+    friend Avx2 select(Mask m, Avx2 a, Avx2 b) { return { _mm256_blendv_pd(b.v, a.v, m.m) }; }
+    friend uint32_t bits(Mask m) { return static_cast<uint32_t>(_mm256_movemask_pd(m.m)); }
+};
+#endif
+
+#if (defined(__ARM_NEON) && defined(__aarch64__)) || defined(_M_ARM64)
+struct Neon {
+    static constexpr int kLanes = 2;
+    static constexpr const char* kName = "neon";
+
+    struct Mask { uint64x2_t m; };
+
+    float64x2_t v;
+
+    static Neon load(const double* p) { return { vld1q_f64(p) }; }
+    static Neon splat(double x)       { return { vdupq_n_f64(x) }; }
+    void store(double* p) const       { vst1q_f64(p, v); }
+
+    friend Neon operator+(Neon a, Neon b) { return { vaddq_f64(a.v, b.v) }; }
+    friend Neon operator-(Neon a, Neon b) { return { vsubq_f64(a.v, b.v) }; }
+    friend Neon operator*(Neon a, Neon b) { return { vmulq_f64(a.v, b.v) }; }
+    friend Neon operator/(Neon a, Neon b) { return { vdivq_f64(a.v, b.v) }; }
+
+    friend Neon sqrt(Neon a)         { return { vsqrtq_f64(a.v) }; }
+    friend Neon min(Neon a, Neon b)  { return { vminq_f64(a.v, b.v) }; }
+    friend Neon max(Neon a, Neon b)  { return { vmaxq_f64(a.v, b.v) }; }
+
+    friend Mask operator<(Neon a, Neon b) { return { vcltq_f64(a.v, b.v) }; }
+    friend Mask operator>(Neon a, Neon b) { return { vcgtq_f64(a.v, b.v) }; }
+    friend Mask operator&(Mask a, Mask b) { return { vandq_u64(a.m, b.m) }; }
+
+    friend Neon select(Mask m, Neon a, Neon b) { return { vbslq_f64(m.m, a.v, b.v) }; }
+    friend uint32_t bits(Mask m) {
+        return static_cast<uint32_t>(vgetq_lane_u64(m.m, 0) & 1u) | static_cast<uint32_t>((vgetq_lane_u64(m.m, 1) & 1u) << 1);
+    }
+};
+#endif
+
+}
+}
@@ -0,0 +1,106 @@
+#include "work_stealing_pool.h"
+
+#include <algorithm>
+
+WorkStealingPool::WorkStealingPool(uint32_t threadCount) {
+    if (threadCount == 0) threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+
+    for (uint32_t i = 0; i < threadCount; ++i) queues.push_back(std::make_unique<Queue>());
+    workers.reserve(threadCount);
+    for (uint32_t i = 0; i < threadCount; ++i) workers.emplace_back([this, i] { workerLoop(i); });
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto& worker : workers) worker.join();
+}
+
+void WorkStealingPool::run(size_t count, const Task& fn) {
+    if (count == 0) return;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        task = &fn;
+        remaining = count;
+        error = nullptr;
+    }
+
+    // A worker still leaving the previous run may take these straight away: it reads the
+    // task after popping, under the queue lock that published them
+    const size_t n = queues.size();
+    for (size_t w = 0; w < n; ++w) {
+        std::lock_guard<std::mutex> lock(queues[w]->mutex);
+        for (size_t i = count * w / n; i < count * (w + 1) / n; ++i) queues[w]->items.push_back(i);
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        ++generation;
+    }
+    wake.notify_all();
+
+    std::unique_lock<std::mutex> lock(mutex);
+    finished.wait(lock, [&] { return remaining == 0; });
+    task = nullptr;
+    if (error) {
+        std::exception_ptr e = error;
+        error = nullptr;
+        std::rethrow_exception(e);
+    }
+}
+
+bool WorkStealingPool::take(uint32_t worker, size_t& index) {
+    {
+        Queue& own = *queues[worker];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.items.empty()) {
+            index = own.items.back();
+            own.items.pop_back();
+            return true;
+        }
+    }
+    for (size_t k = 1; k < queues.size(); ++k) {
+        Queue& victim = *queues[(worker + k) % queues.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.items.empty()) {
+            index = victim.items.front();
+            victim.items.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+void WorkStealingPool::workerLoop(uint32_t worker) {
+    uint64_t seen = 0;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [&] { return stopping || generation != seen; });
+            if (stopping) return;
+            seen = generation;
+        }
+
+        size_t index = 0;
+        while (take(worker, index)) {
+            const Task* current = nullptr;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (!error) current = task;
+            }
+            if (current) {
+                try {
+                    (*current)(index, worker);
+                } catch (...) {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    if (!error) error = std::current_exception();
+                }
+            }
+
+            std::lock_guard<std::mutex> lock(mutex);
+            if (--remaining == 0) finished.notify_all();
+        }
+    }
+}
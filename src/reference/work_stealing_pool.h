@@ -0,0 +1,64 @@
+#pragma once
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * WorkStealingPool
+ * ================
+ * Persistent worker threads for the reference tracer's image tiles. run() deals the task
+ * indices out as one contiguous range per worker; each worker takes from the back of its
+ * own deque and, once that is empty, steals from the front of the others'. Tiles around
+ * the photon ring cost many times a sky tile, so a static split would leave most threads
+ * idle at the end of a frame; stealing from the far end of a victim's range keeps the
+ * stolen work away from the tiles the victim is about to take.
+ *
+ * Tasks are coarse (a tile is milliseconds of work), so each deque is a mutex-guarded
+ * std::deque rather than a lock-free Chase-Lev queue: the locks are never contended long.
+ */
+class WorkStealingPool {
+public:
+    using Task = std::function<void(size_t index, uint32_t worker)>;
+
+    // threadCount 0: one worker per hardware thread
+    explicit WorkStealingPool(uint32_t threadCount = 0);
+    ~WorkStealingPool();
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    uint32_t getThreadCount() const { return static_cast<uint32_t>(workers.size()); }
+
+    // Runs task(i, worker) for every i in [0, count) and returns when all have finished;
+    // worker < getThreadCount() identifies the thread, for per-thread scratch. The first
+    // exception a task throws is rethrown here; the remaining tasks are skipped.
+    void run(size_t count, const Task& task);
+
+private:
+    struct Queue {
+        std::mutex         mutex;
+        std::deque<size_t> items;
+    };
+
+    void workerLoop(uint32_t worker);
+    bool take(uint32_t worker, size_t& index);
+
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<std::thread>            workers;
+
+    std::mutex              mutex;         // everything below
+    std::condition_variable wake;
+    std::condition_variable finished;
+    const Task*             task       = nullptr;
+    uint64_t                generation = 0;    // bumped by every run()
+    size_t                  remaining  = 0;
+    std::exception_ptr      error;
+    bool                    stopping   = false;
+};
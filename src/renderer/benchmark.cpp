@@ -0,0 +1,228 @@
+#include "benchmark.h"
+#include "vulkan_context.h"
+#include "frame_scheduler.h"
+#include "offscreen_target.h"
+#include "gpu_profiler.h"
+
+#include <stdexcept>
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <numeric>
+
+namespace {
+    constexpr uint32_t kStageCount = static_cast<uint32_t>(GpuProfiler::Stage::Count);
+
+    std::string jsonEscape(const std::string& s) {
+        std::string out;
+        for (char c : s) {
+            if (c == '"' || c == '\\') {
+                out += '\\';
+                out += c;
+            } else if (static_cast<unsigned char>(c) < 0x20) {
+                char buf[8];
+                std::snprintf(buf, sizeof(buf), "\\u%04x", static_cast<unsigned>(c));
+                out += buf;
+            } else {
+                out += c;
+            }
+        }
+        return out;
+    }
+}
+
+Benchmark::Benchmark(VulkanContext& context, uint32_t frames, const std::string& shaderSpvPath,
+                     ComputePipelineOptions pipelineOptions, const BenchmarkSettings& benchmarkSettings)
+    : ctx(context), framesInFlight(std::max(frames, 1u)), shaderPath(shaderSpvPath),
+      options(pipelineOptions), settings(benchmarkSettings) {
+    if (settings.frames == 0) throw std::runtime_error("[Benchmark] Needs at least one measured frame.");
+    settings.fps = std::max(settings.fps, 1.0f);
+
+    // Same work every frame, and every frame timed
+    options.dynamicResolution = false;
+    options.profiling = true;
+}
+
+std::vector<BenchmarkScenario> Benchmark::defaultScenarios(VkExtent2D size) {
+    // Pitch is SceneParams::pitch (1.2 rad) + y * 0.001, distance 8 * zoom from the hole
+    return {
+        { "far",         size,                      CameraData{ 0.0f,     0.0f, 3.0f, 0.0f } },
+        { "edge-on",     size,                      CameraData{ 0.0f, -1150.0f, 1.0f, 0.0f } },   // ~0.05 rad above the disk
+        { "photon-ring", size,                      CameraData{ 0.0f, -1050.0f, 0.5f, 0.0f } },   // close, grazing the ring
+        { "4k",          VkExtent2D{ 3840, 2160 },  CameraData{ 0.0f,     0.0f, 1.0f, 0.0f } },
+    };
+}
+
+void Benchmark::run(const std::vector<BenchmarkScenario>& scenarios) {
+    std::vector<Result> results;
+    for (const BenchmarkScenario& scenario : scenarios) {
+        if (!settings.scenarios.empty() &&
+            std::find(settings.scenarios.begin(), settings.scenarios.end(), scenario.name) == settings.scenarios.end()) {
+            continue;
+        }
+        std::cout << "[Benchmark] " << scenario.name << " at " << scenario.size.width << "x" << scenario.size.height
+                  << ": " << settings.warmupFrames << " warm-up + " << settings.frames << " frames\n";
+        results.push_back(runScenario(scenario));
+
+        const Result& r = results.back();
+        std::cout << std::fixed << std::setprecision(2)
+                  << "[Benchmark]   gpu " << r.gpuMs.avg << " avg / " << r.gpuMs.p50 << " p50 / " << r.gpuMs.p99
+                  << " p99 ms, trace " << r.traceMs.avg << " ms, " << std::setprecision(1)
+                  << r.raysPerSecond / 1e6 << " Mrays/s, " << r.wallFps << " fps\n";
+        std::cout.unsetf(std::ios::fixed);
+        std::cout << std::setprecision(6);
+    }
+    if (results.empty()) throw std::runtime_error("[Benchmark] No scenario matches the selection.");
+
+    std::ofstream out(settings.outputPath, std::ios::trunc);
+    if (!out) throw std::runtime_error("[Benchmark] Failed to open " + settings.outputPath);
+    if (std::filesystem::path(settings.outputPath).extension() == ".csv") {
+        writeCsv(out, results);
+    } else {
+        writeJson(out, results);
+    }
+    if (!out) throw std::runtime_error("[Benchmark] Failed to write " + settings.outputPath);
+    std::cout << "[Benchmark] Wrote " << settings.outputPath << "\n";
+}
+
+Benchmark::Result Benchmark::runScenario(const BenchmarkScenario& scenario) {
+    Result result;
+    result.scenario = scenario;
+
+    // Destroyed bottom-up: the pipeline first, the scheduler (which drains) last
+    FrameScheduler scheduler(ctx, framesInFlight);
+    OffscreenTarget target(ctx, scenario.size, framesInFlight);
+    ComputePipeline compute(ctx, target, scheduler, shaderPath, options);
+
+    GpuProfiler* profiler = compute.getProfiler();
+    if (!profiler || !profiler->isAvailable()) {
+        throw std::runtime_error("[Benchmark] The device provides no GPU timestamps.");
+    }
+    result.samplesPerPixel = compute.getSamplesPerPixel();
+
+    // Results of a frame are read when its slot comes around again, framesInFlight
+    // dispatches later; a stage whose sample count moved has a new lastMs()
+    std::vector<float> gpuMs, traceMs;
+    std::array<uint64_t, kStageCount> seen{};
+    uint32_t timedFrames = 0;
+    auto collectFrame = [&] {
+        float total = 0.0f;
+        bool  fresh = false, traced = false;
+        for (uint32_t s = 0; s < kStageCount; ++s) {
+            const auto stage = static_cast<GpuProfiler::Stage>(s);
+            if (profiler->sampleCount(stage) == seen[s]) continue;
+            seen[s] = profiler->sampleCount(stage);
+            total += profiler->lastMs(stage);
+            fresh = true;
+            traced = traced || stage == GpuProfiler::Stage::Trace;
+        }
+        if (!fresh) return;
+        if (timedFrames++ < settings.warmupFrames) return;
+        gpuMs.push_back(total);
+        if (traced) traceMs.push_back(profiler->lastMs(GpuProfiler::Stage::Trace));
+    };
+
+    using Clock = std::chrono::steady_clock;
+    const uint32_t totalFrames = settings.warmupFrames + settings.frames;
+    Clock::time_point measureStart = Clock::now();
+    for (uint32_t i = 0; i < totalFrames; ++i) {
+        if (i == settings.warmupFrames) measureStart = Clock::now();
+
+        const uint32_t slot = scheduler.beginFrame();
+        CameraData camera = scenario.camera;
+        camera.time += static_cast<float>(i) / settings.fps;
+        compute.dispatch(slot, VK_NULL_HANDLE, VK_NULL_HANDLE, camera);
+        scheduler.endFrame();
+        collectFrame();
+    }
+
+    // The last framesInFlight frames were never collected; read them oldest first
+    scheduler.waitIdle();
+    const std::chrono::duration<double> elapsed = Clock::now() - measureStart;
+    for (uint32_t i = 1; i <= framesInFlight; ++i) {
+        profiler->collect((scheduler.getFrameSlot() + i) % framesInFlight);
+        collectFrame();
+    }
+
+    if (traceMs.empty()) throw std::runtime_error("[Benchmark] No trace timestamps were read for " + scenario.name);
+    result.frames = static_cast<uint32_t>(gpuMs.size());
+    result.gpuMs = summarize(gpuMs);
+    result.traceMs = summarize(traceMs);
+    const double rays = static_cast<double>(scenario.size.width) * scenario.size.height * result.samplesPerPixel;
+    result.raysPerSecond = result.traceMs.avg > 0.0f ? rays / (result.traceMs.avg * 1e-3) : 0.0;
+    result.wallFps = elapsed.count() > 0.0 ? settings.frames / elapsed.count() : 0.0;
+    return result;
+}
+
+Benchmark::Summary Benchmark::summarize(std::vector<float> samples) {
+    Summary s;
+    if (samples.empty()) return s;
+    std::sort(samples.begin(), samples.end());
+    // Nearest rank, like GpuProfiler's p99
+    const auto rank = [&](double p) {
+        const size_t r = static_cast<size_t>(std::ceil(p * samples.size()));
+        return samples[std::clamp<size_t>(r, 1, samples.size()) - 1];
+    };
+    s.avg = static_cast<float>(std::accumulate(samples.begin(), samples.end(), 0.0) / samples.size());
+    s.p50 = rank(0.50);
+    s.p99 = rank(0.99);
+    s.min = samples.front();
+    s.max = samples.back();
+    return s;
+}
+
+void Benchmark::writeJson(std::ostream& out, const std::vector<Result>& results) const {
+    VkPhysicalDeviceProperties props{};
+    vkGetPhysicalDeviceProperties(ctx.getPhysicalDevice(), &props);
+
+    const auto summary = [&](const char* name, const Summary& s) {
+        out << "      \"" << name << "\": { \"avg\": " << s.avg << ", \"p50\": " << s.p50 << ", \"p99\": " << s.p99
+            << ", \"min\": " << s.min << ", \"max\": " << s.max << " },\n";
+    };
+
+    out << std::setprecision(6);
+    out << "{\n";
+    out << "  \"device\": \"" << jsonEscape(props.deviceName) << "\",\n";
+    out << "  \"driver_version\": " << props.driverVersion << ",\n";
+    out << "  \"warmup_frames\": " << settings.warmupFrames << ",\n";
+    out << "  \"frames\": " << settings.frames << ",\n";
+    out << "  \"time_step\": " << 1.0f / settings.fps << ",\n";
+    out << "  \"scenarios\": [\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const Result& r = results[i];
+        out << "    {\n";
+        out << "      \"name\": \"" << jsonEscape(r.scenario.name) << "\",\n";
+        out << "      \"width\": " << r.scenario.size.width << ",\n";
+        out << "      \"height\": " << r.scenario.size.height << ",\n";
+        out << "      \"samples_per_pixel\": " << r.samplesPerPixel << ",\n";
+        out << "      \"timed_frames\": " << r.frames << ",\n";
+        summary("gpu_ms", r.gpuMs);
+        summary("trace_ms", r.traceMs);
+        out << "      \"rays_per_second\": " << std::llround(r.raysPerSecond) << ",\n";
+        out << "      \"wall_fps\": " << r.wallFps << "\n";
+        out << "    }" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n";
+    out << "}\n";
+}
+
+void Benchmark::writeCsv(std::ostream& out, const std::vector<Result>& results) const {
+    out << std::setprecision(6);
+    out << "scenario,width,height,samples_per_pixel,timed_frames,"
+           "gpu_avg_ms,gpu_p50_ms,gpu_p99_ms,gpu_min_ms,gpu_max_ms,"
+           "trace_avg_ms,trace_p50_ms,trace_p99_ms,trace_min_ms,trace_max_ms,"
+           "rays_per_second,wall_fps\n";
+    for (const Result& r : results) {
+        out << r.scenario.name << "," << r.scenario.size.width << "," << r.scenario.size.height << ","
+            << r.samplesPerPixel << "," << r.frames << ","
+            << r.gpuMs.avg << "," << r.gpuMs.p50 << "," << r.gpuMs.p99 << "," << r.gpuMs.min << "," << r.gpuMs.max << ","
+            << r.traceMs.avg << "," << r.traceMs.p50 << "," << r.traceMs.p99 << "," << r.traceMs.min << ","
+            << r.traceMs.max << "," << std::llround(r.raysPerSecond) << "," << r.wallFps << "\n";
+    }
+}
@@ -0,0 +1,82 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+#include "compute_pipeline.h"
+
+class VulkanContext;
+
+// One canned camera: traced at size for warmup + frames frames, time advancing from camera.time
+struct BenchmarkScenario {
+    std::string name;
+    VkExtent2D  size{ 1920, 1080 };
+    CameraData  camera{};
+};
+
+struct BenchmarkSettings {
+    uint32_t    warmupFrames = 30;                 // traced but not measured (pipelines, clocks, caches)
+    uint32_t    frames       = 240;                // measured frames per scenario
+    float       fps          = 30.0f;              // time step of the deterministic clock
+    std::string outputPath   = "benchmark.json";   // a .csv extension writes CSV instead
+    std::vector<std::string> scenarios;            // names to run; empty: all of them
+};
+
+/**
+ * Benchmark
+ * =========
+ * Reproducible GPU performance numbers (--benchmark). Every scenario gets its own
+ * scheduler, offscreen target and pipeline on one headless context and traces a fixed
+ * camera with time advancing by exactly 1 / fps per frame, so two runs trace the same
+ * rays. After the warm-up frames, GpuProfiler timestamps of every frame are kept (none
+ * are dropped: results are drained after the last frame) and reduced to avg / p50 / p99.
+ *
+ * gpu_ms is the sum of the frame's profiled stages, trace_ms the trace dispatch alone;
+ * rays per second counts camera rays, width * height * samples per pixel per trace_ms.
+ * With --classify or --adaptive that sample count is an upper bound.
+ */
+class Benchmark {
+public:
+    // Dynamic resolution is turned off (fixed work per frame) and profiling on; the rest
+    // of options is benchmarked as given. The context must outlive the benchmark.
+    Benchmark(VulkanContext& context, uint32_t framesInFlight, const std::string& shaderSpvPath,
+              ComputePipelineOptions options, const BenchmarkSettings& settings);
+
+    Benchmark(const Benchmark&) = delete;
+    Benchmark& operator=(const Benchmark&) = delete;
+
+    // Runs the selected scenarios, prints a summary and writes the report
+    void run(const std::vector<BenchmarkScenario>& scenarios);
+
+    // Far view, edge-on disk and photon-ring grazing at size, plus the default view at 4K
+    static std::vector<BenchmarkScenario> defaultScenarios(VkExtent2D size);
+
+private:
+    struct Summary {
+        float avg = 0.0f, p50 = 0.0f, p99 = 0.0f, min = 0.0f, max = 0.0f;
+    };
+
+    struct Result {
+        BenchmarkScenario scenario;
+        uint32_t          samplesPerPixel = 1;
+        uint32_t          frames          = 0;       // measured frames with timestamps
+        Summary           gpuMs;
+        Summary           traceMs;
+        double            raysPerSecond   = 0.0;
+        double            wallFps         = 0.0;     // host-side, including submission
+    };
+
+    Result  runScenario(const BenchmarkScenario& scenario);
+    static Summary summarize(std::vector<float> samples);
+
+    void writeJson(std::ostream& out, const std::vector<Result>& results) const;
+    void writeCsv(std::ostream& out, const std::vector<Result>& results) const;
+
+    VulkanContext&         ctx;
+    uint32_t               framesInFlight = 3;
+    std::string            shaderPath;
+    ComputePipelineOptions options;
+    BenchmarkSettings      settings;
+};
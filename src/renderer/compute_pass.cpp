@@ -0,0 +1,94 @@
+#include "compute_pass.h"
+#include "vulkan_context.h"
+
+#include <stdexcept>
+#include <utility>
+
+ComputePass::ComputePass(VulkanContext& context, MappedFile spirv,
+                         const std::vector<VkDescriptorSetLayout>& setLayouts,
+                         uint32_t pushConstantSize,
+                         const VkSpecializationInfo* specialization)
+    : device(context.getDevice()), cache(context.getPipelineCache()), code(std::move(spirv)) {
+
+    VkPushConstantRange pushConstant{};
+    pushConstant.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    pushConstant.offset = 0;
+    pushConstant.size = pushConstantSize;
+
+    VkPipelineLayoutCreateInfo ci{};
+    ci.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    ci.setLayoutCount = static_cast<uint32_t>(setLayouts.size());
+    ci.pSetLayouts = setLayouts.data();
+    ci.pushConstantRangeCount = pushConstantSize ? 1u : 0u;
+    ci.pPushConstantRanges = pushConstantSize ? &pushConstant : nullptr;
+
+    if (vkCreatePipelineLayout(device, &ci, nullptr, &pipelineLayout) != VK_SUCCESS) {
+        throw std::runtime_error("[ComputePass] Failed to create pipeline layout.");
+    }
+
+    createPipeline(specialization);
+}
+
+ComputePass::~ComputePass() {
+    if (pipeline)       vkDestroyPipeline(device, pipeline, nullptr);
+    if (pipelineLayout) vkDestroyPipelineLayout(device, pipelineLayout, nullptr);
+}
+
+void ComputePass::rebuild(const VkSpecializationInfo* specialization) {
+    if (pipeline) {
+        vkDestroyPipeline(device, pipeline, nullptr);
+        pipeline = VK_NULL_HANDLE;
+    }
+    createPipeline(specialization);
+}
+
+VkShaderModule ComputePass::createShaderModule(VkDevice device, const MappedFile& spirv) {
+    if (spirv.empty() || spirv.size() % sizeof(uint32_t) != 0) {
+        throw std::runtime_error("[ComputePass] SPIR-V size is not a multiple of 4 bytes.");
+    }
+
+    // The mapping is page-aligned, so the words can be read in place
+    VkShaderModuleCreateInfo mci{};
+    mci.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+    mci.codeSize = spirv.size();
+    mci.pCode = reinterpret_cast<const uint32_t*>(spirv.data());
+
+    VkShaderModule mod = VK_NULL_HANDLE;
+    if (vkCreateShaderModule(device, &mci, nullptr, &mod) != VK_SUCCESS) {
+        throw std::runtime_error("[ComputePass] Failed to create shader module.");
+    }
+    return mod;
+}
+
+void ComputePass::createPipeline(const VkSpecializationInfo* specialization) {
+    VkShaderModule mod = createShaderModule(device, code);
+
+    VkPipelineShaderStageCreateInfo stage{};
+    stage.sType  = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    stage.stage  = VK_SHADER_STAGE_COMPUTE_BIT;
+    stage.module = mod;
+    stage.pName  = "main";
+    stage.pSpecializationInfo = specialization;
+
+    VkComputePipelineCreateInfo ci{};
+    ci.sType  = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    ci.stage  = stage;
+    ci.layout = pipelineLayout;
+
+    VkResult res = vkCreateComputePipelines(device, cache, 1, &ci, nullptr, &pipeline);
+    vkDestroyShaderModule(device, mod, nullptr);
+    if (res != VK_SUCCESS) {
+        throw std::runtime_error("[ComputePass] Failed to create compute pipeline.");
+    }
+}
+
+void ComputePass::bind(VkCommandBuffer cmd, const VkDescriptorSet* sets, uint32_t setCount) const {
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
+    if (setCount) {
+        vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout, 0, setCount, sets, 0, nullptr);
+    }
+}
+
+void ComputePass::pushConstants(VkCommandBuffer cmd, const void* data, uint32_t size) const {
+    vkCmdPushConstants(cmd, pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, size, data);
+}
@@ -0,0 +1,49 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <vector>
+#include <cstdint>
+
+#include "../core/mapped_file.h"
+
+class VulkanContext;
+
+/**
+ * ComputePass
+ * ===========
+ * Small owner for an auxiliary compute shader: pipeline layout + pipeline.
+ * Descriptor set layouts, pools and sets stay with the caller so passes can
+ * share sets with the main trace (e.g. the same output image descriptor).
+ * SPIR-V stays mapped for rebuilds; pipelines go through the context's PipelineCache.
+ */
+class ComputePass {
+public:
+    ComputePass(VulkanContext& context, MappedFile spirv,
+                const std::vector<VkDescriptorSetLayout>& setLayouts,
+                uint32_t pushConstantSize,
+                const VkSpecializationInfo* specialization = nullptr);
+    ~ComputePass();
+
+    ComputePass(const ComputePass&) = delete;
+    ComputePass& operator=(const ComputePass&) = delete;
+
+    // Rebuild the pipeline with different specialization constants (layout is kept)
+    void rebuild(const VkSpecializationInfo* specialization);
+
+    void bind(VkCommandBuffer cmd, const VkDescriptorSet* sets, uint32_t setCount) const;
+    void pushConstants(VkCommandBuffer cmd, const void* data, uint32_t size) const;
+
+    VkPipeline       getPipeline() const { return pipeline; }
+    VkPipelineLayout getLayout()   const { return pipelineLayout; }
+
+    // Throws unless spirv is a whole number of 32-bit words
+    static VkShaderModule createShaderModule(VkDevice device, const MappedFile& spirv);
+
+private:
+    void createPipeline(const VkSpecializationInfo* specialization);
+
+    VkDevice          device         = VK_NULL_HANDLE;
+    VkPipelineCache   cache          = VK_NULL_HANDLE;
+    MappedFile        code;
+    VkPipelineLayout  pipelineLayout = VK_NULL_HANDLE;
+    VkPipeline        pipeline       = VK_NULL_HANDLE;
+};
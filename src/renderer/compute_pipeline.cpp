@@ -1,83 +1,337 @@
 #include "compute_pipeline.h"
 #include "vulkan_context.h"
-#include "swapchain.h"
+#include "render_target.h"
+#include "frame_scheduler.h"
+#include "compute_pass.h"
+#include "deflection_lut.h"
+#include "sky_environment.h"
+#include "disk_textures.h"
+#include "workgroup_tuner.h"
+#include "wavefront_tracer.h"
+#include "gpu_memory.h"
 
 #include <stdexcept>
-#include <fstream>
 #include <iostream>
+#include <chrono>
 #include <cstring>
 #include <cassert>
 #include <algorithm>
+#include <cstddef>
+#include <cmath>
+#include <filesystem>
+
+// Must match the constant_id / push_constant layouts in gargantua.comp (and wavefront.comp,
+// which shares the trace constants through trace_common.glsl), upscale.comp and temporal.comp
+namespace {
+    struct TraceSpecConstants {
+        VkBool32 encodeSrgb;       // constant_id = 0
+        int32_t  samplesPerAxis;   // constant_id = 1 (AA)
+        VkBool32 useLut;           // constant_id = 2
+        int32_t  integrator;       // constant_id = 3
+        float    tolerance;        // constant_id = 4
+        float    farFieldRadius;   // constant_id = 5
+        VkBool32 disk;             // constant_id = 6
+        int32_t  diskSteps;        // constant_id = 7
+        int32_t  debugView;        // constant_id = 8
+        VkBool32 skyCubemap;       // constant_id = 9
+        GeodesicSpecConstants geodesic;   // constant_id = 10..13 (geodesic.glsl)
+        VkBool32 diskTextures;     // constant_id = 14
+        int32_t  metric;           // constant_id = 15 (geodesic.glsl)
+        int32_t  blockPass;        // constant_id = 16 (BLOCKS_*)
+        int32_t  blockSize;        // constant_id = 17
+        int32_t  adaptivePass;     // constant_id = 18 (ADAPTIVE_*)
+        float    adaptiveThreshold; // constant_id = 19
+        uint32_t groupWidth;       // local_size_x_id = 20
+        uint32_t groupHeight;      // local_size_y_id = 21
+        VkBool32 rayStats;         // constant_id = 22
+    };
+
+    // The accretion disk (and its raymarch falloff) reaches 10 Rs; stay outside it
+    constexpr float kMinFarFieldRadius = 12.0f;
+
+    // Camera radius = kCameraDistance * zoom (see writeScene); the LUT is baked per radius
+    constexpr float kCameraDistance = 8.0f;
+
+    // Must match SceneState / SCENE_SLOTS in trace_common.glsl (std140: vec4-aligned members)
+    struct SceneUniforms {
+        float cameraToWorld[16];   // column-major; rotation in columns 0-2, position in column 3
+        float lens[4];             // x: focal length
+        float hole[4];             // x: Kerr a/M
+        float disk[4];             // x: rotation speed, y: emission scale
+        float tone[4];             // exposure, gamma, saturation, contrast
+    };
+    static_assert(sizeof(SceneUniforms) == 128, "SceneUniforms must match the std140 SceneState");
+    constexpr uint32_t kSceneSlots = 8;
+
+    // Must match the STAT_* word offsets of RayStats in gargantua.comp
+    constexpr uint32_t kRayStatSamples   = 0;
+    constexpr uint32_t kRayStatSteps     = 1;    // 64-bit, low word first
+    constexpr uint32_t kRayStatFates     = 3;
+    constexpr uint32_t kRayStatCrossings = 6;
+    constexpr uint32_t kRayStatBins      = 14;
+    constexpr uint32_t kRayStatStepBins  = 64;
+    constexpr uint32_t kRayStatWords     = kRayStatBins + kRayStatStepBins;
+
+    struct TracePushConstants {
+        CameraData camera;
+        int32_t    renderWidth;    // pixels actually traced (sub-rect of the target)
+        int32_t    renderHeight;
+        int32_t    tileX;          // traced rect's position in the full image (tiled stills)
+        int32_t    tileY;
+        int32_t    imageWidth;     // resolution rays are generated for
+        int32_t    imageHeight;
+        uint32_t   sceneSlot;      // SceneRing slot of this frame
+    };
+
+    TracePushConstants tracePush(const CameraData& camera, VkExtent2D traced, uint32_t sceneSlot) {
+        const int32_t w = static_cast<int32_t>(traced.width);
+        const int32_t h = static_cast<int32_t>(traced.height);
+        return TracePushConstants{ camera, w, h, 0, 0, w, h, sceneSlot };
+    }
 
-static VkShaderModule createShaderModule(VkDevice device, const std::vector<char>& code) {
-    VkShaderModuleCreateInfo ci{};
-    ci.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-    ci.codeSize = code.size();
-    ci.pCode = reinterpret_cast<const uint32_t*>(code.data());
-    VkShaderModule mod = VK_NULL_HANDLE;
-    if (vkCreateShaderModule(device, &ci, nullptr, &mod) != VK_SUCCESS) {
-        throw std::runtime_error("[Compute] Failed to create shader module.");
+    constexpr float kMaxSpin = 0.998f;   // the Thorne limit; geodesic.glsl clamps the same
+
+    // Pixel edge of a classification block (BLOCK_SIZE): small enough to follow the photon
+    // ring, large enough that five probes per block stay a few percent of the trace
+    constexpr uint32_t kClassifyBlock = 8;
+    enum BlockPass : int32_t { BlocksOff = 0, BlocksClassify = 1, BlocksTrace = 2 };
+    enum AdaptivePass : int32_t { AdaptiveOff = 0, AdaptiveFirst = 1, AdaptiveMark = 2, AdaptiveRefine = 3 };
+
+    struct UpscalePushConstants {
+        int32_t srcWidth, srcHeight;
+        int32_t dstWidth, dstHeight;
+    };
+
+    struct TemporalPushConstants {
+        int32_t  srcWidth, srcHeight;
+        int32_t  dstWidth, dstHeight;
+        uint32_t reset;            // ignore history (camera moved, first frame)
+        float    minBlend;         // weight floor of the new sample
+        float    focalLength;
+        float    pad;
+        float    reproject[3][4];  // mat3: this frame's camera space to the history's
+    };
+
+    // gargantua.comp.spv -> gargantua_fp16.comp.spv (HALF_SHADING build, see CMakeLists.txt)
+    std::string halfShadingPath(const std::string& spvPath) {
+        const std::string suffix = ".comp.spv";
+        if (spvPath.size() < suffix.size() || spvPath.compare(spvPath.size() - suffix.size(), suffix.size(), suffix) != 0) {
+            return spvPath;
+        }
+        return spvPath.substr(0, spvPath.size() - suffix.size()) + "_fp16" + suffix;
+    }
+
+    bool sameView(const CameraData& a, const CameraData& b) {
+        // time is excluded: temporal.comp reprojects the history across the time-driven
+        // orbit, and the history clamp handles disk rotation
+        return a.x == b.x && a.y == b.y && a.zoom == b.zoom;
+    }
+
+    // The orbit camera's rotation (cameraToWorld's upper 3x3), columns right, up, forward:
+    // yaw from time and the x drag, pitch plus the y drag
+    std::array<float, 9> orbitRotation(const CameraData& camera, const SceneParams& scene) {
+        const float yaw   = camera.time * scene.orbitRate + camera.x * 0.001f;
+        const float pitch = scene.pitch + camera.y * 0.001f;
+        const float cx = std::cos(yaw),   sx = std::sin(yaw);
+        const float cy = std::cos(pitch), sy = std::sin(pitch);
+        return { cx, 0.0f, sx,   -sx * sy, cy, cx * sy,   -sx * cy, -sy, cx * cy };
     }
-    return mod;
-}
 
-std::vector<char> ComputePipeline::readFile(const std::string& path) {
-    std::ifstream file(path, std::ios::ate | std::ios::binary);
-    if (!file) throw std::runtime_error(std::string("[Compute] Failed to open shader file: ") + path);
-    size_t size = static_cast<size_t>(file.tellg());
-    std::vector<char> buf(size);
-    file.seekg(0);
-    file.read(buf.data(), size);
-    return buf;
+    VkSpecializationMapEntry encodeSrgbEntry() {
+        VkSpecializationMapEntry e{};
+        e.constantID = 0;
+        e.offset = 0;
+        e.size = sizeof(VkBool32);
+        return e;
+    }
 }
 
-ComputePipeline::ComputePipeline(VulkanContext& context, Swapchain& swapchain, const std::string& shaderSpvPath)
-    : ctx(context), sc(swapchain), device(context.getDevice()) {
+ComputePipeline::ComputePipeline(VulkanContext& context, RenderTarget& renderTarget, FrameScheduler& frameScheduler,
+                                 const std::string& shaderSpvPath, const ComputePipelineOptions& options)
+    : ctx(context), target(renderTarget), scheduler(frameScheduler), device(context.getDevice()) {
+
+    frames.resize(scheduler.getFramesInFlight());
+    if (frames.size() > kSceneSlots) {
+        throw std::runtime_error("[Compute] More frames in flight than scene ring slots.");
+    }
+
+    // Exclusive storage images need explicit ownership transfers when the trace and the blit
+    // run on different queue families. Same family: plain barriers, the queues still overlap.
+    asyncCompute      = options.asyncCompute;
+    ownershipTransfer = asyncCompute && ctx.getComputeQueueFamily() != ctx.getGraphicsQueueFamily();
+
+    // Zero-copy: write straight into the target (swapchain) images when they carry STORAGE usage
+    allowDirectOutput = options.directToSwapchain;
+    directOutput      = allowDirectOutput && target.hasStorageUsage();
+
+    dynamicResolution = options.dynamicResolution;
+    targetFrameMs     = std::max(options.targetFrameMs, 1.0f);
+    minRenderScale    = std::clamp(options.minRenderScale, 0.25f, 1.0f);
+    renderExtent      = target.getExtent();
+
+    temporalAccumulation = options.temporalAccumulation;
+    maxHistoryFrames     = std::max(options.maxHistoryFrames, 1u);
+
+    integrator          = options.integrator;
+    integratorTolerance = std::max(options.integratorTolerance, 1e-8f);
+    metric              = options.metric;
+    spin                = std::clamp(options.spin, -kMaxSpin, kMaxSpin);
+    farFieldRadius      = options.farFieldRadius > 0.0f ? std::max(options.farFieldRadius, kMinFarFieldRadius) : 0.0f;
+    variant             = sanitize(options.variant);
+    scene               = options.scene;
 
     // 1) Read shader first
-    shaderCode = readFile(shaderSpvPath);
+    //    Mixed-precision shading needs shaderFloat16 and the fp16 build next to the fp32 one
+    halfShading = options.halfShading && ctx.supportsShaderFloat16();
+    if (halfShading && !std::filesystem::exists(halfShadingPath(shaderSpvPath))) {
+        std::cerr << "[Compute] Warning: " << halfShadingPath(shaderSpvPath) << " missing; fp32 shading.\n";
+        halfShading = false;
+    }
+    shaderCode = MappedFile(halfShading ? halfShadingPath(shaderSpvPath) : shaderSpvPath);
+    const std::string shaderDir = std::filesystem::path(shaderSpvPath).parent_path().string();
 
     // 2) Create Vulkan objects
+    rayStatistics = options.rayStatistics;
+    if (options.profiling || dynamicResolution || rayStatistics) {
+        profiler = std::make_unique<GpuProfiler>(ctx, static_cast<uint32_t>(frames.size()), options.pipelineStatistics);
+        if (dynamicResolution && !profiler->isAvailable()) {
+            std::cerr << "[Compute] Warning: no GPU timestamps; dynamic resolution disabled.\n";
+            dynamicResolution = false;
+        }
+    }
+    bool deflectionLut = options.deflectionLut;
+    if (deflectionLut && metric == GeodesicMetric::Kerr) {
+        std::cerr << "[Compute] Warning: the deflection LUT is Schwarzschild only; disabled for Kerr.\n";
+        deflectionLut = false;
+    }
+    lut = std::make_unique<DeflectionLut>(ctx, shaderDir, deflectionLut, GeodesicSpecConstants::from(variant));
+    sky = std::make_unique<SkyEnvironment>(ctx, shaderDir, options.skyFaceSize);
+    disk = std::make_unique<DiskTextures>(ctx, shaderDir, options.diskTextures);
+    createSceneRing();
     createDescriptorSetLayout();
     createPipelineLayout();
-    createPipelineFromCode(shaderCode);
-    createStorageImage();
+    if (options.wavefront && lut->isEnabled()) {
+        std::cerr << "[Compute] Warning: the deflection LUT already skips integration; wavefront mode ignored.\n";
+    } else if (options.wavefront) {
+        const std::string wavefrontPath = shaderDir + "/wavefront.comp.spv";
+        wavefront = std::make_unique<WavefrontTracer>(ctx, halfShading ? halfShadingPath(wavefrontPath) : wavefrontPath,
+                                                      descriptorSetLayout, sky->getSetLayout(), disk->getSetLayout());
+    }
+    if (rayStatistics && wavefront) {
+        std::cerr << "[Compute] Warning: ray statistics need the per-pixel trace; disabled in wavefront mode.\n";
+        rayStatistics = false;
+    }
+    // After the wavefront check: the readback exists only while statistics are collected
+    createRayStatsBuffers();
+    blockClassification = options.blockClassification;
+    adaptiveSampling    = options.adaptiveSampling;
+    adaptiveThreshold   = std::max(options.adaptiveThreshold, 0.0f);
+    if ((blockClassification || adaptiveSampling) && temporalAccumulation) {
+        std::cerr << "[Compute] Warning: block classification and adaptive sampling need temporal "
+                     "accumulation off; disabled.\n";
+        blockClassification = adaptiveSampling = false;
+    } else if ((blockClassification || adaptiveSampling) && wavefront) {
+        std::cerr << "[Compute] Warning: block classification and adaptive sampling are not supported "
+                     "in wavefront mode; disabled.\n";
+        blockClassification = adaptiveSampling = false;
+    } else if (blockClassification && adaptiveSampling) {
+        std::cerr << "[Compute] Warning: adaptive sampling replaces block classification.\n";
+        blockClassification = false;
+    }
+    const auto buildStart = std::chrono::steady_clock::now();
+    selectTracePipeline();
+    const std::chrono::duration<float, std::milli> buildMs = std::chrono::steady_clock::now() - buildStart;
+    std::cout << "[Compute] Trace pipeline built in " << buildMs.count() << " ms\n";
+    if (temporalAccumulation) {
+        createTemporalPass(shaderDir);
+    } else if (dynamicResolution) {
+        createUpscalePass(shaderDir);
+    }
+    targetGeneration = target.getGeneration();
+    createStorageImages();
     createDescriptorPoolAndSets();
     allocateCommandBuffers();
 
-    // internal semaphore (compute -> graphics)
-    VkSemaphoreCreateInfo sci{ VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO };
-    if (vkCreateSemaphore(device, &sci, nullptr, &computeFinished_) != VK_SUCCESS) {
-        throw std::runtime_error("[Compute] Failed to create internal semaphore.");
+    // Workgroup shape: this device's stored winner, else a one-time benchmark
+    if (options.workgroupTuning != WorkgroupTuning::Off && !wavefront) {
+        VkExtent2D stored{};
+        if (options.workgroupTuning == WorkgroupTuning::Auto
+            && WorkgroupTuner(ctx, scheduler, traceQueue()).load(stored)) {
+            variant.groupWidth = stored.width;
+            variant.groupHeight = stored.height;
+            selectTracePipeline();
+        } else {
+            autotuneWorkgroup();
+        }
     }
 
-    std::cout << "[Compute] Pipeline ready (offscreen storage image + blit).\n";
+    std::cout << "[Compute] Pipeline ready (" << frames.size() << " frames in flight, "
+              << (directOutput ? "direct swapchain writes, " : "offscreen storage image + blit, ")
+              << (asyncCompute ? (ownershipTransfer ? "async compute queue" : "async, shared queue family")
+                               : "serialized on graphics queue")
+              << (dynamicResolution ? ", dynamic resolution" : "")
+              << (temporalAccumulation ? ", temporal accumulation" : "")
+              << (lut->isEnabled() ? ", deflection LUT" : "")
+              << (sky->isEnabled() ? ", baked sky" : "")
+              << (disk->isEnabled() ? ", disk textures" : "")
+              << (wavefront ? ", wavefront" : "")
+              << (blockClassification ? ", block classification" : "")
+              << (adaptiveSampling ? ", adaptive sampling" : "")
+              << (halfShading ? ", fp16 shading" : "")
+              << (integrator == GeodesicIntegrator::DormandPrince ? ", RK45" : ", RK4")
+              << (metric == GeodesicMetric::Kerr ? ", Kerr" : "")
+              << ", " << variant.groupWidth << "x" << variant.groupHeight << " workgroups).\n";
 }
 
 ComputePipeline::~ComputePipeline() {
     VkDevice dev = device;
 
-    if (computeFinished_)     { vkDestroySemaphore(dev, computeFinished_, nullptr); computeFinished_ = VK_NULL_HANDLE; }
+    // Frames may still be executing; drain the timelines and run pending deferred frees,
+    // the target-sized resources included
+    retireStorageImages();
+    scheduler.waitIdle();
+
+    profiler.reset();
+    upscalePass.reset();
+    temporalPass.reset();
+    wavefront.reset();
     if (descriptorPool)       vkDestroyDescriptorPool(dev, descriptorPool, nullptr);
-    if (pipeline)             vkDestroyPipeline(dev, pipeline, nullptr);
+    for (const auto& built : tracePipelines) vkDestroyPipeline(dev, built.second, nullptr);
+    for (const auto& built : auxBuilt) {
+        for (VkPipeline p : built.second) if (p) vkDestroyPipeline(dev, p, nullptr);
+    }
     if (pipelineLayout)       vkDestroyPipelineLayout(dev, pipelineLayout, nullptr);
     if (descriptorSetLayout)  vkDestroyDescriptorSetLayout(dev, descriptorSetLayout, nullptr);
-
-    destroyStorageImage();
+    lut.reset();
+    sky.reset();
+    disk.reset();
+
+    spareMemory.reset();
+    if (sceneRing.buffer) vkDestroyBuffer(dev, sceneRing.buffer, nullptr);
+    ctx.getMemory().free(sceneRing.memory);
+    if (rayStats.buffer) vkDestroyBuffer(dev, rayStats.buffer, nullptr);
+    ctx.getMemory().free(rayStats.memory);
+    if (rayStatsReadback.buffer) vkDestroyBuffer(dev, rayStatsReadback.buffer, nullptr);
+    ctx.getMemory().free(rayStatsReadback.memory);
     // Command buffers are freed with their pools in VulkanContext
 }
 
 void ComputePipeline::createDescriptorSetLayout() {
-    VkDescriptorSetLayoutBinding binding{};
-    binding.binding = 0;
-    binding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
-    binding.descriptorCount = 1;
-    binding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    // binding 0: output/trace image; 1-3: block classes, refine list, first samples; 4: scene
+    // ring; 5: ray stats (1-5 trace only, the resolve passes share the layout and ignore them)
+    VkDescriptorSetLayoutBinding bindings[6]{};
+    for (uint32_t b = 0; b < 6; ++b) {
+        bindings[b].binding = b;
+        bindings[b].descriptorType = b == 0 ? VK_DESCRIPTOR_TYPE_STORAGE_IMAGE
+                                   : b == 4 ? VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER : VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        bindings[b].descriptorCount = 1;
+        bindings[b].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    }
 
     VkDescriptorSetLayoutCreateInfo ci{};
     ci.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
-    ci.bindingCount = 1;
-    ci.pBindings = &binding;
+    ci.bindingCount = 6;
+    ci.pBindings = bindings;
 
     if (vkCreateDescriptorSetLayout(device, &ci, nullptr, &descriptorSetLayout) != VK_SUCCESS) {
         throw std::runtime_error("[Compute] Failed to create descriptor set layout.");
@@ -88,12 +342,16 @@ void ComputePipeline::createPipelineLayout() {
     VkPushConstantRange pushConstant{};
     pushConstant.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
     pushConstant.offset = 0;
-    pushConstant.size = sizeof(CameraData);
+    pushConstant.size = sizeof(TracePushConstants);
+
+    // set 0: output/trace target, set 1: deflection LUT, set 2: sky cubemap, set 3: disk textures
+    VkDescriptorSetLayout setLayouts[4] = { descriptorSetLayout, lut->getSetLayout(), sky->getSetLayout(),
+                                            disk->getSetLayout() };
 
     VkPipelineLayoutCreateInfo ci{};
     ci.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-    ci.setLayoutCount = 1;
-    ci.pSetLayouts = &descriptorSetLayout;
+    ci.setLayoutCount = 4;
+    ci.pSetLayouts = setLayouts;
     ci.pushConstantRangeCount = 1;
     ci.pPushConstantRanges = &pushConstant;
 
@@ -102,94 +360,654 @@ void ComputePipeline::createPipelineLayout() {
     }
 }
 
-void ComputePipeline::createPipelineFromCode(const std::vector<char>& code) {
-    VkShaderModule mod = createShaderModule(device, code);
+TraceVariant ComputePipeline::sanitize(TraceVariant v) const {
+    v.samplesPerAxis = std::clamp(v.samplesPerAxis, 1, 4);
+    v.maxSteps       = std::clamp(v.maxSteps, 16, 10000);
+    v.stepSize       = std::clamp(v.stepSize, 0.005f, 1.0f);
+    v.diskSteps      = std::clamp(v.diskSteps, 1, 64);
+
+    VkPhysicalDeviceProperties props{};
+    vkGetPhysicalDeviceProperties(ctx.getPhysicalDevice(), &props);
+    const auto& limits = props.limits;
+    if (v.groupWidth == 0 || v.groupHeight == 0
+        || v.groupWidth > limits.maxComputeWorkGroupSize[0] || v.groupHeight > limits.maxComputeWorkGroupSize[1]
+        || v.groupWidth * v.groupHeight > limits.maxComputeWorkGroupInvocations) {
+        std::cerr << "[Compute] Warning: workgroup " << v.groupWidth << "x" << v.groupHeight
+                  << " exceeds device limits; using 16x16.\n";
+        v.groupWidth = 16;
+        v.groupHeight = 16;
+    }
+    return v;
+}
+
+// Data must outlive the pipeline build; info points into the other members
+struct ComputePipeline::TraceSpecialization {
+    TraceSpecConstants                    data{};
+    std::vector<VkSpecializationMapEntry> entries;
+    VkSpecializationInfo                  info{};
+};
+
+void ComputePipeline::fillTraceSpecialization(const TraceVariant& v, TraceSpecialization& spec) const {
+    // Direct output targets a UNORM swapchain; encode to sRGB in the shader so the image
+    // matches what the UNORM -> SRGB blit produces on the fallback path. When a resolve
+    // pass follows, the trace writes the linear intermediate and the resolve encodes.
+    // Temporal accumulation supplies the supersampling over time: 1 jittered sample per frame.
+    TraceSpecConstants& specData = spec.data;
+    specData.encodeSrgb = (directOutput && !usesTraceTarget()) ? VK_TRUE : VK_FALSE;
+    specData.samplesPerAxis = temporalAccumulation ? 1 : v.samplesPerAxis;
+    specData.useLut = lut->isEnabled() ? VK_TRUE : VK_FALSE;
+    specData.integrator = static_cast<int32_t>(integrator);
+    specData.tolerance = integratorTolerance;
+    specData.farFieldRadius = farFieldRadius;
+    specData.disk = v.disk ? VK_TRUE : VK_FALSE;
+    specData.diskSteps = v.diskSteps;
+    specData.debugView = static_cast<int32_t>(v.debugView);
+    specData.skyCubemap = sky->isEnabled() ? VK_TRUE : VK_FALSE;
+    specData.geodesic = GeodesicSpecConstants::from(v);
+    specData.diskTextures = disk->isEnabled() ? VK_TRUE : VK_FALSE;
+    specData.metric = static_cast<int32_t>(metric);
+    // Nothing to save when the variant takes one sample anyway
+    specData.blockPass = (blockClassification && v.samplesPerAxis > 1) ? BlocksTrace : BlocksOff;
+    specData.blockSize = static_cast<int32_t>(kClassifyBlock);
+    specData.adaptivePass = (adaptiveSampling && v.samplesPerAxis > 1) ? AdaptiveFirst : AdaptiveOff;
+    specData.adaptiveThreshold = adaptiveThreshold;
+    specData.groupWidth = v.groupWidth;
+    specData.groupHeight = v.groupHeight;
+    specData.rayStats = rayStatistics ? VK_TRUE : VK_FALSE;
+
+    spec.entries = {
+        encodeSrgbEntry(),
+        { 1, offsetof(TraceSpecConstants, samplesPerAxis), sizeof(int32_t) },
+        { 2, offsetof(TraceSpecConstants, useLut),         sizeof(VkBool32) },
+        { 3, offsetof(TraceSpecConstants, integrator),     sizeof(int32_t) },
+        { 4, offsetof(TraceSpecConstants, tolerance),      sizeof(float) },
+        { 5, offsetof(TraceSpecConstants, farFieldRadius), sizeof(float) },
+        { 6, offsetof(TraceSpecConstants, disk),           sizeof(VkBool32) },
+        { 7, offsetof(TraceSpecConstants, diskSteps),      sizeof(int32_t) },
+        { 8, offsetof(TraceSpecConstants, debugView),      sizeof(int32_t) },
+        { 9, offsetof(TraceSpecConstants, skyCubemap),     sizeof(VkBool32) },
+        { 14, offsetof(TraceSpecConstants, diskTextures),  sizeof(VkBool32) },
+        { 15, offsetof(TraceSpecConstants, metric),        sizeof(int32_t) },
+        { 16, offsetof(TraceSpecConstants, blockPass),     sizeof(int32_t) },
+        { 17, offsetof(TraceSpecConstants, blockSize),     sizeof(int32_t) },
+        { 18, offsetof(TraceSpecConstants, adaptivePass),  sizeof(int32_t) },
+        { 19, offsetof(TraceSpecConstants, adaptiveThreshold), sizeof(float) },
+        { 20, offsetof(TraceSpecConstants, groupWidth),    sizeof(uint32_t) },
+        { 21, offsetof(TraceSpecConstants, groupHeight),   sizeof(uint32_t) },
+        { 22, offsetof(TraceSpecConstants, rayStats),      sizeof(VkBool32) },
+    };
+    spec.entries[0].offset = offsetof(TraceSpecConstants, encodeSrgb);
+    GeodesicSpecConstants::appendEntries(spec.entries, offsetof(TraceSpecConstants, geodesic));
+
+    spec.info.mapEntryCount = static_cast<uint32_t>(spec.entries.size());
+    spec.info.pMapEntries = spec.entries.data();
+    spec.info.dataSize = sizeof(spec.data);
+    spec.info.pData = &spec.data;
+}
+
+VkPipeline ComputePipeline::createTracePipeline(const TraceVariant& v, int auxPass) const {
+    VkShaderModule mod = ComputePass::createShaderModule(device, shaderCode);
+
+    // Auxiliary passes are the same module and layout, so they share the trace's bound sets
+    TraceSpecialization spec;
+    fillTraceSpecialization(v, spec);
+    if (auxPass == ClassifyPass) spec.data.blockPass = BlocksClassify;
+    if (auxPass == MarkPass)     spec.data.adaptivePass = AdaptiveMark;
+    if (auxPass == RefinePass)   spec.data.adaptivePass = AdaptiveRefine;
 
     VkPipelineShaderStageCreateInfo stage{};
     stage.sType  = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
     stage.stage  = VK_SHADER_STAGE_COMPUTE_BIT;
     stage.module = mod;
     stage.pName  = "main";
+    stage.pSpecializationInfo = &spec.info;
 
     VkComputePipelineCreateInfo ci{};
     ci.sType  = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
     ci.stage  = stage;
     ci.layout = pipelineLayout;
 
-    if (vkCreateComputePipelines(device, VK_NULL_HANDLE, 1, &ci, nullptr, &pipeline) != VK_SUCCESS) {
-        vkDestroyShaderModule(device, mod, nullptr);
+    VkPipeline built = VK_NULL_HANDLE;
+    VkResult res = vkCreateComputePipelines(device, ctx.getPipelineCache(), 1, &ci, nullptr, &built);
+    vkDestroyShaderModule(device, mod, nullptr);
+    if (res != VK_SUCCESS) {
         throw std::runtime_error("[Compute] Failed to create compute pipeline.");
     }
+    return built;
+}
 
-    vkDestroyShaderModule(device, mod, nullptr);
+void ComputePipeline::selectTracePipeline() {
+    // The stages are rebuilt in place; callers drain the GPU before switching variant
+    if (wavefront) {
+        TraceSpecialization spec;
+        fillTraceSpecialization(variant, spec);
+        // The stages keep no per-sample step record to draw
+        if (spec.data.debugView == static_cast<int32_t>(DebugView::Steps)) {
+            spec.data.debugView = static_cast<int32_t>(DebugView::None);
+        }
+        wavefront->build(spec.info, spec.data.samplesPerAxis, variant.maxSteps);
+        return;
+    }
+    // Nothing to classify or refine when the variant takes one sample anyway
+    const bool classify = blockClassification && variant.samplesPerAxis > 1;
+    const bool adaptive = adaptiveSampling && variant.samplesPerAxis > 1;
+    auxPipelines = {};
+    if (classify || adaptive) {
+        bool found = false;
+        for (const auto& built : auxBuilt) {
+            if (built.first == variant) { auxPipelines = built.second; found = true; }
+        }
+        if (!found) {
+            if (classify) auxPipelines[ClassifyPass] = createTracePipeline(variant, ClassifyPass);
+            if (adaptive) {
+                auxPipelines[MarkPass] = createTracePipeline(variant, MarkPass);
+                auxPipelines[RefinePass] = createTracePipeline(variant, RefinePass);
+            }
+            auxBuilt.emplace_back(variant, auxPipelines);
+        }
+    }
+    for (const auto& built : tracePipelines) {
+        if (built.first == variant) { pipeline = built.second; return; }
+    }
+    pipeline = createTracePipeline(variant);
+    tracePipelines.emplace_back(variant, pipeline);
+}
+
+void ComputePipeline::setVariant(const TraceVariant& requested) {
+    const TraceVariant next = sanitize(requested);
+    if (next == variant) return;
+
+    // The LUT bake shares the geodesic constants. Rebaking replaces its pipeline, which
+    // earlier frames may still be running; a quality switch is rare enough to drain for.
+    if (lut->isEnabled() && !next.sameGeodesic(variant)) {
+        scheduler.waitIdle();
+        lut->setGeodesic(GeodesicSpecConstants::from(next));
+    }
+    // Wavefront stages are one set of pipelines, rebuilt for the new variant
+    if (wavefront) scheduler.waitIdle();
+
+    // Built variants stay alive, so frames in flight keep a valid pipeline
+    variant = next;
+    selectTracePipeline();
+    historyValid = false;
+}
+
+void ComputePipeline::setSpin(float value) {
+    value = std::clamp(value, -kMaxSpin, kMaxSpin);
+    if (value == spin) return;
+    spin = value;
+    if (metric == GeodesicMetric::Kerr) historyValid = false;
+}
+
+void ComputePipeline::setSceneParams(const SceneParams& params) {
+    scene = params;
+    historyValid = false;
 }
 
-uint32_t ComputePipeline::findMemoryType(uint32_t typeBits, VkMemoryPropertyFlags props) const {
-    VkPhysicalDeviceMemoryProperties memProps{};
-    vkGetPhysicalDeviceMemoryProperties(ctx.getPhysicalDevice(), &memProps);
-    for (uint32_t i = 0; i < memProps.memoryTypeCount; ++i) {
-        if ((typeBits & (1u << i)) && (memProps.memoryTypes[i].propertyFlags & props) == props) {
-            return i;
+VkExtent2D ComputePipeline::autotuneWorkgroup() {
+    // Wavefront stages have a fixed 1D shape
+    if (wavefront) return { variant.groupWidth, variant.groupHeight };
+
+    WorkgroupTuner tuner(ctx, scheduler, traceQueue());
+    if (!tuner.isAvailable()) return { variant.groupWidth, variant.groupHeight };
+
+    // The benchmark bakes the LUT and uses the trace queue; nothing may be in flight
+    scheduler.waitIdle();
+
+    // Scratch target at up to 720p of the real one: enough pixels to fill the GPU,
+    // with the same mix of disk, shadow and lensed sky as the default view
+    const VkExtent2D full = target.getExtent();
+    const VkExtent2D extent{ std::min(full.width, 1280u), std::min(full.height, 720u) };
+    VkImage image = VK_NULL_HANDLE;
+    GpuAllocation memory;
+    VkImageView view = VK_NULL_HANDLE;
+    createImage(extent, traceFormat, VK_IMAGE_USAGE_STORAGE_BIT, image, memory, view, nullptr);
+
+    VkDescriptorPool pool = VK_NULL_HANDLE;
+    VkDescriptorSet set = VK_NULL_HANDLE;
+    std::vector<VkExtent2D> shapes = tuner.candidates();
+    std::vector<VkPipeline> candidates;
+
+    auto release = [&]() {
+        for (VkPipeline p : candidates) if (p) vkDestroyPipeline(device, p, nullptr);
+        if (pool) vkDestroyDescriptorPool(device, pool, nullptr);
+        vkDestroyImageView(device, view, nullptr);
+        vkDestroyImage(device, image, nullptr);
+        ctx.getMemory().free(memory);
+    };
+
+    std::vector<WorkgroupTuner::Result> results;
+    try {
+        VkDescriptorPoolSize poolSizes[3] = { { VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1 },
+                                              { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 4 },
+                                              { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1 } };
+        VkDescriptorPoolCreateInfo pci{ VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO };
+        pci.maxSets = 1;
+        pci.poolSizeCount = 3;
+        pci.pPoolSizes = poolSizes;
+        if (vkCreateDescriptorPool(device, &pci, nullptr, &pool) != VK_SUCCESS) {
+            throw std::runtime_error("[Compute] Failed to create autotune descriptor pool.");
         }
+        VkDescriptorSetAllocateInfo dai{ VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO };
+        dai.descriptorPool = pool;
+        dai.descriptorSetCount = 1;
+        dai.pSetLayouts = &descriptorSetLayout;
+        if (vkAllocateDescriptorSets(device, &dai, &set) != VK_SUCCESS) {
+            throw std::runtime_error("[Compute] Failed to allocate autotune descriptor set.");
+        }
+        writeOutputSet(set, view);
+
+        for (const VkExtent2D& s : shapes) {
+            TraceVariant v = variant;
+            v.groupWidth = s.width;
+            v.groupHeight = s.height;
+            candidates.push_back(createTracePipeline(v));
+        }
+
+        // Nothing is in flight, so slot 0 of the scene ring is free
+        const CameraData camera{ 0.0f, 0.0f, 1.0f, 0.0f };
+        writeScene(0, camera);
+        const TracePushConstants pc = tracePush(camera, extent, 0);
+        VkDescriptorSet traceSets[4] = { set, lut->getSet(), sky->getSet(), disk->getSet() };
+
+        results = tuner.benchmark(shapes,
+            [&](VkCommandBuffer cmd) {
+                VkImageMemoryBarrier2 toGeneral{ VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2 };
+                toGeneral.srcStageMask = VK_PIPELINE_STAGE_2_NONE;
+                toGeneral.dstStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+                toGeneral.dstAccessMask = VK_ACCESS_2_SHADER_WRITE_BIT;
+                toGeneral.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+                toGeneral.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+                toGeneral.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+                toGeneral.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+                toGeneral.image = image;
+                toGeneral.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+                VkDependencyInfo dep{ VK_STRUCTURE_TYPE_DEPENDENCY_INFO };
+                dep.imageMemoryBarrierCount = 1;
+                dep.pImageMemoryBarriers = &toGeneral;
+                vkCmdPipelineBarrier2(cmd, &dep);
+
+                lut->record(cmd, kCameraDistance * camera.zoom);
+                sky->record(cmd);
+                disk->record(cmd);
+
+                // Every candidate shares the layout, so sets and push constants stay bound.
+                // The classes are the current variant's; candidates differ only in shape, and
+                // only the trace itself is timed (the first sample under adaptive sampling).
+                vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout, 0, 4, traceSets, 0, nullptr);
+                vkCmdPushConstants(cmd, pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(pc), &pc);
+                if (auxPipelines[ClassifyPass]) recordClassify(cmd, extent);
+            },
+            [&](VkCommandBuffer cmd, size_t i) {
+                vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, candidates[i]);
+                vkCmdDispatch(cmd, (extent.width  + shapes[i].width  - 1) / shapes[i].width,
+                                   (extent.height + shapes[i].height - 1) / shapes[i].height, 1);
+            });
+    } catch (...) {
+        release();
+        throw;
     }
-    throw std::runtime_error("[Compute] Suitable memory type not found.");
+
+    if (results.empty()) {
+        release();
+        return { variant.groupWidth, variant.groupHeight };
+    }
+
+    std::cout << "[Compute] Workgroup autotune (" << extent.width << "x" << extent.height << "):";
+    for (const auto& r : results) std::cout << " " << r.size.width << "x" << r.size.height << "=" << r.ms << "ms";
+    std::cout << "\n";
+
+    // Keep the winner's pipeline as that variant's; the other candidates go
+    const VkExtent2D best = results.front().size;
+    TraceVariant winner = variant;
+    winner.groupWidth = best.width;
+    winner.groupHeight = best.height;
+    for (size_t i = 0; i < shapes.size(); ++i) {
+        if (shapes[i].width != best.width || shapes[i].height != best.height) continue;
+        bool known = false;
+        for (const auto& built : tracePipelines) known = known || built.first == winner;
+        if (!known) {
+            tracePipelines.emplace_back(winner, candidates[i]);
+            candidates[i] = VK_NULL_HANDLE;
+        }
+    }
+    release();
+
+    variant = winner;
+    selectTracePipeline();
+    historyValid = false;
+    tuner.store(best);
+    return best;
 }
 
-void ComputePipeline::createStorageImage() {
-    storageFormat = VK_FORMAT_R8G8B8A8_UNORM;
-    VkExtent2D extent = sc.getExtent();
+void ComputePipeline::createUpscalePass(const std::string& shaderDir) {
+
+    VkBool32 encode = directOutput ? VK_TRUE : VK_FALSE;
+    VkSpecializationMapEntry entry = encodeSrgbEntry();
+    VkSpecializationInfo spec{ 1, &entry, sizeof(encode), &encode };
+
+    // set 0: internal-resolution trace image, set 1: output (same layout as the trace target)
+    upscalePass = std::make_unique<ComputePass>(ctx, MappedFile(shaderDir + "/upscale.comp.spv"),
+        std::vector<VkDescriptorSetLayout>{ descriptorSetLayout, descriptorSetLayout },
+        static_cast<uint32_t>(sizeof(UpscalePushConstants)), &spec);
+}
+
+void ComputePipeline::createTemporalPass(const std::string& shaderDir) {
 
+    VkBool32 encode = directOutput ? VK_TRUE : VK_FALSE;
+    VkSpecializationMapEntry entry = encodeSrgbEntry();
+    VkSpecializationInfo spec{ 1, &entry, sizeof(encode), &encode };
+
+    // set 0: current trace, 1: history in, 2: history out, 3: output
+    temporalPass = std::make_unique<ComputePass>(ctx, MappedFile(shaderDir + "/temporal.comp.spv"),
+        std::vector<VkDescriptorSetLayout>(4, descriptorSetLayout),
+        static_cast<uint32_t>(sizeof(TemporalPushConstants)), &spec);
+}
+
+void ComputePipeline::rebuildOutputPipelines() {
+    // Every built variant baked the old encode; rebuild the current one, the rest on demand
+    // (wavefront: all stages, the resolve does the encode)
+    for (const auto& built : tracePipelines) vkDestroyPipeline(device, built.second, nullptr);
+    tracePipelines.clear();
+    pipeline = VK_NULL_HANDLE;
+    selectTracePipeline();
+
+    VkBool32 encode = directOutput ? VK_TRUE : VK_FALSE;
+    VkSpecializationMapEntry entry = encodeSrgbEntry();
+    VkSpecializationInfo spec{ 1, &entry, sizeof(encode), &encode };
+    if (upscalePass)  upscalePass->rebuild(&spec);
+    if (temporalPass) temporalPass->rebuild(&spec);
+}
+
+void ComputePipeline::createImage(VkExtent2D extent, VkFormat format, VkImageUsageFlags usage,
+                                  VkImage& image, GpuAllocation& memory, VkImageView& view, GpuArena* arena) {
     VkImageCreateInfo ici{};
     ici.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
     ici.imageType = VK_IMAGE_TYPE_2D;
-    ici.format = storageFormat;
+    ici.format = format;
     ici.extent = { extent.width, extent.height, 1 };
     ici.mipLevels = 1;
     ici.arrayLayers = 1;
     ici.samples = VK_SAMPLE_COUNT_1_BIT;
     ici.tiling = VK_IMAGE_TILING_OPTIMAL;
-    ici.usage = VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+    ici.usage = usage;
     ici.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
     ici.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
 
-    if (vkCreateImage(device, &ici, nullptr, &storageImage) != VK_SUCCESS) {
+    if (vkCreateImage(device, &ici, nullptr, &image) != VK_SUCCESS) {
         throw std::runtime_error("[Compute] Failed to create storage image.");
     }
 
-    VkMemoryRequirements req{};
-    vkGetImageMemoryRequirements(device, storageImage, &req);
-
-    VkMemoryAllocateInfo mai{};
-    mai.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-    mai.allocationSize = req.size;
-    mai.memoryTypeIndex = findMemoryType(req.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-
-    if (vkAllocateMemory(device, &mai, nullptr, &storageMemory) != VK_SUCCESS) {
-        throw std::runtime_error("[Compute] Failed to allocate storage image memory.");
-    }
-
-    vkBindImageMemory(device, storageImage, storageMemory, 0);
+    memory = arena ? arena->bind(image, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)
+                   : ctx.getMemory().bind(image, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
 
     // View
     VkImageViewCreateInfo vci{};
     vci.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
-    vci.image = storageImage;
+    vci.image = image;
     vci.viewType = VK_IMAGE_VIEW_TYPE_2D;
-    vci.format = storageFormat;
+    vci.format = format;
     vci.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
     vci.subresourceRange.baseMipLevel = 0;
     vci.subresourceRange.levelCount = 1;
     vci.subresourceRange.baseArrayLayer = 0;
     vci.subresourceRange.layerCount = 1;
 
-    if (vkCreateImageView(device, &vci, nullptr, &storageView) != VK_SUCCESS) {
+    if (vkCreateImageView(device, &vci, nullptr, &view) != VK_SUCCESS) {
         throw std::runtime_error("[Compute] Failed to create storage image view.");
     }
+}
+
+void ComputePipeline::createTraceBuffer(TraceBuffer& b, VkDeviceSize size, VkBufferUsageFlags usage) {
+    VkBufferCreateInfo bci{ VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO };
+    bci.size = size;
+    bci.usage = usage;
+    bci.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    if (vkCreateBuffer(device, &bci, nullptr, &b.buffer) != VK_SUCCESS) {
+        throw std::runtime_error("[Compute] Failed to create trace buffer.");
+    }
+
+    b.memory = targetMemory->bind(b.buffer, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+}
+
+void ComputePipeline::createSceneRing() {
+    // Coherent and mapped (by GpuMemory) for good: a frame's update is a memcpy into its
+    // slot, and the one descriptor covering all slots never changes
+    VkBufferCreateInfo bci{ VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO };
+    bci.size = sizeof(SceneUniforms) * kSceneSlots;
+    bci.usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
+    bci.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    if (vkCreateBuffer(device, &bci, nullptr, &sceneRing.buffer) != VK_SUCCESS) {
+        throw std::runtime_error("[Compute] Failed to create scene ring.");
+    }
+    sceneRing.memory = ctx.getMemory().bind(sceneRing.buffer,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+}
+
+void ComputePipeline::createRayStatsBuffers() {
+    // The trace's atomics stay in device memory; only the finished counts cross to the host
+    VkBufferCreateInfo bci{ VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO };
+    bci.size = kRayStatWords * sizeof(uint32_t);
+    bci.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+    bci.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    if (vkCreateBuffer(device, &bci, nullptr, &rayStats.buffer) != VK_SUCCESS) {
+        throw std::runtime_error("[Compute] Failed to create ray statistics buffer.");
+    }
+    rayStats.memory = ctx.getMemory().bind(rayStats.buffer, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    if (!rayStatistics) return;
+
+    bci.size = kRayStatWords * sizeof(uint32_t) * frames.size();
+    bci.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+    if (vkCreateBuffer(device, &bci, nullptr, &rayStatsReadback.buffer) != VK_SUCCESS) {
+        throw std::runtime_error("[Compute] Failed to create ray statistics readback.");
+    }
+    rayStatsReadback.memory = ctx.getMemory().bind(rayStatsReadback.buffer,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+}
+
+void ComputePipeline::recordRayStatsReset(VkCommandBuffer cmd) {
+    // The previous frame's copy read the counters earlier on this queue (WAR)
+    VkMemoryBarrier2 prior{ VK_STRUCTURE_TYPE_MEMORY_BARRIER_2 };
+    prior.srcStageMask = VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT;
+    prior.dstStageMask = VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT;
+    prior.dstAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+
+    VkDependencyInfo depPrior{ VK_STRUCTURE_TYPE_DEPENDENCY_INFO };
+    depPrior.memoryBarrierCount = 1;
+    depPrior.pMemoryBarriers = &prior;
+    vkCmdPipelineBarrier2(cmd, &depPrior);
+
+    vkCmdFillBuffer(cmd, rayStats.buffer, 0, VK_WHOLE_SIZE, 0);
+
+    VkMemoryBarrier2 cleared{ VK_STRUCTURE_TYPE_MEMORY_BARRIER_2 };
+    cleared.srcStageMask = VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT;
+    cleared.srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+    cleared.dstStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+    cleared.dstAccessMask = VK_ACCESS_2_SHADER_READ_BIT | VK_ACCESS_2_SHADER_WRITE_BIT;
+
+    VkDependencyInfo depCleared{ VK_STRUCTURE_TYPE_DEPENDENCY_INFO };
+    depCleared.memoryBarrierCount = 1;
+    depCleared.pMemoryBarriers = &cleared;
+    vkCmdPipelineBarrier2(cmd, &depCleared);
+}
+
+void ComputePipeline::recordRayStatsCopy(VkCommandBuffer cmd, FrameResources& frame) {
+    const VkDeviceSize bytes = kRayStatWords * sizeof(uint32_t);
+    const uint32_t slot = static_cast<uint32_t>(&frame - frames.data());
+
+    VkMemoryBarrier2 traced{ VK_STRUCTURE_TYPE_MEMORY_BARRIER_2 };
+    traced.srcStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+    traced.srcAccessMask = VK_ACCESS_2_SHADER_WRITE_BIT;
+    traced.dstStageMask = VK_PIPELINE_STAGE_2_COPY_BIT;
+    traced.dstAccessMask = VK_ACCESS_2_TRANSFER_READ_BIT;
+
+    VkDependencyInfo depTraced{ VK_STRUCTURE_TYPE_DEPENDENCY_INFO };
+    depTraced.memoryBarrierCount = 1;
+    depTraced.pMemoryBarriers = &traced;
+    vkCmdPipelineBarrier2(cmd, &depTraced);
+
+    const VkBufferCopy region{ 0, slot * bytes, bytes };
+    vkCmdCopyBuffer(cmd, rayStats.buffer, rayStatsReadback.buffer, 1, &region);
+
+    VkMemoryBarrier2 toHost{ VK_STRUCTURE_TYPE_MEMORY_BARRIER_2 };
+    toHost.srcStageMask = VK_PIPELINE_STAGE_2_COPY_BIT;
+    toHost.srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+    toHost.dstStageMask = VK_PIPELINE_STAGE_2_HOST_BIT;
+    toHost.dstAccessMask = VK_ACCESS_2_HOST_READ_BIT;
+
+    VkDependencyInfo depHost{ VK_STRUCTURE_TYPE_DEPENDENCY_INFO };
+    depHost.memoryBarrierCount = 1;
+    depHost.pMemoryBarriers = &toHost;
+    vkCmdPipelineBarrier2(cmd, &depHost);
+
+    // The bin width the shader derived from MAX_GEODESIC_STEPS
+    frame.rayStatsBinWidth = static_cast<uint32_t>(variant.maxSteps + kRayStatStepBins - 1) / kRayStatStepBins;
+}
+
+void ComputePipeline::readRayStats(FrameResources& frame) {
+    if (frame.rayStatsBinWidth == 0) return;
+    const uint32_t slot = static_cast<uint32_t>(&frame - frames.data());
+    const uint32_t* words = static_cast<const uint32_t*>(rayStatsReadback.memory.mapped) + slot * kRayStatWords;
+
+    GpuProfiler::RayStats stats;
+    stats.samples = words[kRayStatSamples];
+    stats.steps = words[kRayStatSteps] | (static_cast<uint64_t>(words[kRayStatSteps + 1]) << 32);
+    for (size_t i = 0; i < stats.fates.size(); ++i)     stats.fates[i] = words[kRayStatFates + i];
+    for (size_t i = 0; i < stats.crossings.size(); ++i) stats.crossings[i] = words[kRayStatCrossings + i];
+    stats.stepHistogram.assign(words + kRayStatBins, words + kRayStatBins + kRayStatStepBins);
+    stats.binWidth = frame.rayStatsBinWidth;
+    frame.rayStatsBinWidth = 0;
+
+    profiler->setRayStats(stats);
+}
+
+void ComputePipeline::writeScene(uint32_t slot, const CameraData& camera) {
+    // The orbit camera gargantua.comp used to build from the push constant, at
+    // kCameraDistance * zoom from the hole back along forward
+    const std::array<float, 9> r = orbitRotation(camera, scene);
+    const float d = kCameraDistance * camera.zoom;
+
+    const SceneUniforms u{
+        { r[0], r[1], r[2], 0.0f,
+          r[3], r[4], r[5], 0.0f,
+          r[6], r[7], r[8], 0.0f,
+          -d * r[6], -d * r[7], -d * r[8], 1.0f },
+        { scene.focalLength, 0.0f, 0.0f, 0.0f },
+        { spin, 0.0f, 0.0f, 0.0f },
+        { scene.diskSpeed, scene.diskBrightness, 0.0f, 0.0f },
+        { scene.exposure, scene.gamma, scene.saturation, scene.contrast },
+    };
+    std::memcpy(static_cast<char*>(sceneRing.memory.mapped) + slot * sizeof(SceneUniforms), &u, sizeof(u));
+}
+
+void ComputePipeline::createTraceBuffers(VkExtent2D extent) {
+    const VkDeviceSize blocksX = (extent.width  + kClassifyBlock - 1) / kClassifyBlock;
+    const VkDeviceSize blocksY = (extent.height + kClassifyBlock - 1) / kClassifyBlock;
+    const VkDeviceSize pixels  = static_cast<VkDeviceSize>(extent.width) * extent.height;
+    const VkDeviceSize word    = sizeof(uint32_t);
+
+    // Each pass writes what the next one reads, so none needs initialising
+    createTraceBuffer(blockClasses, blockClassification ? std::max<VkDeviceSize>(blocksX * blocksY, 1) * word : word,
+                      VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+    // Header: count + VkDispatchIndirectCommand (16 bytes), then the list; 2 words per first sample
+    createTraceBuffer(refineList, adaptiveSampling ? (4 + pixels) * word : 4 * word,
+                      VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT);
+    createTraceBuffer(firstSamples, adaptiveSampling ? std::max<VkDeviceSize>(pixels, 1) * 2 * word : 2 * word,
+                      VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+}
+
+void ComputePipeline::writeOutputSet(VkDescriptorSet set, VkImageView view) const {
+    VkDescriptorImageInfo image{};
+    image.imageView = view;
+    image.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+    const VkDescriptorBufferInfo buffers[5] = { { blockClasses.buffer, 0, VK_WHOLE_SIZE },
+                                                { refineList.buffer,   0, VK_WHOLE_SIZE },
+                                                { firstSamples.buffer, 0, VK_WHOLE_SIZE },
+                                                { sceneRing.buffer,    0, VK_WHOLE_SIZE },
+                                                { rayStats.buffer,     0, VK_WHOLE_SIZE } };
+
+    VkWriteDescriptorSet writes[6]{};
+    writes[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    writes[0].dstSet = set;
+    writes[0].dstBinding = 0;
+    writes[0].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+    writes[0].descriptorCount = 1;
+    writes[0].pImageInfo = &image;
+    for (uint32_t b = 1; b < 6; ++b) {
+        writes[b].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        writes[b].dstSet = set;
+        writes[b].dstBinding = b;
+        writes[b].descriptorType = b == 4 ? VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER : VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        writes[b].descriptorCount = 1;
+        writes[b].pBufferInfo = &buffers[b - 1];
+    }
+    vkUpdateDescriptorSets(device, 6, writes, 0, nullptr);
+}
+
+void ComputePipeline::writeOutputImage(VkDescriptorSet set, VkImageView view) const {
+    VkDescriptorImageInfo image{};
+    image.imageView = view;
+    image.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+    VkWriteDescriptorSet write{ VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET };
+    write.dstSet = set;
+    write.dstBinding = 0;
+    write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+    write.descriptorCount = 1;
+    write.pImageInfo = &image;
+    vkUpdateDescriptorSets(device, 1, &write, 0, nullptr);
+}
+
+void ComputePipeline::createStorageImages() {
+    for (auto& f : frames) {
+        f.pendingAcquire = false;
+        f.lastBlit = {};
+    }
+    historyValid = false;
+    if (!targetMemory) {
+        targetMemory = spareMemory ? std::move(spareMemory) : std::make_unique<GpuArena>(ctx.getMemory());
+    }
+
+    VkExtent2D extent = target.getExtent();
+    createTraceBuffers(extent);
+
+    // Direct output without a resolve pass writes the swapchain images themselves;
+    // no offscreen images needed at all.
+    if (directOutput && !usesTraceTarget()) return;
+
+    storageFormat = VK_FORMAT_R8G8B8A8_UNORM;
+
+    std::vector<VkImage> created;
+    for (auto& f : frames) {
+        if (!directOutput) {
+            createImage(extent, storageFormat, VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+                        f.storageImage, f.storageMemory, f.storageView, targetMemory.get());
+            created.push_back(f.storageImage);
+        }
+        // Full-size so a render scale change never reallocates; only a sub-rect is traced
+        if (usesTraceTarget()) {
+            createImage(extent, traceFormat, VK_IMAGE_USAGE_STORAGE_BIT,
+                        f.traceImage, f.traceMemory, f.traceView, targetMemory.get());
+            created.push_back(f.traceImage);
+        }
+    }
+    if (temporalAccumulation) {
+        for (auto& h : history) {
+            createImage(extent, traceFormat, VK_IMAGE_USAGE_STORAGE_BIT, h.image, h.memory, h.view,
+                        targetMemory.get());
+            created.push_back(h.image);
+        }
+    }
+
+    // Transition all offscreen images to GENERAL (compute writes) in one submit.
+    // Done on the queue that traces, so that family owns the exclusive images afterwards.
+    VkCommandPool pool  = asyncCompute ? ctx.getComputeCommandPool() : ctx.getGraphicsCommandPool();
+    VkQueue       queue = asyncCompute ? ctx.getComputeQueue()       : ctx.getGraphicsQueue();
 
-    // Transition storage image to GENERAL (compute writes)
     VkCommandBufferAllocateInfo ai{};
     ai.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-    ai.commandPool = ctx.getComputeCommandPool();
+    ai.commandPool = pool;
     ai.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
     ai.commandBufferCount = 1;
 
@@ -201,27 +1019,32 @@ void ComputePipeline::createStorageImage() {
     bi.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
     vkBeginCommandBuffer(tmp, &bi);
 
-    VkImageMemoryBarrier2 barrier{};
-    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2;
-    barrier.srcStageMask = VK_PIPELINE_STAGE_2_TOP_OF_PIPE_BIT;
-    barrier.dstStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
-    barrier.srcAccessMask = 0;
-    barrier.dstAccessMask = VK_ACCESS_2_SHADER_WRITE_BIT;
-    barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-    barrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
-    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-    barrier.image = storageImage;
-    barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-    barrier.subresourceRange.baseMipLevel = 0;
-    barrier.subresourceRange.levelCount = 1;
-    barrier.subresourceRange.baseArrayLayer = 0;
-    barrier.subresourceRange.layerCount = 1;
+    std::vector<VkImageMemoryBarrier2> barriers;
+    barriers.reserve(created.size());
+    for (VkImage image : created) {
+        VkImageMemoryBarrier2 barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2;
+        barrier.srcStageMask = VK_PIPELINE_STAGE_2_TOP_OF_PIPE_BIT;
+        barrier.dstStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+        barrier.srcAccessMask = 0;
+        barrier.dstAccessMask = VK_ACCESS_2_SHADER_WRITE_BIT;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        barrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.image = image;
+        barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        barrier.subresourceRange.baseMipLevel = 0;
+        barrier.subresourceRange.levelCount = 1;
+        barrier.subresourceRange.baseArrayLayer = 0;
+        barrier.subresourceRange.layerCount = 1;
+        barriers.push_back(barrier);
+    }
 
     VkDependencyInfo dep{};
     dep.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
-    dep.imageMemoryBarrierCount = 1;
-    dep.pImageMemoryBarriers = &barrier;
+    dep.imageMemoryBarrierCount = static_cast<uint32_t>(barriers.size());
+    dep.pImageMemoryBarriers = barriers.data();
 
     vkCmdPipelineBarrier2(tmp, &dep);
     vkEndCommandBuffer(tmp);
@@ -235,169 +1058,574 @@ void ComputePipeline::createStorageImage() {
     sub.commandBufferInfoCount = 1;
     sub.pCommandBufferInfos = &cb;
 
-    vkQueueSubmit2(ctx.getComputeQueue(), 1, &sub, VK_NULL_HANDLE);
-    vkQueueWaitIdle(ctx.getComputeQueue());
+    // Signal the queue's timeline so the one-shot buffer is freed once the GPU is past it.
+    // Later dispatches on the same queue are ordered after the barrier, no host wait needed.
+    TimelinePoint done = scheduler.signal(asyncCompute ? FrameScheduler::Queue::Compute
+                                                       : FrameScheduler::Queue::Graphics);
+
+    VkSemaphoreSubmitInfo signalDone{ VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO };
+    signalDone.semaphore = done.semaphore;
+    signalDone.value = done.value;
+    signalDone.stageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
 
-    vkFreeCommandBuffers(device, ctx.getComputeCommandPool(), 1, &tmp);
+    sub.signalSemaphoreInfoCount = 1;
+    sub.pSignalSemaphoreInfos = &signalDone;
+
+    if (vkQueueSubmit2(queue, 1, &sub, VK_NULL_HANDLE) != VK_SUCCESS) {
+        throw std::runtime_error("[Compute] Failed to submit storage image transition.");
+    }
+
+    scheduler.deferDestroy([dev = device, pool, tmp]() {
+        vkFreeCommandBuffers(dev, pool, 1, &tmp);
+    });
 }
 
-void ComputePipeline::destroyStorageImage() {
-    if (storageView)   { vkDestroyImageView(device, storageView, nullptr); storageView = VK_NULL_HANDLE; }
-    if (storageImage)  { vkDestroyImage(device, storageImage, nullptr); storageImage = VK_NULL_HANDLE; }
-    if (storageMemory) { vkFreeMemory(device, storageMemory, nullptr); storageMemory = VK_NULL_HANDLE; }
+void ComputePipeline::retireStorageImages() {
+    // Frames in flight may still use every one of these; take the handles out and let the
+    // scheduler destroy them once the GPU has passed everything submitted so far
+    std::vector<VkImageView> views;
+    std::vector<VkImage>     images;
+    std::vector<VkBuffer>    buffers;
+    auto takeImage = [&](VkImage& image, GpuAllocation& memory, VkImageView& view) {
+        if (view)  views.push_back(view);
+        if (image) images.push_back(image);
+        image = VK_NULL_HANDLE;
+        memory = {};
+        view = VK_NULL_HANDLE;
+    };
+    for (auto& f : frames) {
+        takeImage(f.storageImage, f.storageMemory, f.storageView);
+        takeImage(f.traceImage, f.traceMemory, f.traceView);
+    }
+    for (auto& h : history) takeImage(h.image, h.memory, h.view);
+    for (TraceBuffer* b : { &blockClasses, &refineList, &firstSamples }) {
+        if (b->buffer) buffers.push_back(b->buffer);
+        b->buffer = VK_NULL_HANDLE;
+        b->memory = {};
+    }
+
+    // Everything above came from the arena; rewound, it serves the next createStorageImages()
+    // (std::function needs a copyable capture, hence the raw pointer)
+    GpuArena* arena = targetMemory.release();
+    scheduler.deferDestroy([this, views, images, buffers, arena]() {
+        for (VkImageView view : views) vkDestroyImageView(device, view, nullptr);
+        for (VkImage image : images)   vkDestroyImage(device, image, nullptr);
+        for (VkBuffer buffer : buffers) vkDestroyBuffer(device, buffer, nullptr);
+        std::unique_ptr<GpuArena> retired(arena);
+        if (retired && !spareMemory) {
+            retired->reset();
+            spareMemory = std::move(retired);
+        }
+    });
 }
 
 void ComputePipeline::createDescriptorPoolAndSets() {
-    VkDescriptorPoolSize poolSize{};
-    poolSize.type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
-    poolSize.descriptorCount = 1;
+    // Every set belongs to one frame slot, so it is idle whenever that slot dispatches and a
+    // recreate() rewrites it in place there (updateFrameSets) instead of rebuilding the pool.
+    // Per slot: the output set (storage image, or the acquired image under direct output),
+    // the trace set when a resolve pass follows, and one set per history image.
+    const uint32_t perFrame = 1u + (usesTraceTarget() ? 1u : 0u)
+                            + (temporalAccumulation ? static_cast<uint32_t>(history.size()) : 0u);
+    const uint32_t setCount = perFrame * static_cast<uint32_t>(frames.size());
+
+    VkDescriptorPoolSize poolSizes[3]{};
+    poolSizes[0].type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+    poolSizes[0].descriptorCount = setCount;
+    poolSizes[1].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    poolSizes[1].descriptorCount = setCount * 4;
+    poolSizes[2].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+    poolSizes[2].descriptorCount = setCount;
 
     VkDescriptorPoolCreateInfo pci{};
     pci.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-    pci.maxSets = 1;
-    pci.poolSizeCount = 1;
-    pci.pPoolSizes = &poolSize;
+    pci.maxSets = setCount;
+    pci.poolSizeCount = 3;
+    pci.pPoolSizes = poolSizes;
 
     if (vkCreateDescriptorPool(device, &pci, nullptr, &descriptorPool) != VK_SUCCESS) {
         throw std::runtime_error("[Compute] Failed to create descriptor pool.");
     }
 
+    std::vector<VkDescriptorSetLayout> layouts(setCount, descriptorSetLayout);
+    std::vector<VkDescriptorSet> sets(setCount);
+
     VkDescriptorSetAllocateInfo ai{};
     ai.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
     ai.descriptorPool = descriptorPool;
-    ai.descriptorSetCount = 1;
-    ai.pSetLayouts = &descriptorSetLayout;
+    ai.descriptorSetCount = setCount;
+    ai.pSetLayouts = layouts.data();
 
-    if (vkAllocateDescriptorSets(device, &ai, &descriptorSet) != VK_SUCCESS) {
-        throw std::runtime_error("[Compute] Failed to allocate descriptor set.");
+    if (vkAllocateDescriptorSets(device, &ai, sets.data()) != VK_SUCCESS) {
+        throw std::runtime_error("[Compute] Failed to allocate descriptor sets.");
     }
 
-    VkDescriptorImageInfo info{};
-    info.imageView = storageView;
-    info.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
-
-    VkWriteDescriptorSet write{};
-    write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-    write.dstSet = descriptorSet;
-    write.dstBinding = 0;
-    write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
-    write.descriptorCount = 1;
-    write.pImageInfo = &info;
+    // Written by the first dispatch of each slot
+    auto next = sets.begin();
+    for (auto& f : frames) {
+        f.descriptorSet = *next++;
+        if (usesTraceTarget()) f.traceSet = *next++;
+        if (temporalAccumulation) {
+            for (auto& set : f.historySets) set = *next++;
+        }
+        f.staleSets = true;
+    }
+}
 
-    vkUpdateDescriptorSets(device, 1, &write, 0, nullptr);
+void ComputePipeline::updateFrameSets(FrameResources& frame, uint32_t imageIndex) {
+    const VkImageView output = directOutput ? target.getImageView(imageIndex) : frame.storageView;
+    if (frame.staleSets) {
+        writeOutputSet(frame.descriptorSet, output);
+        if (frame.traceSet) writeOutputSet(frame.traceSet, frame.traceView);
+        for (size_t i = 0; i < history.size(); ++i) {
+            if (frame.historySets[i]) writeOutputSet(frame.historySets[i], history[i].view);
+        }
+        frame.staleSets = false;
+    } else if (output != frame.outputView) {
+        // Direct output: the slot acquired another image than last time
+        writeOutputImage(frame.descriptorSet, output);
+    }
+    frame.outputView = output;
 }
 
 void ComputePipeline::allocateCommandBuffers() {
-    // Compute CMDBUF
+    const uint32_t frameCount = static_cast<uint32_t>(frames.size());
+    std::vector<VkCommandBuffer> computeCmds(frameCount);
+    std::vector<VkCommandBuffer> graphicsCmds(frameCount);
+
+    // Compute CMDBUFs
     {
         VkCommandBufferAllocateInfo ai{};
         ai.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
         ai.commandPool = ctx.getComputeCommandPool();
         ai.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-        ai.commandBufferCount = 1;
-        if (vkAllocateCommandBuffers(device, &ai, &cmdCompute) != VK_SUCCESS) {
-            throw std::runtime_error("[Compute] Failed to allocate compute command buffer.");
+        ai.commandBufferCount = frameCount;
+        if (vkAllocateCommandBuffers(device, &ai, computeCmds.data()) != VK_SUCCESS) {
+            throw std::runtime_error("[Compute] Failed to allocate compute command buffers.");
         }
     }
-    // Graphics CMDBUF
+    // Graphics CMDBUFs
     {
         VkCommandBufferAllocateInfo ai{};
         ai.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
         ai.commandPool = ctx.getGraphicsCommandPool();
         ai.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-        ai.commandBufferCount = 1;
-        if (vkAllocateCommandBuffers(device, &ai, &cmdGraphics) != VK_SUCCESS) {
-            throw std::runtime_error("[Compute] Failed to allocate graphics command buffer.");
+        ai.commandBufferCount = frameCount;
+        if (vkAllocateCommandBuffers(device, &ai, graphicsCmds.data()) != VK_SUCCESS) {
+            throw std::runtime_error("[Compute] Failed to allocate graphics command buffers.");
         }
     }
+
+    for (uint32_t i = 0; i < frameCount; ++i) {
+        frames[i].cmdCompute  = computeCmds[i];
+        frames[i].cmdGraphics = graphicsCmds[i];
+    }
 }
 
 void ComputePipeline::recreate() {
-    vkDeviceWaitIdle(device);
-    destroyStorageImage();
-    createStorageImage();
+    // The new swapchain may have lost (or gained) STORAGE usage; the sRGB encode
+    // specialization follows the output path, so rebuild the pipeline on a switch.
+    // Rare (surface capabilities changed), and in-flight frames use the old pipelines.
+    const bool direct = allowDirectOutput && target.hasStorageUsage();
+    if (direct != directOutput) {
+        scheduler.waitIdle();
+        directOutput = direct;
+        rebuildOutputPipelines();
+    }
+    renderExtent = target.getExtent();
+    targetGeneration = target.getGeneration();
+
+    retireStorageImages();
+    createStorageImages();
+    for (auto& f : frames) f.staleSets = true;
+}
 
-    // Rebuild descriptor set pool+set (points to storageView)
-    if (descriptorPool) {
-        vkDestroyDescriptorPool(device, descriptorPool, nullptr);
-        descriptorPool = VK_NULL_HANDLE;
+VkImageMemoryBarrier2 ComputePipeline::storageBarrier(const FrameResources& frame,
+                                                     VkImageLayout oldLayout, VkImageLayout newLayout) const {
+    VkImageMemoryBarrier2 b{ VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2 };
+    b.oldLayout = oldLayout;
+    b.newLayout = newLayout;
+    b.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    b.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    b.image = frame.storageImage;
+    b.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+    return b;
+}
+
+void ComputePipeline::setTile(const VkRect2D& rect, VkExtent2D imageSize) {
+    if (usesTraceTarget()) {
+        throw std::runtime_error("[Compute] Tiled rendering needs temporal accumulation and dynamic resolution off.");
     }
-    createDescriptorPoolAndSets();
+    const VkExtent2D ext = target.getExtent();
+    if (rect.extent.width > ext.width || rect.extent.height > ext.height || rect.offset.x < 0 || rect.offset.y < 0
+        || rect.offset.x + rect.extent.width > imageSize.width || rect.offset.y + rect.extent.height > imageSize.height) {
+        throw std::runtime_error("[Compute] Tile does not fit the target or the image.");
+    }
+    tile = rect;
+    tileImageSize = imageSize;
+    tiled = true;
 }
 
-void ComputePipeline::dispatch(uint32_t imageIndex, VkSemaphore waitSemaphore, VkSemaphore signalSemaphore, const CameraData& camera) {
-    // ------- 1) COMPUTE: record on compute CMDBUF -------
-    vkResetCommandBuffer(cmdCompute, 0);
-    VkCommandBufferBeginInfo biCompute{ VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
-    biCompute.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
-    vkBeginCommandBuffer(cmdCompute, &biCompute);
-
-    vkCmdBindPipeline(cmdCompute, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
-    vkCmdBindDescriptorSets(cmdCompute, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout, 0, 1, &descriptorSet, 0, nullptr);
-    vkCmdPushConstants(cmdCompute, pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(CameraData), &camera);
-
-    VkExtent2D extent = sc.getExtent();
-    const uint32_t wgX = (extent.width  + 15) / 16;
-    const uint32_t wgY = (extent.height + 15) / 16;
-    vkCmdDispatch(cmdCompute, wgX, wgY, 1);
-
-    // storage GENERAL (shader write) -> TRANSFER_SRC for blit (later, on graphics)
-    VkImageMemoryBarrier2 storageToSrc{ VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2 };
-    storageToSrc.srcStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
-    storageToSrc.srcAccessMask = VK_ACCESS_2_SHADER_WRITE_BIT;
-    storageToSrc.dstStageMask = VK_PIPELINE_STAGE_2_TRANSFER_BIT;
-    storageToSrc.dstAccessMask = VK_ACCESS_2_TRANSFER_READ_BIT;
-    storageToSrc.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
-    storageToSrc.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
-    storageToSrc.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-    storageToSrc.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-    storageToSrc.image = storageImage;
-    storageToSrc.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
-
-    VkDependencyInfo depCompute{ VK_STRUCTURE_TYPE_DEPENDENCY_INFO };
-    depCompute.imageMemoryBarrierCount = 1;
-    depCompute.pImageMemoryBarriers = &storageToSrc;
-
-    vkCmdPipelineBarrier2(cmdCompute, &depCompute);
-    vkEndCommandBuffer(cmdCompute);
-
-    // Submit compute, waiting on acquire-semaphore (if provided), and signal internal computeFinished_
-    VkCommandBufferSubmitInfo cbCompute{ VK_STRUCTURE_TYPE_COMMAND_BUFFER_SUBMIT_INFO };
-    cbCompute.commandBuffer = cmdCompute;
+void ComputePipeline::clearTile() {
+    tiled = false;
+}
+
+void ComputePipeline::updateRenderScale(const FrameResources& frame, bool freshSample) {
+    if (freshSample && lastGpuMs > 0.0f) {
+        // Trace cost is roughly proportional to pixel count, i.e. to scale^2.
+        // Work from the scale the sample was measured at, not the current one.
+        float desired = frame.tracedScale * std::sqrt(targetFrameMs / lastGpuMs);
+        desired = std::clamp(desired, minRenderScale, 1.0f);
+
+        // Damp, and ignore tiny corrections so the internal resolution doesn't shimmer
+        const float next = renderScale + (desired - renderScale) * 0.25f;
+        if (std::abs(next - renderScale) > 0.01f || desired == 1.0f || desired == minRenderScale) {
+            renderScale = next;
+        }
+    }
+
+    VkExtent2D full = target.getExtent();
+    renderExtent.width  = std::clamp(static_cast<uint32_t>(full.width  * renderScale + 0.5f), 1u, full.width);
+    renderExtent.height = std::clamp(static_cast<uint32_t>(full.height * renderScale + 0.5f), 1u, full.height);
+}
+
+void ComputePipeline::recordClassify(VkCommandBuffer cmd, VkExtent2D traced) {
+    // WAR against the previous trace's reads (earlier on this queue), then RAW for this one
+    VkMemoryBarrier2 barrier{ VK_STRUCTURE_TYPE_MEMORY_BARRIER_2 };
+    barrier.srcStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+    barrier.dstStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+    barrier.dstAccessMask = VK_ACCESS_2_SHADER_WRITE_BIT;
+
+    VkDependencyInfo dep{ VK_STRUCTURE_TYPE_DEPENDENCY_INFO };
+    dep.memoryBarrierCount = 1;
+    dep.pMemoryBarriers = &barrier;
+    vkCmdPipelineBarrier2(cmd, &dep);
+
+    const uint32_t blocksX = (traced.width  + kClassifyBlock - 1) / kClassifyBlock;
+    const uint32_t blocksY = (traced.height + kClassifyBlock - 1) / kClassifyBlock;
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, auxPipelines[ClassifyPass]);
+    vkCmdDispatch(cmd, (blocksX + variant.groupWidth  - 1) / variant.groupWidth,
+                       (blocksY + variant.groupHeight - 1) / variant.groupHeight, 1);
+
+    barrier.srcAccessMask = VK_ACCESS_2_SHADER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_2_SHADER_READ_BIT;
+    vkCmdPipelineBarrier2(cmd, &dep);
+}
+
+void ComputePipeline::recordRefine(VkCommandBuffer cmd, VkExtent2D traced) {
+    // The mark pass reads the first samples and appends to the list the trace reset
+    VkMemoryBarrier2 barrier{ VK_STRUCTURE_TYPE_MEMORY_BARRIER_2 };
+    barrier.srcStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+    barrier.srcAccessMask = VK_ACCESS_2_SHADER_WRITE_BIT;
+    barrier.dstStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+    barrier.dstAccessMask = VK_ACCESS_2_SHADER_READ_BIT | VK_ACCESS_2_SHADER_WRITE_BIT;
+
+    VkDependencyInfo dep{ VK_STRUCTURE_TYPE_DEPENDENCY_INFO };
+    dep.memoryBarrierCount = 1;
+    dep.pMemoryBarriers = &barrier;
+    vkCmdPipelineBarrier2(cmd, &dep);
+
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, auxPipelines[MarkPass]);
+    vkCmdDispatch(cmd, (traced.width  + variant.groupWidth  - 1) / variant.groupWidth,
+                       (traced.height + variant.groupHeight - 1) / variant.groupHeight, 1);
+
+    // Refine: one workgroup per group-sized chunk of the list, sized by the mark pass
+    barrier.dstStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT;
+    barrier.dstAccessMask = VK_ACCESS_2_SHADER_READ_BIT | VK_ACCESS_2_SHADER_WRITE_BIT
+                          | VK_ACCESS_2_INDIRECT_COMMAND_READ_BIT;
+    vkCmdPipelineBarrier2(cmd, &dep);
+
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, auxPipelines[RefinePass]);
+    vkCmdDispatchIndirect(cmd, refineList.buffer, sizeof(uint32_t));
+}
+
+void ComputePipeline::recordTraceDispatch(VkCommandBuffer cmd, VkExtent2D traced) {
+    if (auxPipelines[ClassifyPass]) recordClassify(cmd, traced);
+    if (auxPipelines[RefinePass]) {
+        // The trace resets the list and rewrites the first samples the previous refine read
+        VkMemoryBarrier2 war{ VK_STRUCTURE_TYPE_MEMORY_BARRIER_2 };
+        war.srcStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT;
+        war.dstStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+        war.dstAccessMask = VK_ACCESS_2_SHADER_WRITE_BIT;
+
+        VkDependencyInfo dep{ VK_STRUCTURE_TYPE_DEPENDENCY_INFO };
+        dep.memoryBarrierCount = 1;
+        dep.pMemoryBarriers = &war;
+        vkCmdPipelineBarrier2(cmd, &dep);
+    }
+
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
+    vkCmdDispatch(cmd, (traced.width  + variant.groupWidth  - 1) / variant.groupWidth,
+                       (traced.height + variant.groupHeight - 1) / variant.groupHeight, 1);
+
+    if (auxPipelines[RefinePass]) recordRefine(cmd, traced);
+}
+
+void ComputePipeline::recordOutputPass(VkCommandBuffer cmd, FrameResources& frame, VkDescriptorSet outputSet,
+                                       const CameraData& camera) {
+    VkExtent2D extent = target.getExtent();
+    const uint32_t sceneSlot = static_cast<uint32_t>(&frame - frames.data());
+
+    // Rebakes only when the camera radius changed; the sky and disk textures bake once
+    lut->record(cmd, kCameraDistance * camera.zoom);
+    sky->record(cmd);
+    disk->record(cmd);
+
+    if (!usesTraceTarget()) {
+        // Tiled: trace tile.extent pixels into the target origin, rays from tile.offset in the full image
+        TracePushConstants pc = tracePush(camera, extent, sceneSlot);
+        if (tiled) {
+            extent = tile.extent;
+            pc = tracePush(camera, tile.extent, sceneSlot);
+            pc.tileX = tile.offset.x;
+            pc.tileY = tile.offset.y;
+            pc.imageWidth = static_cast<int32_t>(tileImageSize.width);
+            pc.imageHeight = static_cast<int32_t>(tileImageSize.height);
+        }
+        if (rayStatistics) recordRayStatsReset(cmd);
+        if (profiler) { profiler->begin(cmd, GpuProfiler::Stage::Trace); profiler->beginStatistics(cmd); }
+        if (wavefront) {
+            wavefront->record(cmd, outputSet, sky->getSet(), disk->getSet(), camera, sceneSlot, extent,
+                              { pc.tileX, pc.tileY },
+                              { static_cast<uint32_t>(pc.imageWidth), static_cast<uint32_t>(pc.imageHeight) });
+        } else {
+            VkDescriptorSet traceSets[4] = { outputSet, lut->getSet(), sky->getSet(), disk->getSet() };
+
+            // Bound once for the trace and its auxiliary passes, which share the layout
+            vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout, 0, 4, traceSets, 0, nullptr);
+            vkCmdPushConstants(cmd, pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(pc), &pc);
+            recordTraceDispatch(cmd, extent);
+        }
+        if (profiler) { profiler->endStatistics(cmd); profiler->end(cmd, GpuProfiler::Stage::Trace); }
+        if (rayStatistics) recordRayStatsCopy(cmd, frame);
+        return;
+    }
+
+    // Previous resolve of this slot read the trace image (WAR), and the previous frame's
+    // resolve wrote the history we are about to read (RAW). Both were earlier on this queue.
+    VkMemoryBarrier2 prior{ VK_STRUCTURE_TYPE_MEMORY_BARRIER_2 };
+    prior.srcStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+    prior.srcAccessMask = VK_ACCESS_2_SHADER_WRITE_BIT;
+    prior.dstStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+    prior.dstAccessMask = VK_ACCESS_2_SHADER_READ_BIT | VK_ACCESS_2_SHADER_WRITE_BIT;
+
+    VkDependencyInfo depPrior{ VK_STRUCTURE_TYPE_DEPENDENCY_INFO };
+    depPrior.memoryBarrierCount = 1;
+    depPrior.pMemoryBarriers = &prior;
+    vkCmdPipelineBarrier2(cmd, &depPrior);
+
+    // 1) Trace the top-left renderExtent sub-rect of the internal target
+    const VkExtent2D traced = dynamicResolution ? renderExtent : extent;
+    if (rayStatistics) recordRayStatsReset(cmd);
+    if (profiler) { profiler->begin(cmd, GpuProfiler::Stage::Trace); profiler->beginStatistics(cmd); }
+    if (wavefront) {
+        wavefront->record(cmd, frame.traceSet, sky->getSet(), disk->getSet(), camera, sceneSlot, traced, { 0, 0 },
+                          traced);
+    } else {
+        TracePushConstants pc = tracePush(camera, traced, sceneSlot);
+
+        VkDescriptorSet traceSets[4] = { frame.traceSet, lut->getSet(), sky->getSet(), disk->getSet() };
+
+        vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout, 0, 4, traceSets, 0, nullptr);
+        vkCmdPushConstants(cmd, pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(pc), &pc);
+        recordTraceDispatch(cmd, traced);
+    }
+    if (profiler) { profiler->endStatistics(cmd); profiler->end(cmd, GpuProfiler::Stage::Trace); }
+    if (rayStatistics) recordRayStatsCopy(cmd, frame);
+
+    VkMemoryBarrier2 raw{ VK_STRUCTURE_TYPE_MEMORY_BARRIER_2 };
+    raw.srcStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+    raw.srcAccessMask = VK_ACCESS_2_SHADER_WRITE_BIT;
+    raw.dstStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+    raw.dstAccessMask = VK_ACCESS_2_SHADER_READ_BIT;
+
+    VkDependencyInfo depRaw{ VK_STRUCTURE_TYPE_DEPENDENCY_INFO };
+    depRaw.memoryBarrierCount = 1;
+    depRaw.pMemoryBarriers = &raw;
+    vkCmdPipelineBarrier2(cmd, &depRaw);
+
+    // 2) Resolve at output resolution
+    if (profiler) profiler->begin(cmd, GpuProfiler::Stage::Resolve);
+    if (temporalAccumulation) {
+        // Blend into the other history image, which becomes the latest for the next frame
+        const uint32_t next = historyIndex ^ 1u;
+        TemporalPushConstants tp{};
+        tp.srcWidth  = static_cast<int32_t>(traced.width);
+        tp.srcHeight = static_cast<int32_t>(traced.height);
+        tp.dstWidth  = static_cast<int32_t>(extent.width);
+        tp.dstHeight = static_cast<int32_t>(extent.height);
+        tp.reset     = historyValid ? 0u : 1u;
+        tp.minBlend  = 1.0f / static_cast<float>(maxHistoryFrames);
+        tp.focalLength = scene.focalLength;
+
+        // History camera^T * this camera; element (i, j) is dot(history column i, column j)
+        const std::array<float, 9> now = orbitRotation(camera, scene);
+        const std::array<float, 9> then = historyValid ? orbitRotation(historyCamera, scene) : now;
+        for (int j = 0; j < 3; ++j)
+        for (int i = 0; i < 3; ++i) {
+            tp.reproject[j][i] = then[i * 3 + 0] * now[j * 3 + 0] + then[i * 3 + 1] * now[j * 3 + 1] +
+                                 then[i * 3 + 2] * now[j * 3 + 2];
+        }
+
+        VkDescriptorSet sets[4] = { frame.traceSet, frame.historySets[historyIndex], frame.historySets[next], outputSet };
+        temporalPass->bind(cmd, sets, 4);
+        temporalPass->pushConstants(cmd, &tp, sizeof(tp));
+        vkCmdDispatch(cmd, (extent.width + 15) / 16, (extent.height + 15) / 16, 1);
+
+        historyIndex = next;
+        historyValid = true;
+        historyCamera = camera;
+    } else {
+        UpscalePushConstants up{ static_cast<int32_t>(traced.width), static_cast<int32_t>(traced.height),
+                                 static_cast<int32_t>(extent.width), static_cast<int32_t>(extent.height) };
+        VkDescriptorSet sets[2] = { frame.traceSet, outputSet };
+        upscalePass->bind(cmd, sets, 2);
+        upscalePass->pushConstants(cmd, &up, sizeof(up));
+        vkCmdDispatch(cmd, (extent.width + 15) / 16, (extent.height + 15) / 16, 1);
+    }
+
+    if (profiler) profiler->end(cmd, GpuProfiler::Stage::Resolve);
+    frame.tracedScale = renderScale;
+}
+
+void ComputePipeline::recordDirect(VkCommandBuffer cmd, FrameResources& frame, uint32_t imageIndex, const CameraData& camera) {
+    VkImage swapImg = target.getImage(imageIndex);
+
+    // Swapchain images are CONCURRENT across our families, so no ownership transfer.
+    // srcStage matches the acquire wait stage so the transition waits for the acquire.
+    VkImageMemoryBarrier2 toGeneral{ VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2 };
+    toGeneral.srcStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+    toGeneral.srcAccessMask = 0;
+    toGeneral.dstStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+    toGeneral.dstAccessMask = VK_ACCESS_2_SHADER_WRITE_BIT;
+    toGeneral.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;            // whole image is overwritten
+    toGeneral.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+    toGeneral.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    toGeneral.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    toGeneral.image = swapImg;
+    toGeneral.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+
+    VkDependencyInfo depBegin{ VK_STRUCTURE_TYPE_DEPENDENCY_INFO };
+    depBegin.imageMemoryBarrierCount = 1;
+    depBegin.pImageMemoryBarriers = &toGeneral;
+    vkCmdPipelineBarrier2(cmd, &depBegin);
+
+    recordOutputPass(cmd, frame, frame.descriptorSet, camera);
+
+    VkImageMemoryBarrier2 toPresent = toGeneral;
+    toPresent.srcStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+    toPresent.srcAccessMask = VK_ACCESS_2_SHADER_WRITE_BIT;
+    toPresent.dstStageMask = VK_PIPELINE_STAGE_2_NONE;
+    toPresent.dstAccessMask = 0;
+    toPresent.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+    toPresent.newLayout = target.getFinalLayout();
+
+    VkDependencyInfo depEnd{ VK_STRUCTURE_TYPE_DEPENDENCY_INFO };
+    depEnd.imageMemoryBarrierCount = 1;
+    depEnd.pImageMemoryBarriers = &toPresent;
+    vkCmdPipelineBarrier2(cmd, &depEnd);
+}
+
+void ComputePipeline::dispatchDirect(FrameResources& frame, uint32_t imageIndex, VkSemaphore waitSemaphore,
+                                     VkSemaphore signalSemaphore, const CameraData& camera) {
+    // Single submit on the trace queue: acquire -> trace into swapchain image -> present
+    VkCommandBuffer cmd   = asyncCompute ? frame.cmdCompute     : frame.cmdGraphics;
+    VkQueue         queue = asyncCompute ? ctx.getComputeQueue() : ctx.getGraphicsQueue();
+
+    vkResetCommandBuffer(cmd, 0);
+    VkCommandBufferBeginInfo bi{ VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
+    bi.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    vkBeginCommandBuffer(cmd, &bi);
+    recordDirect(cmd, frame, imageIndex, camera);
+    vkEndCommandBuffer(cmd);
+
+    VkCommandBufferSubmitInfo cbInfo{ VK_STRUCTURE_TYPE_COMMAND_BUFFER_SUBMIT_INFO };
+    cbInfo.commandBuffer = cmd;
 
     VkSemaphoreSubmitInfo waitAcquire{ VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO };
     waitAcquire.semaphore = waitSemaphore;
     waitAcquire.stageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
 
-    VkSemaphoreSubmitInfo signalComputeDone{ VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO };
-    signalComputeDone.semaphore = computeFinished_;
-    signalComputeDone.stageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+    const TimelinePoint done = scheduler.signal(asyncCompute ? FrameScheduler::Queue::Compute
+                                                             : FrameScheduler::Queue::Graphics);
+
+    VkSemaphoreSubmitInfo signals[2]{};
+    signals[0] = { VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO };
+    signals[0].semaphore = done.semaphore;
+    signals[0].value = done.value;
+    signals[0].stageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+    uint32_t signalCount = 1;
+    if (signalSemaphore != VK_NULL_HANDLE) {
+        signals[1] = { VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO };
+        signals[1].semaphore = signalSemaphore;
+        signals[1].stageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+        ++signalCount;
+    }
 
-    VkSubmitInfo2 submitCompute{ VK_STRUCTURE_TYPE_SUBMIT_INFO_2 };
+    VkSubmitInfo2 submit{ VK_STRUCTURE_TYPE_SUBMIT_INFO_2 };
     if (waitSemaphore != VK_NULL_HANDLE) {
-        submitCompute.waitSemaphoreInfoCount = 1;
-        submitCompute.pWaitSemaphoreInfos = &waitAcquire;
+        submit.waitSemaphoreInfoCount = 1;
+        submit.pWaitSemaphoreInfos = &waitAcquire;
     }
-    submitCompute.commandBufferInfoCount = 1;
-    submitCompute.pCommandBufferInfos = &cbCompute;
-    submitCompute.signalSemaphoreInfoCount = 1;
-    submitCompute.pSignalSemaphoreInfos = &signalComputeDone;
+    submit.commandBufferInfoCount = 1;
+    submit.pCommandBufferInfos = &cbInfo;
+    submit.signalSemaphoreInfoCount = signalCount;
+    submit.pSignalSemaphoreInfos = signals;
 
-    if (vkQueueSubmit2(ctx.getComputeQueue(), 1, &submitCompute, VK_NULL_HANDLE) != VK_SUCCESS) {
-        throw std::runtime_error("[Compute] Failed to submit compute pass.");
+    if (vkQueueSubmit2(queue, 1, &submit, VK_NULL_HANDLE) != VK_SUCCESS) {
+        throw std::runtime_error("[Compute] Failed to submit direct compute pass.");
     }
+}
 
-    // ------- 2) GRAPHICS: record blit on graphics CMDBUF -------
-    vkResetCommandBuffer(cmdGraphics, 0);
-    VkCommandBufferBeginInfo biGfx{ VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
-    biGfx.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
-    vkBeginCommandBuffer(cmdGraphics, &biGfx);
+void ComputePipeline::recordTrace(VkCommandBuffer cmd, FrameResources& frame, const CameraData& camera) {
+    // Take the storage image back from the graphics family (released after last blit).
+    // The matching release was recorded on the graphics queue, so only dst scopes apply here.
+    if (frame.pendingAcquire) {
+        VkImageMemoryBarrier2 acquire = storageBarrier(frame, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_LAYOUT_GENERAL);
+        acquire.srcStageMask = VK_PIPELINE_STAGE_2_NONE;
+        acquire.srcAccessMask = 0;
+        acquire.dstStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+        acquire.dstAccessMask = VK_ACCESS_2_SHADER_WRITE_BIT;
+        acquire.srcQueueFamilyIndex = ctx.getGraphicsQueueFamily();
+        acquire.dstQueueFamilyIndex = ctx.getComputeQueueFamily();
+
+        VkDependencyInfo dep{ VK_STRUCTURE_TYPE_DEPENDENCY_INFO };
+        dep.imageMemoryBarrierCount = 1;
+        dep.pImageMemoryBarriers = &acquire;
+        vkCmdPipelineBarrier2(cmd, &dep);
+        frame.pendingAcquire = false;
+    }
 
-    VkImage swapImg = sc.getImage(imageIndex);
+    recordOutputPass(cmd, frame, frame.descriptorSet, camera);
 
-    // Transition swapchain to TRANSFER_DST
+    // storage GENERAL (shader write) -> TRANSFER_SRC for blit.
+    // With ownership transfer this is the release half; the graphics queue does the acquire.
+    VkImageMemoryBarrier2 storageToSrc = storageBarrier(frame, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+    storageToSrc.srcStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+    storageToSrc.srcAccessMask = VK_ACCESS_2_SHADER_WRITE_BIT;
+    if (ownershipTransfer) {
+        storageToSrc.dstStageMask = VK_PIPELINE_STAGE_2_NONE;
+        storageToSrc.dstAccessMask = 0;
+        storageToSrc.srcQueueFamilyIndex = ctx.getComputeQueueFamily();
+        storageToSrc.dstQueueFamilyIndex = ctx.getGraphicsQueueFamily();
+    } else {
+        storageToSrc.dstStageMask = VK_PIPELINE_STAGE_2_BLIT_BIT;
+        storageToSrc.dstAccessMask = VK_ACCESS_2_TRANSFER_READ_BIT;
+    }
+
+    VkDependencyInfo dep{ VK_STRUCTURE_TYPE_DEPENDENCY_INFO };
+    dep.imageMemoryBarrierCount = 1;
+    dep.pImageMemoryBarriers = &storageToSrc;
+    vkCmdPipelineBarrier2(cmd, &dep);
+}
+
+void ComputePipeline::recordBlit(VkCommandBuffer cmd, FrameResources& frame, uint32_t imageIndex) {
+    VkImage swapImg = target.getImage(imageIndex);
+    VkExtent2D extent = target.getExtent();
+
+    // Transition swapchain to TRANSFER_DST. srcStage matches the acquire wait stage
+    // so the layout transition happens after the presentation engine is done with it.
     VkImageMemoryBarrier2 presentToDst{ VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2 };
-    presentToDst.srcStageMask = VK_PIPELINE_STAGE_2_NONE; // fresh from acquire
+    presentToDst.srcStageMask = VK_PIPELINE_STAGE_2_BLIT_BIT;
     presentToDst.srcAccessMask = 0;
     presentToDst.dstStageMask = VK_PIPELINE_STAGE_2_BLIT_BIT;
     presentToDst.dstAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT;
@@ -408,10 +1636,26 @@ void ComputePipeline::dispatch(uint32_t imageIndex, VkSemaphore waitSemaphore, V
     presentToDst.image = swapImg;
     presentToDst.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
 
+    VkImageMemoryBarrier2 barriersBegin[2] = { presentToDst };
+    uint32_t beginCount = 1;
+    if (ownershipTransfer) {
+        // Acquire half of the compute -> graphics transfer.
+        VkImageMemoryBarrier2 acquire = storageBarrier(frame, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+        acquire.srcStageMask = VK_PIPELINE_STAGE_2_NONE;
+        acquire.srcAccessMask = 0;
+        acquire.dstStageMask = VK_PIPELINE_STAGE_2_BLIT_BIT;
+        acquire.dstAccessMask = VK_ACCESS_2_TRANSFER_READ_BIT;
+        acquire.srcQueueFamilyIndex = ctx.getComputeQueueFamily();
+        acquire.dstQueueFamilyIndex = ctx.getGraphicsQueueFamily();
+        barriersBegin[beginCount++] = acquire;
+    }
+
     VkDependencyInfo depGfxBegin{ VK_STRUCTURE_TYPE_DEPENDENCY_INFO };
-    depGfxBegin.imageMemoryBarrierCount = 1;
-    depGfxBegin.pImageMemoryBarriers = &presentToDst;
-    vkCmdPipelineBarrier2(cmdGraphics, &depGfxBegin);
+    depGfxBegin.imageMemoryBarrierCount = beginCount;
+    depGfxBegin.pImageMemoryBarriers = barriersBegin;
+    if (profiler) profiler->begin(cmd, GpuProfiler::Stage::Barriers);
+    vkCmdPipelineBarrier2(cmd, &depGfxBegin);
+    if (profiler) profiler->end(cmd, GpuProfiler::Stage::Barriers);
 
     // Blit storage -> swapchain
     VkOffset3D src0{0, 0, 0}, src1{ (int)extent.width, (int)extent.height, 1 };
@@ -425,71 +1669,179 @@ void ComputePipeline::dispatch(uint32_t imageIndex, VkSemaphore waitSemaphore, V
     blit.dstOffsets[0] = dst0;
     blit.dstOffsets[1] = dst1;
 
+    if (profiler) profiler->begin(cmd, GpuProfiler::Stage::Blit);
     vkCmdBlitImage(
-        cmdGraphics,
-        storageImage, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
-        swapImg,      VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        cmd,
+        frame.storageImage, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+        swapImg,            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
         1, &blit,
         VK_FILTER_NEAREST
     );
 
-    // Transition swapchain back to PRESENT, storage back to GENERAL
+    // Transition swapchain back to PRESENT (or the target's final layout), storage back to GENERAL
     VkImageMemoryBarrier2 dstToPresent{ VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2 };
     dstToPresent.srcStageMask = VK_PIPELINE_STAGE_2_BLIT_BIT;
     dstToPresent.srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT;
     dstToPresent.dstStageMask = VK_PIPELINE_STAGE_2_NONE;
     dstToPresent.dstAccessMask = 0;
     dstToPresent.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-    dstToPresent.newLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+    dstToPresent.newLayout = target.getFinalLayout();
     dstToPresent.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
     dstToPresent.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
     dstToPresent.image = swapImg;
     dstToPresent.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
 
-    VkImageMemoryBarrier2 storageBack{ VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2 };
+    // With ownership transfer: release back to compute, the next trace of this slot acquires.
+    VkImageMemoryBarrier2 storageBack = storageBarrier(frame, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_LAYOUT_GENERAL);
     storageBack.srcStageMask = VK_PIPELINE_STAGE_2_BLIT_BIT;
     storageBack.srcAccessMask = VK_ACCESS_2_TRANSFER_READ_BIT;
-    storageBack.dstStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
-    storageBack.dstAccessMask = VK_ACCESS_2_SHADER_WRITE_BIT;
-    storageBack.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
-    storageBack.newLayout = VK_IMAGE_LAYOUT_GENERAL;
-    storageBack.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-    storageBack.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-    storageBack.image = storageImage;
-    storageBack.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+    if (ownershipTransfer) {
+        storageBack.dstStageMask = VK_PIPELINE_STAGE_2_NONE;
+        storageBack.dstAccessMask = 0;
+        storageBack.srcQueueFamilyIndex = ctx.getGraphicsQueueFamily();
+        storageBack.dstQueueFamilyIndex = ctx.getComputeQueueFamily();
+        frame.pendingAcquire = true;
+    } else {
+        storageBack.dstStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+        storageBack.dstAccessMask = VK_ACCESS_2_SHADER_WRITE_BIT;
+    }
 
     VkImageMemoryBarrier2 barriersEnd[2] = { dstToPresent, storageBack };
     VkDependencyInfo depGfxEnd{ VK_STRUCTURE_TYPE_DEPENDENCY_INFO };
     depGfxEnd.imageMemoryBarrierCount = 2;
     depGfxEnd.pImageMemoryBarriers = barriersEnd;
-    vkCmdPipelineBarrier2(cmdGraphics, &depGfxEnd);
+    vkCmdPipelineBarrier2(cmd, &depGfxEnd);
+    if (profiler) profiler->end(cmd, GpuProfiler::Stage::Blit);
+}
 
+void ComputePipeline::dispatch(uint32_t imageIndex, VkSemaphore waitSemaphore, VkSemaphore signalSemaphore, const CameraData& camera) {
+    if (target.getGeneration() != targetGeneration) recreate();
+    FrameResources& frame = frames[scheduler.getFrameSlot()];
+    updateFrameSets(frame, imageIndex);
+
+    // Results of this slot's previous frame; never waits
+    const bool fresh = profiler && profiler->collect(scheduler.getFrameSlot());
+    if (rayStatistics) readRayStats(frame);
+    if (dynamicResolution) {
+        if (fresh) {
+            lastGpuMs = profiler->lastMs(GpuProfiler::Stage::Trace);
+            if (usesTraceTarget()) lastGpuMs += profiler->lastMs(GpuProfiler::Stage::Resolve);
+        }
+        updateRenderScale(frame, fresh);
+    }
+    if (!sameView(camera, lastCamera)) {
+        historyValid = false;
+        lastCamera = camera;
+    }
+    // beginFrame() retired this slot's previous frame, so its scene slot is free to rewrite
+    writeScene(scheduler.getFrameSlot(), camera);
+
+    if (directOutput) {
+        dispatchDirect(frame, imageIndex, waitSemaphore, signalSemaphore, camera);
+        return;
+    }
+
+    VkCommandBufferBeginInfo bi{ VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
+    bi.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+    // ------- 1) COMPUTE: trace on the async compute queue -------
+    // Does not wait on acquire: frame N+1 traces while frame N is still blitting/presenting.
+    TimelinePoint computeDone{};
+    if (asyncCompute) {
+        VkCommandBuffer cmdCompute = frame.cmdCompute;
+        vkResetCommandBuffer(cmdCompute, 0);
+        vkBeginCommandBuffer(cmdCompute, &bi);
+        recordTrace(cmdCompute, frame, camera);
+        vkEndCommandBuffer(cmdCompute);
+
+        VkCommandBufferSubmitInfo cbCompute{ VK_STRUCTURE_TYPE_COMMAND_BUFFER_SUBMIT_INFO };
+        cbCompute.commandBuffer = cmdCompute;
+
+        // GPU-side wait on this slot's previous blit: orders the graphics->compute release
+        // before our acquire. Already passed on the host by beginFrame(), so it costs nothing.
+        VkSemaphoreSubmitInfo waitPrevBlit{ VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO };
+        waitPrevBlit.semaphore = frame.lastBlit.semaphore;
+        waitPrevBlit.value = frame.lastBlit.value;
+        waitPrevBlit.stageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+
+        computeDone = scheduler.signal(FrameScheduler::Queue::Compute);
+
+        VkSemaphoreSubmitInfo signalComputeDone{ VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO };
+        signalComputeDone.semaphore = computeDone.semaphore;
+        signalComputeDone.value = computeDone.value;
+        // Everything in the buffer, not just the trace: the ray-stats copy into host memory
+        // ends it, and beginFrame()'s wait on this value is what makes the readback safe
+        signalComputeDone.stageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+
+        VkSubmitInfo2 submitCompute{ VK_STRUCTURE_TYPE_SUBMIT_INFO_2 };
+        if (frame.lastBlit.semaphore != VK_NULL_HANDLE) {
+            submitCompute.waitSemaphoreInfoCount = 1;
+            submitCompute.pWaitSemaphoreInfos = &waitPrevBlit;
+        }
+        submitCompute.commandBufferInfoCount = 1;
+        submitCompute.pCommandBufferInfos = &cbCompute;
+        submitCompute.signalSemaphoreInfoCount = 1;
+        submitCompute.pSignalSemaphoreInfos = &signalComputeDone;
+
+        if (vkQueueSubmit2(ctx.getComputeQueue(), 1, &submitCompute, VK_NULL_HANDLE) != VK_SUCCESS) {
+            throw std::runtime_error("[Compute] Failed to submit compute pass.");
+        }
+    }
+
+    // ------- 2) GRAPHICS: blit (and trace, when serialized) on graphics CMDBUF -------
+    VkCommandBuffer cmdGraphics = frame.cmdGraphics;
+    vkResetCommandBuffer(cmdGraphics, 0);
+    vkBeginCommandBuffer(cmdGraphics, &bi);
+    if (!asyncCompute) recordTrace(cmdGraphics, frame, camera);
+    recordBlit(cmdGraphics, frame, imageIndex);
     vkEndCommandBuffer(cmdGraphics);
 
-    // Submit graphics: wait on internal computeFinished_, signal app-provided signalSemaphore
+    // Submit graphics: wait on acquire (binary) and, when async, the compute timeline value.
+    // Signal the graphics timeline (slot retirement) and the app-provided binary signalSemaphore (present).
     VkCommandBufferSubmitInfo cbGfx{ VK_STRUCTURE_TYPE_COMMAND_BUFFER_SUBMIT_INFO };
     cbGfx.commandBuffer = cmdGraphics;
 
-    VkSemaphoreSubmitInfo waitComputeDone{ VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO };
-    waitComputeDone.semaphore = computeFinished_;
-    waitComputeDone.stageMask = VK_PIPELINE_STAGE_2_BLIT_BIT;
+    VkSemaphoreSubmitInfo waits[2]{};
+    uint32_t waitCount = 0;
+    if (waitSemaphore != VK_NULL_HANDLE) {
+        waits[waitCount] = { VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO };
+        waits[waitCount].semaphore = waitSemaphore;
+        waits[waitCount].stageMask = VK_PIPELINE_STAGE_2_BLIT_BIT;
+        ++waitCount;
+    }
+    if (asyncCompute) {
+        waits[waitCount] = { VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO };
+        waits[waitCount].semaphore = computeDone.semaphore;
+        waits[waitCount].value = computeDone.value;
+        waits[waitCount].stageMask = VK_PIPELINE_STAGE_2_BLIT_BIT;
+        ++waitCount;
+    }
 
-    VkSemaphoreSubmitInfo signalRenderDone{ VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO };
-    signalRenderDone.semaphore = signalSemaphore;
-    signalRenderDone.stageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+    const TimelinePoint graphicsDone = scheduler.signal(FrameScheduler::Queue::Graphics);
+    frame.lastBlit = graphicsDone;
+
+    VkSemaphoreSubmitInfo signals[2]{};
+    signals[0] = { VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO };
+    signals[0].semaphore = graphicsDone.semaphore;
+    signals[0].value = graphicsDone.value;
+    signals[0].stageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+    uint32_t signalCount = 1;
+    if (signalSemaphore != VK_NULL_HANDLE) {
+        signals[1] = { VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO };
+        signals[1].semaphore = signalSemaphore;
+        signals[1].stageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+        ++signalCount;
+    }
 
     VkSubmitInfo2 submitGfx{ VK_STRUCTURE_TYPE_SUBMIT_INFO_2 };
-    submitGfx.waitSemaphoreInfoCount = 1;
-    submitGfx.pWaitSemaphoreInfos = &waitComputeDone;
+    submitGfx.waitSemaphoreInfoCount = waitCount;
+    submitGfx.pWaitSemaphoreInfos = waitCount ? waits : nullptr;
     submitGfx.commandBufferInfoCount = 1;
     submitGfx.pCommandBufferInfos = &cbGfx;
-    submitGfx.signalSemaphoreInfoCount = (signalSemaphore != VK_NULL_HANDLE) ? 1u : 0u;
-    submitGfx.pSignalSemaphoreInfos = (signalSemaphore != VK_NULL_HANDLE) ? &signalRenderDone : nullptr;
+    submitGfx.signalSemaphoreInfoCount = signalCount;
+    submitGfx.pSignalSemaphoreInfos = signals;
 
     if (vkQueueSubmit2(ctx.getGraphicsQueue(), 1, &submitGfx, VK_NULL_HANDLE) != VK_SUCCESS) {
         throw std::runtime_error("[Compute] Failed to submit graphics blit.");
     }
-
-    // TEMP safety: fully serialize to avoid semaphore reuse warnings
-    vkQueueWaitIdle(ctx.getGraphicsQueue());
 }
@@ -2,71 +2,405 @@
 #include <vulkan/vulkan.h>
 #include <vector>
 #include <string>
+#include <memory>
+#include <array>
+
+#include "frame_scheduler.h"
+#include "gpu_memory.h"
+#include "gpu_profiler.h"
+#include "shader_variant.h"
+#include "../core/mapped_file.h"
+
 struct CameraData {
     float x, y, zoom, time;  // Changed padding to time
 };
+
+// Geodesic integrator baked into the trace pipeline (gargantua.comp INTEGRATOR)
+enum class GeodesicIntegrator : int32_t {
+    RK4          = 0,   // fixed step tiers (reference)
+    DormandPrince = 1,  // adaptive 5(4), error-controlled step size
+};
+
+// Spacetime the trace integrates (geodesic.glsl METRIC); Kerr's spin is per-frame scene state
+enum class GeodesicMetric : int32_t {
+    Schwarzschild = 0,   // Cartesian second-order form (the fast path)
+    Kerr          = 1,   // Boyer-Lindquist Hamiltonian with conserved E, L (and Carter Q)
+};
+
+// Per-frame scene state beyond the camera push constant (SceneState in trace_common.glsl).
+// Each frame's values go into its slot of a mapped uniform ring, so changes cost a memcpy.
+struct SceneParams {
+    float exposure       = 1.05f;
+    float gamma          = 0.7f;
+    float saturation     = 1.25f;
+    float contrast       = 1.15f;
+    float diskSpeed      = 3.0f;    // disk rotation rate (noise and texture scroll)
+    float diskBrightness = 1.0f;    // disk emission scale
+    float focalLength    = 1.2f;    // view ray z per image height; larger is a narrower view
+    float pitch          = 1.2f;    // camera elevation (rad) before the CameraData::y drag
+    float orbitRate      = 0.05f;   // azimuth (rad) per unit of CameraData::time
+};
+
+// How the trace workgroup shape is chosen (see WorkgroupTuner)
+enum class WorkgroupTuning {
+    Off,     // variant.groupWidth x groupHeight as given
+    Auto,    // the stored winner for this device and driver; benchmark once if there is none
+    Force,   // benchmark at startup even if a winner is stored
+};
+
+struct ComputePipelineOptions {
+    // Trace on the compute queue without waiting for acquire, so frame N+1's dispatch
+    // overlaps frame N's blit and present. Uses queue-family ownership transfers on the
+    // per-frame storage images when compute and graphics families differ.
+    // false: trace + blit are recorded into one graphics-queue command buffer.
+    bool asyncCompute = true;
+
+    // Write straight into the swapchain images when the swapchain was created with
+    // STORAGE usage (see Swapchain allowStorage). Falls back to storage image + blit.
+    bool directToSwapchain = true;
+
+    // Dynamic resolution: trace at a reduced internal resolution chosen each frame from
+    // measured GPU time, then reconstruct at swapchain resolution with upscale.comp.
+    bool  dynamicResolution = false;
+    float targetFrameMs     = 16.6f;   // GPU budget for trace + upscale
+    float minRenderScale    = 0.5f;    // per-axis floor of the internal resolution
+
+    // Temporal accumulation: trace 1 jittered sample per pixel and blend it into a
+    // history buffer (temporal.comp) instead of the shader's 2x2 supersampling loop.
+    // History restarts whenever the camera position/zoom changes or the swapchain is rebuilt.
+    // Also does the reconstruction when dynamic resolution is on (replaces upscale.comp).
+    bool     temporalAccumulation = true;
+    uint32_t maxHistoryFrames     = 16;   // blend floor = 1 / maxHistoryFrames
+
+    // Look Schwarzschild photon paths up in a table baked per camera radius
+    // (DeflectionLut) instead of integrating up to MAX_GEODESIC_STEPS per pixel.
+    bool deflectionLut = false;
+
+    // Face edge of the baked background cubemap (SkyEnvironment); escaping rays fetch it
+    // instead of evaluating the star and nebula noise. 0 keeps the per-ray procedural sky.
+    uint32_t skyFaceSize = 1024;
+
+    // Raymarch the disk through baked turbulence and radial emission textures
+    // (DiskTextures) instead of per-step hash noise, sqrt and fades
+    bool diskTextures = true;
+
+    // Two-pass trace: a pre-pass classifies 8x8 pixel blocks from a few probe rays as
+    // sky-only, shadow or complex (photon ring, disk), and only complex blocks get the
+    // variant's samplesPerAxis^2 samples; the others take one. Needs temporal
+    // accumulation off (it already traces one sample); ignored in wavefront mode.
+    bool blockClassification = false;
+
+    // Adaptive supersampling: trace one jittered sample per pixel, list the pixels whose 3x3
+    // neighbourhood spans more than adaptiveThreshold in tone-mapped luminance, and trace
+    // the variant's full sample grid again only for those (an indirect dispatch over the
+    // list). Same restrictions as blockClassification, which it replaces when both are set.
+    bool  adaptiveSampling  = false;
+    float adaptiveThreshold = 0.08f;
+
+    // GPU stage timings (GpuProfiler); statistics adds compute-invocation counts.
+    // Dynamic resolution uses the profiler's timestamps and creates it on its own.
+    bool profiling          = false;
+    bool pipelineStatistics = false;
+
+    // Per-sample step counts, terminations and disk crossings reduced into histograms on
+    // the GPU (RAY_STATS) and handed to the profiler each frame. Costs shared-memory
+    // atomics per sample; not supported in wavefront mode.
+    bool rayStatistics      = false;
+
+    // Selected at pipeline creation; tolerance is the per-step local error for DormandPrince
+    GeodesicIntegrator integrator = GeodesicIntegrator::RK4;
+    float              integratorTolerance = 1e-4f;
+
+    // Kerr traces a rotating hole with the given spin a/M (|spin| < 1, changeable per frame
+    // with setSpin()). The deflection LUT is Schwarzschild only and is ignored with Kerr.
+    GeodesicMetric     metric = GeodesicMetric::Schwarzschild;
+    float              spin   = 0.9f;
+
+    // Tone, disk and lens parameters; change later with setSceneParams()
+    SceneParams        scene{};
+
+    // Interaction radius (in Rs): rays outside it are moved along straight lines with a
+    // first-order bend instead of being stepped. 0 integrates everything to r = 100.
+    float farFieldRadius = 20.0f;
+
+    // Initial quality/feature/debug specialization; switch later with setVariant()
+    TraceVariant variant{};
+
+    WorkgroupTuning workgroupTuning = WorkgroupTuning::Auto;
+
+    // Trace in stages over a ray buffer (WavefrontTracer) instead of one loop per pixel:
+    // surviving rays are compacted between fixed step chunks and disk crossings are shaded
+    // in their own pass. Ignored with the deflection LUT; the workgroup shape is not tuned.
+    bool wavefront = false;
+
+    // Load the *_fp16 builds of the trace shaders (float16 noise and colour math in the
+    // disk and background shading) when the device supports shaderFloat16
+    bool halfShading = true;
+};
+
 class VulkanContext;
-class Swapchain;
+class RenderTarget;
+class ComputePass;
+class DeflectionLut;
+class SkyEnvironment;
+class DiskTextures;
+class WavefrontTracer;
 
 class ComputePipeline {
 public:
-    // shaderSpvPath should be an absolute path
-    ComputePipeline(VulkanContext& context, Swapchain& swapchain, const std::string& shaderSpvPath);
+    // shaderSpvPath should be an absolute path; auxiliary shaders are loaded from the same directory.
+    // The scheduler decides how many frames are in flight and when a slot may be reused.
+    // The target is the swapchain, or an OffscreenTarget when rendering headless.
+    ComputePipeline(VulkanContext& context, RenderTarget& target, FrameScheduler& scheduler,
+                    const std::string& shaderSpvPath, const ComputePipelineOptions& options = {});
     ~ComputePipeline();
 
     ComputePipeline(const ComputePipeline&) = delete;
     ComputePipeline& operator=(const ComputePipeline&) = delete;
 
-    // Rebuild descriptors and storage image when swapchain changes
+    // Rebuild storage images for a changed target (swapchain); dispatch() calls it when the
+    // target's generation moved. Doesn't wait for the GPU: the old images and buffers are
+    // retired as their frames finish, and each slot's descriptor sets are rewritten in
+    // place when the slot next dispatches.
     void recreate();
 
-    // Records & submits:
-    //   1) compute dispatch (compute queue)
-    //   2) storage->swapchain blit (graphics queue)
-    // Uses waitSemaphore (from acquire) and signalSemaphore (for present).
+    // Records & submits into the scheduler's current frame slot:
+    //   1) compute dispatch (compute queue, signals the compute timeline)
+    //   2) storage->swapchain blit (graphics queue, waits compute, signals the graphics timeline)
+    // With asyncCompute off both are recorded into a single graphics-queue submit.
+    // Uses waitSemaphore (binary, from acquire, waited by the blit) and signalSemaphore (binary, for present).
+    // Both may be VK_NULL_HANDLE; imageIndex selects the target image, left in its final layout.
+    // Call between FrameScheduler::beginFrame() and endFrame().
     void dispatch(uint32_t imageIndex, VkSemaphore waitSemaphore, VkSemaphore signalSemaphore, const CameraData& camera);
 
+    uint32_t   getFramesInFlight() const { return static_cast<uint32_t>(frames.size()); }
+
+    // Dynamic resolution state (scale is 1 when the mode is off)
+    float      getRenderScale()    const { return renderScale; }
+    VkExtent2D getRenderExtent()   const { return renderExtent; }
+    float      getLastGpuMs()      const { return lastGpuMs; }   // trace (+ resolve), lags by framesInFlight
+    // Camera rays per traced pixel and frame: 1 under temporal accumulation, else AA^2
+    // (the upper bound with block classification or adaptive sampling)
+    uint32_t   getSamplesPerPixel() const {
+        return temporalAccumulation ? 1u : static_cast<uint32_t>(variant.samplesPerAxis * variant.samplesPerAxis);
+    }
+
+    // Tiled stills: following dispatches trace rect (of an imageSize image) into the target's
+    // top-left rect.extent pixels, so a small target can build a poster-size image tile by tile.
+    // Needs temporalAccumulation and dynamicResolution off. clearTile() restores full frames.
+    void       setTile(const VkRect2D& rect, VkExtent2D imageSize);
+    void       clearTile();
+
+    // Switches the trace to another specialization (quality preset, debug view, features).
+    // Each variant's pipeline is built on first use and kept, so switching back is free.
+    void                setVariant(const TraceVariant& variant);
+    const TraceVariant& getVariant() const { return variant; }
+
+    // Kerr spin a/M for the following dispatches (scene state: no pipeline rebuild).
+    // Clamped to +-0.998; no effect on the Schwarzschild metric.
+    void                setSpin(float spin);
+    float               getSpin() const { return spin; }
+    GeodesicMetric      getMetric() const { return metric; }
+
+    // Tone, disk and lens parameters for the following dispatches; restarts the history
+    void                setSceneParams(const SceneParams& params);
+    const SceneParams&  getSceneParams() const { return scene; }
+
+    // Times every candidate workgroup shape on a scratch image, switches the trace to the
+    // fastest and stores it for this device. Drains the GPU; call outside beginFrame/endFrame.
+    VkExtent2D          autotuneWorkgroup();
+
+    // nullptr unless profiling or dynamic resolution is on
+    GpuProfiler* getProfiler()     const { return profiler.get(); }
+
 private:
     // Creation
     void createDescriptorSetLayout();
     void createPipelineLayout();
-    void createPipelineFromCode(const std::vector<char>& code);
-    void createDescriptorPoolAndSets();     // single STORAGE image descriptor
-    void allocateCommandBuffers();          // compute + graphics
+    struct TraceSpecialization;             // TraceSpecConstants + map entries, see the .cpp
+    void fillTraceSpecialization(const TraceVariant& variant, TraceSpecialization& spec) const;
+    // Specializations of the trace shader recorded around the trace itself
+    enum AuxPass { ClassifyPass, MarkPass, RefinePass, AuxPassCount };
+    using AuxPipelines = std::array<VkPipeline, AuxPassCount>;
 
-    // Offscreen storage image (compute target)
-    void createStorageImage();
-    void destroyStorageImage();
-    uint32_t findMemoryType(uint32_t typeBits, VkMemoryPropertyFlags props) const;
+    VkPipeline createTracePipeline(const TraceVariant& variant, int auxPass = -1) const;   // -1: the trace
+    void selectTracePipeline();             // pipeline (+ auxPipelines) for variant; wavefront: rebuilt stages
+    void createUpscalePass(const std::string& shaderDir);
+    void createTemporalPass(const std::string& shaderDir);
+    void createDescriptorPoolAndSets();     // output set per frame/swapchain image, trace set per frame, history sets
+    void allocateCommandBuffers();          // compute + graphics per frame
+
+    // Offscreen images (compute targets, one per frame; history is shared)
+    void createStorageImages();
+    void retireStorageImages();             // destroyed, and their arena rewound, once the GPU is past them
+    void createImage(VkExtent2D extent, VkFormat format, VkImageUsageFlags usage,
+                     VkImage& image, GpuAllocation& memory, VkImageView& view, GpuArena* arena);   // null: GpuMemory
+    // Set 0 bindings 1-3 of the trace, sized for extent (a word each when their mode is off)
+    struct TraceBuffer {
+        VkBuffer        buffer = VK_NULL_HANDLE;
+        GpuAllocation   memory;
+    };
+    void createTraceBuffers(VkExtent2D extent);
+    void createTraceBuffer(TraceBuffer& buffer, VkDeviceSize size, VkBufferUsageFlags usage);   // from targetMemory
+    void createSceneRing();                 // set 0 binding 4, mapped for the pipeline's lifetime
+    void createRayStatsBuffers();           // set 0 binding 5 and its per-slot readback
+    void writeScene(uint32_t slot, const CameraData& camera);
+    void writeOutputSet(VkDescriptorSet set, VkImageView view) const;   // image + trace buffers + scene ring + ray stats
+    void writeOutputImage(VkDescriptorSet set, VkImageView view) const; // binding 0 only
 
     // Helpers
-    static std::vector<char> readFile(const std::string& path);
+    void rebuildOutputPipelines();          // after the output path (sRGB encode) changed
+    bool usesTraceTarget() const { return dynamicResolution || temporalAccumulation; }
+    TraceVariant sanitize(TraceVariant variant) const;
+    FrameScheduler::Queue traceQueue() const {
+        return asyncCompute ? FrameScheduler::Queue::Compute : FrameScheduler::Queue::Graphics;
+    }
 
 private:
+    // Everything a single frame touches while it is in flight on the GPU.
+    // Reuse is gated by the scheduler's timeline values for the slot.
+    struct FrameResources {
+        VkCommandBuffer  cmdCompute      = VK_NULL_HANDLE; // from compute pool
+        VkCommandBuffer  cmdGraphics     = VK_NULL_HANDLE; // from graphics pool
+
+        VkImage          storageImage    = VK_NULL_HANDLE;
+        GpuAllocation    storageMemory;
+        VkImageView      storageView     = VK_NULL_HANDLE;
+        VkDescriptorSet  descriptorSet   = VK_NULL_HANDLE; // storageView, or the acquired image under direct output
+        VkImageView      outputView      = VK_NULL_HANDLE; // what descriptorSet's binding 0 holds
+
+        // Trace target when a resolve pass follows (dynamic resolution and/or temporal);
+        // under dynamic resolution only a renderExtent sub-rect is traced
+        VkImage          traceImage      = VK_NULL_HANDLE;
+        GpuAllocation    traceMemory;
+        VkImageView      traceView       = VK_NULL_HANDLE;
+        VkDescriptorSet  traceSet        = VK_NULL_HANDLE; // bound to traceView
+        std::array<VkDescriptorSet, 2> historySets{};      // bound to history[0] / history[1]
+        bool             staleSets       = true;           // images replaced since the sets were written
+
+        float            tracedScale     = 1.0f;           // render scale the slot's timings measured
+
+        TimelinePoint    lastBlit{};                       // graphics value of the slot's last blit
+        bool             pendingAcquire  = false;          // graphics released the image back to compute
+        uint32_t         rayStatsBinWidth = 0;             // non-zero: readback block holds the slot's last frame
+    };
+
+    // Recording helpers (shared by the async and serialized paths)
+    void recordOutputPass(VkCommandBuffer cmd, FrameResources& frame, VkDescriptorSet outputSet, const CameraData& camera);
+    // Brings the slot's sets up to date; only once beginFrame() retired its previous frame
+    void updateFrameSets(FrameResources& frame, uint32_t imageIndex);
+    void recordTrace(VkCommandBuffer cmd, FrameResources& frame, const CameraData& camera);
+    // Trace dispatch with its classification or adaptive passes; sets and push constants bound
+    void recordTraceDispatch(VkCommandBuffer cmd, VkExtent2D traced);
+    void recordClassify(VkCommandBuffer cmd, VkExtent2D traced);
+    void recordRefine(VkCommandBuffer cmd, VkExtent2D traced);
+    void recordBlit(VkCommandBuffer cmd, FrameResources& frame, uint32_t imageIndex);
+    void recordDirect(VkCommandBuffer cmd, FrameResources& frame, uint32_t imageIndex, const CameraData& camera);
+    void dispatchDirect(FrameResources& frame, uint32_t imageIndex, VkSemaphore waitSemaphore,
+                        VkSemaphore signalSemaphore, const CameraData& camera);
+    VkImageMemoryBarrier2 storageBarrier(const FrameResources& frame, VkImageLayout oldLayout, VkImageLayout newLayout) const;
+
+    // Dynamic resolution
+    void updateRenderScale(const FrameResources& frame, bool freshSample);
+
+    // Ray statistics around the trace, and the slot's previous frame into the profiler
+    void recordRayStatsReset(VkCommandBuffer cmd);
+    void recordRayStatsCopy(VkCommandBuffer cmd, FrameResources& frame);
+    void readRayStats(FrameResources& frame);
+
     VulkanContext& ctx;
-    Swapchain&     sc;
+    RenderTarget&  target;
+    FrameScheduler& scheduler;
     VkDevice       device = VK_NULL_HANDLE;
 
     // Pipeline objects
-    VkDescriptorSetLayout        descriptorSetLayout = VK_NULL_HANDLE;
+    VkDescriptorSetLayout        descriptorSetLayout = VK_NULL_HANDLE; // storage image at 0, trace buffers at 1-3, scene at 4, ray stats at 5
     VkPipelineLayout             pipelineLayout      = VK_NULL_HANDLE;
-    VkPipeline                   pipeline            = VK_NULL_HANDLE;
+    VkPipeline                   pipeline            = VK_NULL_HANDLE;   // trace, current variant
+    std::vector<std::pair<TraceVariant, VkPipeline>> tracePipelines;     // every variant built so far
+    AuxPipelines                 auxPipelines{};                         // current variant's, null when unused
+    std::vector<std::pair<TraceVariant, AuxPipelines>> auxBuilt;
     VkDescriptorPool             descriptorPool      = VK_NULL_HANDLE;
-    VkDescriptorSet              descriptorSet       = VK_NULL_HANDLE; // bound to storage image
-
-    // Command buffers
-    VkCommandBuffer              cmdCompute          = VK_NULL_HANDLE; // from compute pool
-    VkCommandBuffer              cmdGraphics         = VK_NULL_HANDLE; // from graphics pool
+    std::unique_ptr<ComputePass> upscalePass;                          // set 0: trace, set 1: output
+    std::unique_ptr<ComputePass> temporalPass;                         // trace, history in, history out, output
+    std::unique_ptr<DeflectionLut> lut;                                // trace set 1 (placeholder when off)
+    std::unique_ptr<SkyEnvironment> sky;                               // trace set 2 (placeholder when off)
+    std::unique_ptr<DiskTextures> disk;                                // trace set 3 (placeholder when off)
+    std::unique_ptr<WavefrontTracer> wavefront;                        // replaces pipeline when set
 
-    // Internal chaining semaphore: compute -> graphics
-    VkSemaphore                  computeFinished_    = VK_NULL_HANDLE;
+    // Per-frame command buffers and storage images
+    std::vector<FrameResources>  frames;
+    // Target-sized images and trace buffers. A recreate() retires the arena with them and
+    // takes the spare; a retired arena is rewound and becomes the spare once the GPU is
+    // done with it, so resizing allocates no device memory unless the target grows.
+    std::unique_ptr<GpuArena>    targetMemory;
+    std::unique_ptr<GpuArena>    spareMemory;
+    uint64_t                     targetGeneration    = 0;   // target.getGeneration() the images match
 
-    // Offscreen storage image + view + memory
-    VkImage                      storageImage        = VK_NULL_HANDLE;
-    VkDeviceMemory               storageMemory       = VK_NULL_HANDLE;
-    VkImageView                  storageView         = VK_NULL_HANDLE;
+    // Written into every set 0: the trace references them even with their mode off.
+    // Shared by all frames like the history images (one queue, barriers between traces).
+    TraceBuffer                  blockClasses;       // binding 1: uint per block
+    TraceBuffer                  refineList;         // binding 2: count, indirect args, pixel list
+    TraceBuffer                  firstSamples;       // binding 3: fp16 RGBA per pixel
+    // Scene state ring: one SceneState slot per frame in flight, indexed by the push
+    // constant; a slot is rewritten only once the scheduler has retired its previous frame
+    TraceBuffer                  sceneRing;          // binding 4, host-visible, lives as long as the pipeline
+    // Ray statistics: one set of counters cleared before every trace, then copied into the
+    // frame slot's block of a mapped readback buffer, read when the slot comes around again
+    TraceBuffer                  rayStats;           // binding 5, placeholder-sized in use or not
+    TraceBuffer                  rayStatsReadback;   // kRayStatWords per frame slot, host-visible
+    bool                         rayStatistics       = false;
+    SceneParams                  scene{};
+    bool                         blockClassification = false;
+    bool                         adaptiveSampling    = false;
+    float                        adaptiveThreshold   = 0.08f;
     VkFormat                     storageFormat       = VK_FORMAT_R8G8B8A8_UNORM;
+    VkFormat                     traceFormat         = VK_FORMAT_R16G16B16A16_SFLOAT;
+
+    // Temporal accumulation. History is ping-ponged and shared by all frames: every trace
+    // and resolve runs on the same queue, so submission order plus a barrier orders them.
+    struct HistoryImage {
+        VkImage         image  = VK_NULL_HANDLE;
+        GpuAllocation   memory;
+        VkImageView     view   = VK_NULL_HANDLE;
+    };
+    std::array<HistoryImage, 2>  history{};
+    uint32_t                     historyIndex        = 0;      // image holding the latest result
+    bool                         historyValid        = false;
+    CameraData                   lastCamera{};
+    CameraData                   historyCamera{};              // camera of the latest result (reprojection)
+    bool                         temporalAccumulation = true;
+    uint32_t                     maxHistoryFrames    = 16;
+
+    GeodesicIntegrator           integrator          = GeodesicIntegrator::RK4;
+    float                        integratorTolerance = 1e-4f;
+    GeodesicMetric               metric              = GeodesicMetric::Schwarzschild;
+    float                        spin                = 0.0f;
+    float                        farFieldRadius      = 20.0f;
+    TraceVariant                 variant{};
+    bool                         halfShading         = false;   // shaderCode is the *_fp16 build
+
+    // Queue mode
+    bool                         asyncCompute        = true;
+    bool                         ownershipTransfer   = false;
+    bool                         allowDirectOutput   = true;
+    bool                         directOutput        = false;
+
+    // Dynamic resolution
+    bool                         dynamicResolution   = false;
+    float                        targetFrameMs       = 16.6f;
+    float                        minRenderScale      = 0.5f;
+    float                        renderScale         = 1.0f;
+    float                        lastGpuMs           = 0.0f;
+    VkExtent2D                   renderExtent{0, 0};
+
+    // Tiled stills (setTile)
+    bool                         tiled               = false;
+    VkRect2D                     tile{};
+    VkExtent2D                   tileImageSize{0, 0};
+
+    std::unique_ptr<GpuProfiler> profiler;
 
-    // Cached SPIR-V
-    std::vector<char>            shaderCode;
+    // SPIR-V, mapped for the pipeline's lifetime (rebuilds)
+    MappedFile                   shaderCode;
 };
@@ -0,0 +1,197 @@
+#include "deflection_lut.h"
+#include "vulkan_context.h"
+#include "compute_pass.h"
+
+#include <stdexcept>
+#include <iostream>
+#include <vector>
+
+namespace {
+    // The bake only uses geodesic.glsl's constants; data must outlive the pipeline build
+    struct GeodesicSpecialization {
+        std::vector<VkSpecializationMapEntry> entries;
+        VkSpecializationInfo                  info{};
+
+        explicit GeodesicSpecialization(const GeodesicSpecConstants& data) {
+            GeodesicSpecConstants::appendEntries(entries, 0);
+            info = { static_cast<uint32_t>(entries.size()), entries.data(), sizeof(data), &data };
+        }
+    };
+}
+
+DeflectionLut::DeflectionLut(VulkanContext& context, const std::string& shaderDir, bool enable,
+                             const GeodesicSpecConstants& geodesic)
+    : ctx(context), device(context.getDevice()), enabled(enable) {
+
+    const uint32_t w  = enabled ? kImpactSamples : 1u;
+    const uint32_t hp = enabled ? kPhiSamples : 1u;
+    const uint32_t hs = enabled ? 2u : 1u;
+    createImage(path,    w, hp, VK_FORMAT_R32_SFLOAT);
+    createImage(summary, w, hs, VK_FORMAT_R32G32B32A32_SFLOAT);
+    createDescriptors();
+
+    if (enabled) {
+        const GeodesicSpecialization spec(geodesic);
+        bakePass = std::make_unique<ComputePass>(ctx, MappedFile(shaderDir + "/deflection_lut.comp.spv"),
+            std::vector<VkDescriptorSetLayout>{ setLayout }, static_cast<uint32_t>(sizeof(float)), &spec.info);
+        std::cout << "[LUT] Deflection table enabled (" << kImpactSamples << " x " << kPhiSamples << ").\n";
+    }
+}
+
+DeflectionLut::~DeflectionLut() {
+    // Caller guarantees the GPU is idle (ComputePipeline drains the scheduler first)
+    bakePass.reset();
+    if (pool)      vkDestroyDescriptorPool(device, pool, nullptr);
+    if (setLayout) vkDestroyDescriptorSetLayout(device, setLayout, nullptr);
+    for (Image* img : { &path, &summary }) {
+        if (img->view)   vkDestroyImageView(device, img->view, nullptr);
+        if (img->image)  vkDestroyImage(device, img->image, nullptr);
+        ctx.getMemory().free(img->memory);
+    }
+}
+
+void DeflectionLut::createImage(Image& img, uint32_t width, uint32_t height, VkFormat format) {
+    VkImageCreateInfo ici{};
+    ici.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    ici.imageType = VK_IMAGE_TYPE_2D;
+    ici.format = format;
+    ici.extent = { width, height, 1 };
+    ici.mipLevels = 1;
+    ici.arrayLayers = 1;
+    ici.samples = VK_SAMPLE_COUNT_1_BIT;
+    ici.tiling = VK_IMAGE_TILING_OPTIMAL;
+    ici.usage = VK_IMAGE_USAGE_STORAGE_BIT;
+    ici.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    ici.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+    if (vkCreateImage(device, &ici, nullptr, &img.image) != VK_SUCCESS) {
+        throw std::runtime_error("[LUT] Failed to create table image.");
+    }
+
+    img.memory = ctx.getMemory().bind(img.image, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+    VkImageViewCreateInfo vci{};
+    vci.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    vci.image = img.image;
+    vci.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    vci.format = format;
+    vci.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+
+    if (vkCreateImageView(device, &vci, nullptr, &img.view) != VK_SUCCESS) {
+        throw std::runtime_error("[LUT] Failed to create table image view.");
+    }
+}
+
+void DeflectionLut::createDescriptors() {
+    VkDescriptorSetLayoutBinding bindings[2]{};
+    for (uint32_t i = 0; i < 2; ++i) {
+        bindings[i].binding = i;
+        bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+        bindings[i].descriptorCount = 1;
+        bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    }
+
+    VkDescriptorSetLayoutCreateInfo lci{};
+    lci.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    lci.bindingCount = 2;
+    lci.pBindings = bindings;
+    if (vkCreateDescriptorSetLayout(device, &lci, nullptr, &setLayout) != VK_SUCCESS) {
+        throw std::runtime_error("[LUT] Failed to create descriptor set layout.");
+    }
+
+    VkDescriptorPoolSize poolSize{ VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 2 };
+    VkDescriptorPoolCreateInfo pci{};
+    pci.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    pci.maxSets = 1;
+    pci.poolSizeCount = 1;
+    pci.pPoolSizes = &poolSize;
+    if (vkCreateDescriptorPool(device, &pci, nullptr, &pool) != VK_SUCCESS) {
+        throw std::runtime_error("[LUT] Failed to create descriptor pool.");
+    }
+
+    VkDescriptorSetAllocateInfo ai{};
+    ai.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    ai.descriptorPool = pool;
+    ai.descriptorSetCount = 1;
+    ai.pSetLayouts = &setLayout;
+    if (vkAllocateDescriptorSets(device, &ai, &set) != VK_SUCCESS) {
+        throw std::runtime_error("[LUT] Failed to allocate descriptor set.");
+    }
+
+    VkDescriptorImageInfo infos[2]{};
+    infos[0] = { VK_NULL_HANDLE, path.view,    VK_IMAGE_LAYOUT_GENERAL };
+    infos[1] = { VK_NULL_HANDLE, summary.view, VK_IMAGE_LAYOUT_GENERAL };
+
+    VkWriteDescriptorSet writes[2]{};
+    for (uint32_t i = 0; i < 2; ++i) {
+        writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        writes[i].dstSet = set;
+        writes[i].dstBinding = i;
+        writes[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+        writes[i].descriptorCount = 1;
+        writes[i].pImageInfo = &infos[i];
+    }
+    vkUpdateDescriptorSets(device, 2, writes, 0, nullptr);
+}
+
+void DeflectionLut::setGeodesic(const GeodesicSpecConstants& geodesic) {
+    if (!enabled) return;
+    const GeodesicSpecialization spec(geodesic);
+    bakePass->rebuild(&spec.info);
+    bakedRadius = -1.0f;
+}
+
+void DeflectionLut::record(VkCommandBuffer cmd, float cameraRadius) {
+    if (!initialized) {
+        VkImageMemoryBarrier2 barriers[2]{};
+        VkImage images[2] = { path.image, summary.image };
+        for (uint32_t i = 0; i < 2; ++i) {
+            barriers[i].sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2;
+            barriers[i].srcStageMask = VK_PIPELINE_STAGE_2_NONE;
+            barriers[i].dstStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+            barriers[i].dstAccessMask = VK_ACCESS_2_SHADER_WRITE_BIT;
+            barriers[i].oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+            barriers[i].newLayout = VK_IMAGE_LAYOUT_GENERAL;
+            barriers[i].srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            barriers[i].dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            barriers[i].image = images[i];
+            barriers[i].subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+        }
+
+        VkDependencyInfo dep{ VK_STRUCTURE_TYPE_DEPENDENCY_INFO };
+        dep.imageMemoryBarrierCount = 2;
+        dep.pImageMemoryBarriers = barriers;
+        vkCmdPipelineBarrier2(cmd, &dep);
+        initialized = true;
+    }
+
+    if (!enabled || cameraRadius == bakedRadius) return;
+
+    // Earlier frames on this queue may still be reading the old table
+    VkMemoryBarrier2 war{ VK_STRUCTURE_TYPE_MEMORY_BARRIER_2 };
+    war.srcStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+    war.dstStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+    war.dstAccessMask = VK_ACCESS_2_SHADER_WRITE_BIT;
+
+    VkDependencyInfo depWar{ VK_STRUCTURE_TYPE_DEPENDENCY_INFO };
+    depWar.memoryBarrierCount = 1;
+    depWar.pMemoryBarriers = &war;
+    vkCmdPipelineBarrier2(cmd, &depWar);
+
+    bakePass->bind(cmd, &set, 1);
+    bakePass->pushConstants(cmd, &cameraRadius, sizeof(cameraRadius));
+    vkCmdDispatch(cmd, (kImpactSamples + 63) / 64, 1, 1);
+
+    VkMemoryBarrier2 raw{ VK_STRUCTURE_TYPE_MEMORY_BARRIER_2 };
+    raw.srcStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+    raw.srcAccessMask = VK_ACCESS_2_SHADER_WRITE_BIT;
+    raw.dstStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+    raw.dstAccessMask = VK_ACCESS_2_SHADER_READ_BIT;
+
+    VkDependencyInfo depRaw{ VK_STRUCTURE_TYPE_DEPENDENCY_INFO };
+    depRaw.memoryBarrierCount = 1;
+    depRaw.pMemoryBarriers = &raw;
+    vkCmdPipelineBarrier2(cmd, &depRaw);
+
+    bakedRadius = cameraRadius;
+}
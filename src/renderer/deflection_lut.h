@@ -0,0 +1,76 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <memory>
+#include <string>
+
+#include "shader_variant.h"
+#include "gpu_memory.h"
+
+class VulkanContext;
+class ComputePass;
+
+/**
+ * DeflectionLut
+ * =============
+ * Precomputed Schwarzschild photon paths for the trace shader (USE_LUT).
+ * For a non-rotating hole a ray's orbit depends only on its impact parameter and
+ * the camera radius, so deflection_lut.comp integrates one ray per impact parameter
+ * and gargantua.comp looks paths up instead of stepping them per pixel.
+ *
+ * The table is rebaked (on the trace queue, inline with the frame) whenever the
+ * camera radius or the geodesic specialization changes. Sizes must match the LUT_*
+ * constants in geodesic.glsl.
+ *
+ * The set layout is always part of the trace pipeline layout; when disabled the
+ * images are 1x1 placeholders that the shader never reads.
+ */
+class DeflectionLut {
+public:
+    DeflectionLut(VulkanContext& context, const std::string& shaderDir, bool enabled,
+                  const GeodesicSpecConstants& geodesic);
+    ~DeflectionLut();
+
+    DeflectionLut(const DeflectionLut&) = delete;
+    DeflectionLut& operator=(const DeflectionLut&) = delete;
+
+    // Records the layout transition on first use and a rebake when cameraRadius
+    // differs from the baked one. Call before the trace dispatch, on the trace queue.
+    void record(VkCommandBuffer cmd, float cameraRadius);
+
+    // Rebuilds the bake for other step/glow constants and forces a rebake. The caller
+    // guarantees no submitted frame still uses the bake pipeline.
+    void setGeodesic(const GeodesicSpecConstants& geodesic);
+
+    bool                  isEnabled()    const { return enabled; }
+    VkDescriptorSetLayout getSetLayout() const { return setLayout; }
+    VkDescriptorSet       getSet()       const { return set; }
+
+    // Must match LUT_L_SAMPLES / LUT_PHI_SAMPLES in geodesic.glsl
+    static constexpr uint32_t kImpactSamples = 1024;
+    static constexpr uint32_t kPhiSamples    = 512;
+
+private:
+    struct Image {
+        VkImage         image  = VK_NULL_HANDLE;
+        GpuAllocation   memory;
+        VkImageView     view   = VK_NULL_HANDLE;
+    };
+
+    void createImage(Image& img, uint32_t width, uint32_t height, VkFormat format);
+    void createDescriptors();
+
+    VulkanContext&         ctx;
+    VkDevice               device     = VK_NULL_HANDLE;
+    bool                   enabled    = false;
+
+    Image                  path;      // r32f, kImpactSamples x kPhiSamples
+    Image                  summary;   // rgba32f, kImpactSamples x 2
+
+    VkDescriptorSetLayout  setLayout  = VK_NULL_HANDLE;   // binding 0: path, 1: summary
+    VkDescriptorPool       pool       = VK_NULL_HANDLE;
+    VkDescriptorSet        set        = VK_NULL_HANDLE;
+    std::unique_ptr<ComputePass> bakePass;
+
+    bool                   initialized = false;           // images transitioned to GENERAL
+    float                  bakedRadius = -1.0f;
+};
@@ -0,0 +1,195 @@
+#include "disk_textures.h"
+#include "vulkan_context.h"
+#include "compute_pass.h"
+
+#include <stdexcept>
+#include <iostream>
+#include <vector>
+
+namespace {
+    // Storage and linear filtering are both mandatory for this format
+    constexpr VkFormat kFormat = VK_FORMAT_R16G16B16A16_SFLOAT;
+}
+
+DiskTextures::DiskTextures(VulkanContext& context, const std::string& shaderDir, bool enable)
+    : ctx(context), device(context.getDevice()), enabled(enable) {
+
+    createImage(noise,    enabled ? kNoiseWidth : 1u,      enabled ? kNoiseHeight : 1u);
+    createImage(emission, enabled ? kEmissionSamples : 1u, 1u);
+    createSampler();
+    createDescriptors();
+
+    if (enabled) {
+        bakePass = std::make_unique<ComputePass>(ctx, MappedFile(shaderDir + "/disk_bake.comp.spv"),
+            std::vector<VkDescriptorSetLayout>{ bakeLayout }, 0u);
+        std::cout << "[Disk] Baked disk textures enabled (" << kNoiseWidth << " x " << kNoiseHeight
+                  << " turbulence, " << kEmissionSamples << " emission samples).\n";
+    }
+}
+
+DiskTextures::~DiskTextures() {
+    // Caller guarantees the GPU is idle (ComputePipeline drains the scheduler first)
+    bakePass.reset();
+    if (pool)       vkDestroyDescriptorPool(device, pool, nullptr);
+    if (bakeLayout) vkDestroyDescriptorSetLayout(device, bakeLayout, nullptr);
+    if (setLayout)  vkDestroyDescriptorSetLayout(device, setLayout, nullptr);
+    if (sampler)    vkDestroySampler(device, sampler, nullptr);
+    for (Image* img : { &noise, &emission }) {
+        if (img->view)   vkDestroyImageView(device, img->view, nullptr);
+        if (img->image)  vkDestroyImage(device, img->image, nullptr);
+        ctx.getMemory().free(img->memory);
+    }
+}
+
+void DiskTextures::createImage(Image& img, uint32_t width, uint32_t height) {
+    VkImageCreateInfo ici{};
+    ici.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    ici.imageType = VK_IMAGE_TYPE_2D;
+    ici.format = kFormat;
+    ici.extent = { width, height, 1 };
+    ici.mipLevels = 1;
+    ici.arrayLayers = 1;
+    ici.samples = VK_SAMPLE_COUNT_1_BIT;
+    ici.tiling = VK_IMAGE_TILING_OPTIMAL;
+    ici.usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_STORAGE_BIT;
+    ici.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    ici.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+    if (vkCreateImage(device, &ici, nullptr, &img.image) != VK_SUCCESS) {
+        throw std::runtime_error("[Disk] Failed to create texture image.");
+    }
+
+    img.memory = ctx.getMemory().bind(img.image, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+    VkImageViewCreateInfo vci{};
+    vci.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    vci.image = img.image;
+    vci.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    vci.format = kFormat;
+    vci.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+
+    if (vkCreateImageView(device, &vci, nullptr, &img.view) != VK_SUCCESS) {
+        throw std::runtime_error("[Disk] Failed to create texture view.");
+    }
+}
+
+void DiskTextures::createSampler() {
+    // u: angle / radius, clamped; v: the noise's radius coordinate, which tiles
+    VkSamplerCreateInfo sci{ VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO };
+    sci.magFilter = VK_FILTER_LINEAR;
+    sci.minFilter = VK_FILTER_LINEAR;
+    sci.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+    sci.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    sci.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+    sci.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    if (vkCreateSampler(device, &sci, nullptr, &sampler) != VK_SUCCESS) {
+        throw std::runtime_error("[Disk] Failed to create sampler.");
+    }
+}
+
+void DiskTextures::createDescriptors() {
+    VkDescriptorSetLayoutBinding sampled[2]{};
+    VkDescriptorSetLayoutBinding storage[2]{};
+    for (uint32_t i = 0; i < 2; ++i) {
+        sampled[i].binding = i;
+        sampled[i].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        sampled[i].descriptorCount = 1;
+        sampled[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+        storage[i] = sampled[i];
+        storage[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+    }
+
+    VkDescriptorSetLayoutCreateInfo lci{};
+    lci.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    lci.bindingCount = 2;
+    lci.pBindings = sampled;
+    if (vkCreateDescriptorSetLayout(device, &lci, nullptr, &setLayout) != VK_SUCCESS) {
+        throw std::runtime_error("[Disk] Failed to create descriptor set layout.");
+    }
+    lci.pBindings = storage;
+    if (vkCreateDescriptorSetLayout(device, &lci, nullptr, &bakeLayout) != VK_SUCCESS) {
+        throw std::runtime_error("[Disk] Failed to create bake descriptor set layout.");
+    }
+
+    VkDescriptorPoolSize poolSizes[2] = {
+        { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 2 },
+        { VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 2 },
+    };
+    VkDescriptorPoolCreateInfo pci{};
+    pci.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    pci.maxSets = 2;
+    pci.poolSizeCount = 2;
+    pci.pPoolSizes = poolSizes;
+    if (vkCreateDescriptorPool(device, &pci, nullptr, &pool) != VK_SUCCESS) {
+        throw std::runtime_error("[Disk] Failed to create descriptor pool.");
+    }
+
+    VkDescriptorSetLayout layouts[2] = { setLayout, bakeLayout };
+    VkDescriptorSet sets[2]{};
+    VkDescriptorSetAllocateInfo ai{};
+    ai.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    ai.descriptorPool = pool;
+    ai.descriptorSetCount = 2;
+    ai.pSetLayouts = layouts;
+    if (vkAllocateDescriptorSets(device, &ai, sets) != VK_SUCCESS) {
+        throw std::runtime_error("[Disk] Failed to allocate descriptor sets.");
+    }
+    set = sets[0];
+    bakeSet = sets[1];
+
+    VkDescriptorImageInfo infos[4]{};
+    infos[0] = { sampler,        noise.view,    VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
+    infos[1] = { sampler,        emission.view, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
+    infos[2] = { VK_NULL_HANDLE, noise.view,    VK_IMAGE_LAYOUT_GENERAL };
+    infos[3] = { VK_NULL_HANDLE, emission.view, VK_IMAGE_LAYOUT_GENERAL };
+
+    VkWriteDescriptorSet writes[4]{};
+    for (uint32_t i = 0; i < 4; ++i) {
+        writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        writes[i].dstSet = i < 2 ? set : bakeSet;
+        writes[i].dstBinding = i % 2;
+        writes[i].descriptorType = i < 2 ? VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER : VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+        writes[i].descriptorCount = 1;
+        writes[i].pImageInfo = &infos[i];
+    }
+    vkUpdateDescriptorSets(device, 4, writes, 0, nullptr);
+}
+
+void DiskTextures::record(VkCommandBuffer cmd) {
+    if (initialized) return;
+
+    VkImageMemoryBarrier2 barriers[2]{};
+    VkImage images[2] = { noise.image, emission.image };
+    for (uint32_t i = 0; i < 2; ++i) {
+        barriers[i].sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2;
+        barriers[i].srcStageMask = VK_PIPELINE_STAGE_2_NONE;
+        barriers[i].dstStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+        barriers[i].dstAccessMask = enabled ? VK_ACCESS_2_SHADER_WRITE_BIT : VK_ACCESS_2_NONE;
+        barriers[i].oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        barriers[i].newLayout = enabled ? VK_IMAGE_LAYOUT_GENERAL : VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        barriers[i].srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barriers[i].dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barriers[i].image = images[i];
+        barriers[i].subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+    }
+
+    VkDependencyInfo dep{ VK_STRUCTURE_TYPE_DEPENDENCY_INFO };
+    dep.imageMemoryBarrierCount = 2;
+    dep.pImageMemoryBarriers = barriers;
+    vkCmdPipelineBarrier2(cmd, &dep);
+
+    if (enabled) {
+        bakePass->bind(cmd, &bakeSet, 1);
+        vkCmdDispatch(cmd, kEmissionSamples / 8, kNoiseHeight / 8, 2);
+
+        for (VkImageMemoryBarrier2& b : barriers) {
+            b.srcStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+            b.srcAccessMask = VK_ACCESS_2_SHADER_WRITE_BIT;
+            b.dstAccessMask = VK_ACCESS_2_SHADER_SAMPLED_READ_BIT;
+            b.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+            b.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        }
+        vkCmdPipelineBarrier2(cmd, &dep);
+    }
+    initialized = true;
+}
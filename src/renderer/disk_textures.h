@@ -0,0 +1,73 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "gpu_memory.h"
+
+class VulkanContext;
+class ComputePass;
+
+/**
+ * DiskTextures
+ * ============
+ * Pre-baked accretion disk shading for raymarchDisk (DISK_TEXTURES): a turbulence
+ * texture that tiles along the radius, so the disk's time scroll is a coordinate offset,
+ * and a radial emission table (gravitational redshift and edge fade). Each raymarch step
+ * then does two filtered fetches instead of four hashes per octave, a sqrt and the fades.
+ *
+ * disk_bake.comp fills both in one dispatch on the trace queue, inline with the first
+ * frame; they never change afterwards. Sizes must match disk_profile.glsl. The set
+ * layout is always part of the trace pipeline layout; when disabled the images are 1x1
+ * placeholders that the shader never reads.
+ */
+class DiskTextures {
+public:
+    DiskTextures(VulkanContext& context, const std::string& shaderDir, bool enabled);
+    ~DiskTextures();
+
+    DiskTextures(const DiskTextures&) = delete;
+    DiskTextures& operator=(const DiskTextures&) = delete;
+
+    // Records the bake (or the placeholders' layout transition) on first use and nothing
+    // afterwards. Call before the trace dispatch, on the trace queue.
+    void record(VkCommandBuffer cmd);
+
+    bool                  isEnabled()    const { return enabled; }
+    VkDescriptorSetLayout getSetLayout() const { return setLayout; }
+    VkDescriptorSet       getSet()       const { return set; }
+
+    // DISK_NOISE_CELLS * DISK_NOISE_TEXELS_PER_CELL and DISK_EMISSION_SAMPLES
+    static constexpr uint32_t kNoiseWidth      = 4 * 16;
+    static constexpr uint32_t kNoiseHeight     = 64 * 16;
+    static constexpr uint32_t kEmissionSamples = 512;
+
+private:
+    struct Image {
+        VkImage         image  = VK_NULL_HANDLE;
+        GpuAllocation   memory;
+        VkImageView     view   = VK_NULL_HANDLE;
+    };
+
+    void createImage(Image& img, uint32_t width, uint32_t height);
+    void createSampler();
+    void createDescriptors();
+
+    VulkanContext&         ctx;
+    VkDevice               device     = VK_NULL_HANDLE;
+    bool                   enabled    = false;
+
+    Image                  noise;     // rgba16f (r used), kNoiseWidth x kNoiseHeight
+    Image                  emission;  // rgba16f, kEmissionSamples x 1
+    VkSampler              sampler    = VK_NULL_HANDLE;   // linear; clamped u, repeating v
+
+    VkDescriptorSetLayout  setLayout  = VK_NULL_HANDLE;   // binding 0: noise, 1: emission (sampled)
+    VkDescriptorSetLayout  bakeLayout = VK_NULL_HANDLE;   // the same as storage images
+    VkDescriptorPool       pool       = VK_NULL_HANDLE;
+    VkDescriptorSet        set        = VK_NULL_HANDLE;
+    VkDescriptorSet        bakeSet    = VK_NULL_HANDLE;
+    std::unique_ptr<ComputePass> bakePass;
+
+    bool                   initialized = false;           // baked and in SHADER_READ_ONLY_OPTIMAL
+};
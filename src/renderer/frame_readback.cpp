@@ -0,0 +1,229 @@
+#include "frame_readback.h"
+#include "vulkan_context.h"
+#include "offscreen_target.h"
+#include "../core/image_io.h"
+
+#include <stdexcept>
+#include <iostream>
+#include <filesystem>
+#include <cstdio>
+#include <memory>
+
+FrameReadback::Sink FrameReadback::ppmSequence(VkExtent2D extent, const std::string& outputDir,
+                                               const std::string& prefix) {
+    std::error_code ec;
+    std::filesystem::create_directories(outputDir, ec);
+    if (ec) throw std::runtime_error("[Readback] Failed to create output directory: " + outputDir);
+
+    // Scratch RGB row storage lives in the sink; sinks are only called from the writer thread
+    auto rgb = std::make_shared<std::vector<uint8_t>>();
+    return [extent, outputDir, prefix, rgb](const uint8_t* rgba, uint32_t frameIndex) {
+        const size_t pixels = static_cast<size_t>(extent.width) * extent.height;
+        rgb->resize(pixels * 3);
+        image_io::rgbaToRgb(rgba, rgb->data(), pixels);
+
+        char name[32];
+        std::snprintf(name, sizeof(name), "_%06u.ppm", frameIndex);
+        image_io::writePpm((std::filesystem::path(outputDir) / (prefix + name)).string(),
+                           rgb->data(), extent.width, extent.height);
+    };
+}
+
+FrameReadback::FrameReadback(VulkanContext& context, FrameScheduler& frameScheduler, VkExtent2D size,
+                             uint32_t ringSize, const std::string& outputDir, const std::string& prefix)
+    : FrameReadback(context, frameScheduler, size, ringSize, ppmSequence(size, outputDir, prefix)) {
+    std::cout << "[Readback] Writing " << prefix << "_NNNNNN.ppm to " << outputDir << "\n";
+}
+
+FrameReadback::FrameReadback(VulkanContext& context, FrameScheduler& frameScheduler, VkExtent2D size,
+                             uint32_t ringSize, Sink frameSink)
+    : ctx(context), scheduler(frameScheduler), device(context.getDevice()), extent(size),
+      sink(std::move(frameSink)) {
+
+    if (ringSize == 0) throw std::runtime_error("[Readback] Ring needs at least one buffer.");
+    if (!sink) throw std::runtime_error("[Readback] Readback needs a sink.");
+    frameBytes = static_cast<VkDeviceSize>(extent.width) * extent.height * OffscreenTarget::kBytesPerPixel;
+
+    slots.resize(ringSize);
+
+    std::vector<VkCommandBuffer> cmds(ringSize);
+    VkCommandBufferAllocateInfo ai{ VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO };
+    ai.commandPool = ctx.getGraphicsCommandPool();
+    ai.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    ai.commandBufferCount = ringSize;
+    if (vkAllocateCommandBuffers(device, &ai, cmds.data()) != VK_SUCCESS) {
+        throw std::runtime_error("[Readback] Failed to allocate copy command buffers.");
+    }
+
+    for (uint32_t i = 0; i < ringSize; ++i) {
+        Slot& s = slots[i];
+        s.cmd = cmds[i];
+
+        VkBufferCreateInfo bci{ VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO };
+        bci.size = frameBytes;
+        bci.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+        bci.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        if (vkCreateBuffer(device, &bci, nullptr, &s.buffer) != VK_SUCCESS) {
+            throw std::runtime_error("[Readback] Failed to create readback buffer.");
+        }
+
+        // Cached memory makes the CPU-side reads fast; coherent is the universal fallback.
+        // GpuMemory maps host-visible blocks once, so the slot just keeps the pointer.
+        s.memory = ctx.getMemory().bind(s.buffer,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_CACHED_BIT);
+        if (!(s.memory.flags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT)) coherent = false;
+        s.mapped = static_cast<const uint8_t*>(s.memory.mapped);
+
+        freeSlots.push_back(i);
+    }
+
+    writer = std::thread(&FrameReadback::writerLoop, this);
+
+    std::cout << "[Readback] " << ringSize << " readback buffers ("
+              << (frameBytes / (1024 * 1024)) << " MiB each" << (coherent ? "" : ", cached") << ").\n";
+}
+
+FrameReadback::~FrameReadback() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    cv.notify_all();
+    if (writer.joinable()) writer.join();
+
+    // Every job was waited on by the writer, so the copies are done
+    for (auto& s : slots) {
+        ctx.getMemory().free(s.memory);
+        if (s.buffer) vkDestroyBuffer(device, s.buffer, nullptr);
+    }
+    // Command buffers are freed with their pool in VulkanContext
+}
+
+void FrameReadback::rethrowWriterError() {
+    if (!writerError.empty()) throw std::runtime_error(writerError);
+}
+
+void FrameReadback::capture(VkImage image, VkSemaphore waitSemaphore, uint32_t frameIndex) {
+    uint32_t index = 0;
+    {
+        // Backpressure from the disk, not the GPU: only wait when every buffer is still queued
+        std::unique_lock<std::mutex> lock(mutex);
+        cv.wait(lock, [this] { return !freeSlots.empty() || !writerError.empty(); });
+        rethrowWriterError();
+        index = freeSlots.back();
+        freeSlots.pop_back();
+    }
+    Slot& slot = slots[index];
+
+    VkCommandBufferBeginInfo bi{ VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
+    bi.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    vkResetCommandBuffer(slot.cmd, 0);
+    vkBeginCommandBuffer(slot.cmd, &bi);
+
+    VkBufferImageCopy region{};
+    region.bufferOffset = 0;
+    region.bufferRowLength = 0;     // tightly packed
+    region.bufferImageHeight = 0;
+    region.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+    region.imageOffset = { 0, 0, 0 };
+    region.imageExtent = { extent.width, extent.height, 1 };
+    vkCmdCopyImageToBuffer(slot.cmd, image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, slot.buffer, 1, &region);
+
+    // Make the copy visible to host reads once the writer has waited on the timeline
+    VkMemoryBarrier2 toHost{ VK_STRUCTURE_TYPE_MEMORY_BARRIER_2 };
+    toHost.srcStageMask = VK_PIPELINE_STAGE_2_COPY_BIT;
+    toHost.srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+    toHost.dstStageMask = VK_PIPELINE_STAGE_2_HOST_BIT;
+    toHost.dstAccessMask = VK_ACCESS_2_HOST_READ_BIT;
+
+    VkDependencyInfo dep{ VK_STRUCTURE_TYPE_DEPENDENCY_INFO };
+    dep.memoryBarrierCount = 1;
+    dep.pMemoryBarriers = &toHost;
+    vkCmdPipelineBarrier2(slot.cmd, &dep);
+    vkEndCommandBuffer(slot.cmd);
+
+    VkCommandBufferSubmitInfo cbInfo{ VK_STRUCTURE_TYPE_COMMAND_BUFFER_SUBMIT_INFO };
+    cbInfo.commandBuffer = slot.cmd;
+
+    VkSemaphoreSubmitInfo waitTrace{ VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO };
+    waitTrace.semaphore = waitSemaphore;
+    waitTrace.stageMask = VK_PIPELINE_STAGE_2_COPY_BIT;
+
+    // Ties the copy to the current frame slot: the target image is reused only after it
+    const TimelinePoint copyDone = scheduler.signal(FrameScheduler::Queue::Graphics);
+
+    VkSemaphoreSubmitInfo signalDone{ VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO };
+    signalDone.semaphore = copyDone.semaphore;
+    signalDone.value = copyDone.value;
+    signalDone.stageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+
+    VkSubmitInfo2 submit{ VK_STRUCTURE_TYPE_SUBMIT_INFO_2 };
+    if (waitSemaphore != VK_NULL_HANDLE) {
+        submit.waitSemaphoreInfoCount = 1;
+        submit.pWaitSemaphoreInfos = &waitTrace;
+    }
+    submit.commandBufferInfoCount = 1;
+    submit.pCommandBufferInfos = &cbInfo;
+    submit.signalSemaphoreInfoCount = 1;
+    submit.pSignalSemaphoreInfos = &signalDone;
+
+    if (vkQueueSubmit2(ctx.getGraphicsQueue(), 1, &submit, VK_NULL_HANDLE) != VK_SUCCESS) {
+        throw std::runtime_error("[Readback] Failed to submit readback copy.");
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        jobs.push_back(Job{ index, copyDone, frameIndex });
+    }
+    cv.notify_all();
+}
+
+void FrameReadback::flush() {
+    std::unique_lock<std::mutex> lock(mutex);
+    cv.wait(lock, [this] {
+        return (jobs.empty() && freeSlots.size() == slots.size()) || !writerError.empty();
+    });
+    rethrowWriterError();
+}
+
+uint32_t FrameReadback::getFramesWritten() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return framesWritten;
+}
+
+void FrameReadback::writerLoop() {
+    for (;;) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            cv.wait(lock, [this] { return stopping || !jobs.empty(); });
+            if (jobs.empty()) return;   // stopping and drained
+            job = jobs.front();
+            jobs.pop_front();
+        }
+
+        bool ok = true;
+        try {
+            scheduler.wait(job.copyDone);
+            deliver(slots[job.slot], job.frameIndex);
+        } catch (const std::exception& e) {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (writerError.empty()) writerError = e.what();
+            ok = false;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            freeSlots.push_back(job.slot);
+            if (ok) ++framesWritten;
+        }
+        cv.notify_all();
+    }
+}
+
+void FrameReadback::deliver(const Slot& slot, uint32_t frameIndex) const {
+    // No-op on coherent memory
+    ctx.getMemory().invalidate(slot.memory);
+    sink(slot.mapped, frameIndex);
+}
@@ -0,0 +1,94 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "frame_scheduler.h"
+#include "gpu_memory.h"
+
+class VulkanContext;
+
+/**
+ * FrameReadback
+ * =============
+ * Streams finished frames to disk through a ring of persistently mapped host-visible
+ * buffers. capture() records an image -> buffer copy on the graphics queue and returns;
+ * a writer thread waits for the copy's timeline value and hands the RGBA8 bytes to a
+ * sink: by default one <outputDir>/<prefix>_NNNNNN.ppm per frame (ppmSequence), or e.g.
+ * the tiled renderer's stitcher. Sinks run on the writer thread, one call at a time.
+ *
+ * The copy signals the scheduler's graphics timeline in the current frame slot, so the
+ * target image is not traced into again before it has been copied. The GPU never waits
+ * on the disk: capture() blocks only when all ring buffers are still queued for writing.
+ */
+class FrameReadback {
+public:
+    // Tightly packed extent.width * extent.height RGBA8 pixels; valid only during the call
+    using Sink = std::function<void(const uint8_t* rgba, uint32_t frameIndex)>;
+
+    FrameReadback(VulkanContext& context, FrameScheduler& scheduler, VkExtent2D extent,
+                  uint32_t ringSize, Sink sink);
+    FrameReadback(VulkanContext& context, FrameScheduler& scheduler, VkExtent2D extent,
+                  uint32_t ringSize, const std::string& outputDir, const std::string& prefix = "frame");
+    ~FrameReadback();   // finishes queued writes
+
+    FrameReadback(const FrameReadback&) = delete;
+    FrameReadback& operator=(const FrameReadback&) = delete;
+
+    // image must be RGBA8 in TRANSFER_SRC_OPTIMAL once waitSemaphore (binary, may be null) signals.
+    // Call between FrameScheduler::beginFrame() and endFrame(). Rethrows writer errors.
+    void capture(VkImage image, VkSemaphore waitSemaphore, uint32_t frameIndex);
+
+    // Blocks until every captured frame is on disk. Rethrows writer errors.
+    void flush();
+
+    uint32_t getFramesWritten() const;
+
+    // Default sink: <outputDir>/<prefix>_NNNNNN.ppm per frame index
+    static Sink ppmSequence(VkExtent2D extent, const std::string& outputDir, const std::string& prefix);
+
+private:
+    struct Slot {
+        VkBuffer        buffer = VK_NULL_HANDLE;
+        GpuAllocation   memory;
+        const uint8_t*  mapped = nullptr;                // memory.mapped
+        VkCommandBuffer cmd    = VK_NULL_HANDLE;   // from the graphics pool
+    };
+
+    struct Job {
+        uint32_t      slot       = 0;
+        TimelinePoint copyDone{};
+        uint32_t      frameIndex = 0;
+    };
+
+    void writerLoop();
+    void deliver(const Slot& slot, uint32_t frameIndex) const;
+    void rethrowWriterError();   // caller holds mutex
+
+    VulkanContext&  ctx;
+    FrameScheduler& scheduler;
+    VkDevice        device = VK_NULL_HANDLE;
+    VkExtent2D      extent{0, 0};
+    VkDeviceSize    frameBytes = 0;
+    bool            coherent   = true;   // else invalidate before reading
+    Sink            sink;
+
+    std::vector<Slot>        slots;
+
+    // Shared with the writer thread
+    mutable std::mutex       mutex;
+    std::condition_variable  cv;
+    std::vector<uint32_t>    freeSlots;
+    std::deque<Job>          jobs;
+    uint32_t                 framesWritten = 0;
+    bool                     stopping      = false;
+    std::string              writerError;   // first failure; stops capture
+
+    std::thread              writer;
+};
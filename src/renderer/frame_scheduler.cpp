@@ -0,0 +1,136 @@
+#include "frame_scheduler.h"
+#include "vulkan_context.h"
+
+#include <stdexcept>
+#include <iostream>
+#include <limits>
+#include <cstddef>
+
+FrameScheduler::FrameScheduler(VulkanContext& context, uint32_t framesInFlight)
+    : device(context.getDevice()) {
+
+    if (framesInFlight == 0) throw std::runtime_error("[Scheduler] framesInFlight must be at least 1.");
+    slots.resize(framesInFlight);
+
+    VkSemaphoreTypeCreateInfo tci{ VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO };
+    tci.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+    tci.initialValue = 0;
+
+    VkSemaphoreCreateInfo sci{ VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO };
+    sci.pNext = &tci;
+
+    for (auto& sem : timelines) {
+        if (vkCreateSemaphore(device, &sci, nullptr, &sem) != VK_SUCCESS) {
+            throw std::runtime_error("[Scheduler] Failed to create timeline semaphore.");
+        }
+    }
+
+    std::cout << "[Scheduler] Timeline scheduler ready (" << framesInFlight << " frames in flight).\n";
+}
+
+FrameScheduler::~FrameScheduler() {
+    waitIdle();
+    // The owner idles the device before teardown, presents included
+    while (!deferred.empty()) {
+        auto fn = std::move(deferred.front().fn);
+        deferred.pop_front();
+        fn();
+    }
+    for (auto& sem : timelines) {
+        if (sem) { vkDestroySemaphore(device, sem, nullptr); sem = VK_NULL_HANDLE; }
+    }
+}
+
+uint32_t FrameScheduler::beginFrame() {
+    waitAll(slots[currentSlot]);
+    collect();
+    return currentSlot;
+}
+
+void FrameScheduler::endFrame() {
+    currentSlot = (currentSlot + 1) % static_cast<uint32_t>(slots.size());
+    ++frameNumber;
+}
+
+TimelinePoint FrameScheduler::signal(Queue queue) {
+    const size_t q = static_cast<size_t>(queue);
+    const uint64_t value = ++lastIssued[q];
+    slots[currentSlot][q] = value;
+    return TimelinePoint{ timelines[q], value };
+}
+
+bool FrameScheduler::isComplete(const TimelinePoint& point) const {
+    if (point.semaphore == VK_NULL_HANDLE || point.value == 0) return true;
+    uint64_t current = 0;
+    vkGetSemaphoreCounterValue(device, point.semaphore, &current);
+    return current >= point.value;
+}
+
+void FrameScheduler::wait(const TimelinePoint& point) const {
+    if (point.semaphore == VK_NULL_HANDLE || point.value == 0) return;
+
+    VkSemaphoreWaitInfo wi{ VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO };
+    wi.semaphoreCount = 1;
+    wi.pSemaphores = &point.semaphore;
+    wi.pValues = &point.value;
+
+    if (vkWaitSemaphores(device, &wi, std::numeric_limits<uint64_t>::max()) != VK_SUCCESS) {
+        throw std::runtime_error("[Scheduler] Failed waiting on timeline semaphore.");
+    }
+}
+
+uint64_t FrameScheduler::completedValue(Queue queue) const {
+    uint64_t current = 0;
+    vkGetSemaphoreCounterValue(device, timelines[static_cast<size_t>(queue)], &current);
+    return current;
+}
+
+void FrameScheduler::deferDestroy(std::function<void()> fn, uint32_t frameDelay) {
+    deferred.push_back(Deferred{ lastIssued, frameNumber + frameDelay, std::move(fn) });
+}
+
+void FrameScheduler::collect() {
+    // Issue values only grow along the queue, so the first entry not passed ends the scan;
+    // frame-delayed entries that aren't due yet are stepped over. Indices, not iterators:
+    // fn may defer more work.
+    for (size_t i = 0; i < deferred.size() && passed(deferred[i].values);) {
+        if (frameNumber < deferred[i].frame) { ++i; continue; }
+        auto fn = std::move(deferred[i].fn);
+        deferred.erase(deferred.begin() + static_cast<std::ptrdiff_t>(i));
+        fn();
+    }
+}
+
+void FrameScheduler::waitIdle() {
+    waitAll(lastIssued);
+    collect();
+}
+
+bool FrameScheduler::passed(const QueueValues& values) const {
+    for (size_t q = 0; q < kQueueCount; ++q) {
+        if (!isComplete(TimelinePoint{ timelines[q], values[q] })) return false;
+    }
+    return true;
+}
+
+void FrameScheduler::waitAll(const QueueValues& values) const {
+    std::array<VkSemaphore, kQueueCount> sems{};
+    std::array<uint64_t, kQueueCount>    vals{};
+    uint32_t count = 0;
+    for (size_t q = 0; q < kQueueCount; ++q) {
+        if (values[q] == 0) continue;
+        sems[count] = timelines[q];
+        vals[count] = values[q];
+        ++count;
+    }
+    if (count == 0) return;
+
+    VkSemaphoreWaitInfo wi{ VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO };
+    wi.semaphoreCount = count;
+    wi.pSemaphores = sems.data();
+    wi.pValues = vals.data();
+
+    if (vkWaitSemaphores(device, &wi, std::numeric_limits<uint64_t>::max()) != VK_SUCCESS) {
+        throw std::runtime_error("[Scheduler] Failed waiting on frame timeline values.");
+    }
+}
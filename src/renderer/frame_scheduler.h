@@ -0,0 +1,93 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <array>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <vector>
+
+class VulkanContext;
+
+// A point on a queue's timeline: "the GPU has passed `value` on `semaphore`".
+struct TimelinePoint {
+    VkSemaphore semaphore = VK_NULL_HANDLE;
+    uint64_t    value     = 0;
+};
+
+/**
+ * FrameScheduler
+ * ==============
+ * Tracks GPU progress with one Vulkan 1.3 timeline semaphore per queue.
+ * Every submission signals the next value of its queue's counter, so "is this
+ * done yet?" is a counter comparison instead of a fence/queue-idle wait.
+ *
+ * A frame slot is reusable once every value signaled while it was current has
+ * been passed. Resources that outlive a slot (old images, staging memory,
+ * one-shot command buffers) go through deferDestroy() and are released as soon
+ * as the GPU passes everything that was submitted before them.
+ */
+class FrameScheduler {
+public:
+    enum class Queue : uint32_t { Compute = 0, Graphics = 1, Count = 2 };
+
+    FrameScheduler(VulkanContext& context, uint32_t framesInFlight);
+    ~FrameScheduler();
+
+    FrameScheduler(const FrameScheduler&) = delete;
+    FrameScheduler& operator=(const FrameScheduler&) = delete;
+
+    // Blocks until the slot's previous frame retired and runs due deferred work.
+    // Returns the slot index used to pick per-frame resources.
+    uint32_t beginFrame();
+    // Advances to the next slot; call after the frame's last submission.
+    void     endFrame();
+
+    // Reserves the next value on the queue's timeline and ties it to the current
+    // frame slot. The caller must signal the returned point in a submit.
+    TimelinePoint signal(Queue queue);
+
+    // Host-side queries. Neither touches the queues.
+    bool     isComplete(const TimelinePoint& point) const;
+    void     wait(const TimelinePoint& point) const;
+    uint64_t completedValue(Queue queue) const;
+
+    // Runs fn once the GPU has passed everything signaled so far and, with frameDelay,
+    // that many more frames have begun. The delay covers work the timelines don't see:
+    // presents of an old swapchain's images complete after their frame's last signal.
+    void deferDestroy(std::function<void()> fn, uint32_t frameDelay = 0);
+    // Runs every deferred destructor whose timeline points (and frame delay) have passed.
+    void collect();
+
+    // Waits for every value issued so far (shutdown/teardown only). Frame-delayed
+    // destructors still wait for their frames; the destructor runs them regardless.
+    void waitIdle();
+
+    uint32_t getFramesInFlight() const { return static_cast<uint32_t>(slots.size()); }
+    uint32_t getFrameSlot()      const { return currentSlot; }
+    uint64_t getFrameNumber()    const { return frameNumber; }
+
+private:
+    static constexpr size_t kQueueCount = static_cast<size_t>(Queue::Count);
+    using QueueValues = std::array<uint64_t, kQueueCount>;
+
+    struct Deferred {
+        QueueValues           values{};
+        uint64_t              frame = 0;   // frameNumber it may run at
+        std::function<void()> fn;
+    };
+
+    bool passed(const QueueValues& values) const;
+    void waitAll(const QueueValues& values) const;
+
+    VkDevice       device = VK_NULL_HANDLE;
+
+    std::array<VkSemaphore, kQueueCount> timelines{};
+    QueueValues                          lastIssued{};   // highest value handed out per queue
+
+    std::vector<QueueValues>             slots;          // last value signaled per queue, per slot
+    uint32_t                             currentSlot = 0;
+    uint64_t                             frameNumber = 0;
+
+    std::deque<Deferred>                 deferred;       // ordered by issue values
+};
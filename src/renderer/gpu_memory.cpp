@@ -0,0 +1,314 @@
+#include "gpu_memory.h"
+
+#include <stdexcept>
+#include <algorithm>
+#include <cstddef>
+#include <cassert>
+
+namespace {
+    VkDeviceSize alignUp(VkDeviceSize value, VkDeviceSize alignment) {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+}
+
+GpuMemory::GpuMemory(VkPhysicalDevice pd, VkDevice dev) : physicalDevice(pd), device(dev) {
+    vkGetPhysicalDeviceMemoryProperties(physicalDevice, &properties);
+
+    VkPhysicalDeviceProperties props{};
+    vkGetPhysicalDeviceProperties(physicalDevice, &props);
+    granularity = std::max<VkDeviceSize>(props.limits.bufferImageGranularity, 1);
+    atomSize    = std::max<VkDeviceSize>(props.limits.nonCoherentAtomSize, 1);
+}
+
+GpuMemory::~GpuMemory() {
+    for (const auto& block : blocks) vkFreeMemory(device, block->memory, nullptr);
+}
+
+uint32_t GpuMemory::findMemoryType(uint32_t typeBits, VkMemoryPropertyFlags props) const {
+    for (uint32_t i = 0; i < properties.memoryTypeCount; ++i) {
+        if ((typeBits & (1u << i)) && (properties.memoryTypes[i].propertyFlags & props) == props) {
+            return i;
+        }
+    }
+    throw std::runtime_error("[Memory] Suitable memory type not found.");
+}
+
+uint32_t GpuMemory::pickType(uint32_t typeBits, VkMemoryPropertyFlags required, VkMemoryPropertyFlags preferred) const {
+    if (preferred) {
+        for (uint32_t i = 0; i < properties.memoryTypeCount; ++i) {
+            if ((typeBits & (1u << i)) && (properties.memoryTypes[i].propertyFlags & preferred) == preferred) {
+                return i;
+            }
+        }
+    }
+    return findMemoryType(typeBits, required);
+}
+
+VkDeviceSize GpuMemory::blockSize(uint32_t type) const {
+    return (properties.memoryTypes[type].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) ? kHostBlockSize
+                                                                                              : kDeviceBlockSize;
+}
+
+bool GpuMemory::nonCoherent(uint32_t type) const {
+    const VkMemoryPropertyFlags flags = properties.memoryTypes[type].propertyFlags;
+    return (flags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) && !(flags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+}
+
+VkDeviceSize GpuMemory::alignment(uint32_t type, VkDeviceSize required) const {
+    // Neighbours may be linear buffers or optimal images, so every range honours the granularity
+    VkDeviceSize a = std::max({ required, granularity, VkDeviceSize(1) });
+    if (nonCoherent(type)) a = std::max(a, atomSize);
+    return a;
+}
+
+VkDeviceSize GpuMemory::paddedSize(uint32_t type, VkDeviceSize size) const {
+    return nonCoherent(type) ? alignUp(size, atomSize) : size;
+}
+
+GpuAllocation GpuMemory::rangeOf(const Block& block, VkDeviceSize offset, VkDeviceSize size) const {
+    GpuAllocation a;
+    a.memory = block.memory;
+    a.offset = offset;
+    a.size   = size;
+    a.mapped = block.mapped ? static_cast<char*>(block.mapped) + offset : nullptr;
+    a.flags  = properties.memoryTypes[block.type].propertyFlags;
+    return a;
+}
+
+GpuMemory::Block* GpuMemory::createBlock(uint32_t type, VkDeviceSize size) {
+    VkMemoryAllocateInfo mai{ VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO };
+    mai.allocationSize = size;
+    mai.memoryTypeIndex = type;
+
+    auto block = std::make_unique<Block>();
+    if (vkAllocateMemory(device, &mai, nullptr, &block->memory) != VK_SUCCESS) return nullptr;
+    block->size = size;
+    block->type = type;
+    block->free = { { 0, size } };
+
+    if (properties.memoryTypes[type].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
+        if (vkMapMemory(device, block->memory, 0, VK_WHOLE_SIZE, 0, &block->mapped) != VK_SUCCESS) {
+            vkFreeMemory(device, block->memory, nullptr);
+            throw std::runtime_error("[Memory] Failed to map host-visible block.");
+        }
+    }
+    blocks.push_back(std::move(block));
+    return blocks.back().get();
+}
+
+void GpuMemory::releaseBlock(Block* block) {
+    // Freeing the memory also unmaps it
+    vkFreeMemory(device, block->memory, nullptr);
+    blocks.erase(std::find_if(blocks.begin(), blocks.end(), [block](const auto& b) { return b.get() == block; }));
+}
+
+bool GpuMemory::take(std::vector<Range>& free, VkDeviceSize size, VkDeviceSize align, VkDeviceSize& offset) {
+    for (size_t i = 0; i < free.size(); ++i) {
+        const Range r = free[i];
+        const VkDeviceSize start = alignUp(r.offset, align);
+        if (start + size > r.offset + r.size) continue;
+
+        // The alignment gap in front and the tail behind stay free
+        std::vector<Range> split;
+        if (start > r.offset) split.push_back({ r.offset, start - r.offset });
+        if (start + size < r.offset + r.size) split.push_back({ start + size, r.offset + r.size - start - size });
+        const auto at = free.erase(free.begin() + static_cast<std::ptrdiff_t>(i));
+        free.insert(at, split.begin(), split.end());
+        offset = start;
+        return true;
+    }
+    return false;
+}
+
+GpuAllocation GpuMemory::allocate(const VkMemoryRequirements& req, VkMemoryPropertyFlags required,
+                                  VkMemoryPropertyFlags preferred) {
+    const uint32_t     type  = pickType(req.memoryTypeBits, required, preferred);
+    const VkDeviceSize align = alignment(type, req.alignment);
+    const VkDeviceSize size  = paddedSize(type, req.size);
+
+    // Large resources (readback frames, big cubemaps) would mostly waste a shared block
+    if (size > blockSize(type) / 2) {
+        Block* block = createBlock(type, size);
+        if (!block) throw std::runtime_error("[Memory] Out of device memory.");
+        block->dedicated = true;
+        block->free.clear();
+        return rangeOf(*block, 0, size);
+    }
+
+    VkDeviceSize offset = 0;
+    for (const auto& block : blocks) {
+        if (block->type != type || block->dedicated || block->arena) continue;
+        if (take(block->free, size, align, offset)) return rangeOf(*block, offset, size);
+    }
+
+    // A fresh shared block; when that no longer fits the heap, try an exact-size one
+    Block* block = createBlock(type, blockSize(type));
+    if (!block) {
+        block = createBlock(type, size);
+        if (!block) throw std::runtime_error("[Memory] Out of device memory.");
+        block->dedicated = true;
+        block->free.clear();
+        return rangeOf(*block, 0, size);
+    }
+    take(block->free, size, align, offset);
+    return rangeOf(*block, offset, size);
+}
+
+GpuAllocation GpuMemory::bind(VkImage image, VkMemoryPropertyFlags required) {
+    VkMemoryRequirements req{};
+    vkGetImageMemoryRequirements(device, image, &req);
+    GpuAllocation a = allocate(req, required);
+    if (vkBindImageMemory(device, image, a.memory, a.offset) != VK_SUCCESS) {
+        free(a);
+        throw std::runtime_error("[Memory] Failed to bind image memory.");
+    }
+    return a;
+}
+
+GpuAllocation GpuMemory::bind(VkBuffer buffer, VkMemoryPropertyFlags required, VkMemoryPropertyFlags preferred) {
+    VkMemoryRequirements req{};
+    vkGetBufferMemoryRequirements(device, buffer, &req);
+    GpuAllocation a = allocate(req, required, preferred);
+    if (vkBindBufferMemory(device, buffer, a.memory, a.offset) != VK_SUCCESS) {
+        free(a);
+        throw std::runtime_error("[Memory] Failed to bind buffer memory.");
+    }
+    return a;
+}
+
+void GpuMemory::free(GpuAllocation& allocation) {
+    if (!allocation) return;
+    auto it = std::find_if(blocks.begin(), blocks.end(),
+                           [&](const auto& b) { return b->memory == allocation.memory; });
+    assert(it != blocks.end() && "allocation from another GpuMemory");
+    if (it == blocks.end()) return;
+    Block* block = it->get();
+    const Range range{ allocation.offset, allocation.size };
+    allocation = {};
+
+    if (block->dedicated) {
+        releaseBlock(block);
+        return;
+    }
+
+    // Insert in offset order and merge with the neighbours
+    auto& free = block->free;
+    auto pos = std::lower_bound(free.begin(), free.end(), range,
+                                [](const Range& a, const Range& b) { return a.offset < b.offset; });
+    pos = free.insert(pos, range);
+    if (pos + 1 != free.end() && pos->offset + pos->size == (pos + 1)->offset) {
+        pos->size += (pos + 1)->size;
+        free.erase(pos + 1);
+    }
+    if (pos != free.begin() && (pos - 1)->offset + (pos - 1)->size == pos->offset) {
+        (pos - 1)->size += pos->size;
+        free.erase(pos);
+    }
+
+    // Keep one empty shared block per type for the next allocation
+    if (free.size() == 1 && free.front().size == block->size) {
+        const bool another = std::any_of(blocks.begin(), blocks.end(), [&](const auto& b) {
+            return b.get() != block && b->type == block->type && !b->dedicated && !b->arena;
+        });
+        if (another) releaseBlock(block);
+    }
+}
+
+void GpuMemory::flush(const GpuAllocation& allocation) const {
+    if (!allocation.mapped || (allocation.flags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT)) return;
+    VkMappedMemoryRange range{ VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE };
+    range.memory = allocation.memory;
+    range.offset = allocation.offset;
+    range.size = allocation.size;
+    vkFlushMappedMemoryRanges(device, 1, &range);
+}
+
+void GpuMemory::invalidate(const GpuAllocation& allocation) const {
+    if (!allocation.mapped || (allocation.flags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT)) return;
+    VkMappedMemoryRange range{ VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE };
+    range.memory = allocation.memory;
+    range.offset = allocation.offset;
+    range.size = allocation.size;
+    vkInvalidateMappedMemoryRanges(device, 1, &range);
+}
+
+VkDeviceSize GpuMemory::getAllocatedBytes() const {
+    VkDeviceSize total = 0;
+    for (const auto& block : blocks) total += block->size;
+    return total;
+}
+
+// ---------- GpuArena ----------
+
+GpuArena::GpuArena(GpuMemory& gpuMemory) : memory(gpuMemory) {}
+
+GpuArena::~GpuArena() {
+    for (const Cursor& c : blocks) memory.releaseBlock(c.block);
+}
+
+GpuAllocation GpuArena::allocate(const VkMemoryRequirements& req, VkMemoryPropertyFlags required) {
+    const uint32_t     type  = memory.pickType(req.memoryTypeBits, required, 0);
+    const VkDeviceSize align = memory.alignment(type, req.alignment);
+    const VkDeviceSize size  = memory.paddedSize(type, req.size);
+
+    for (Cursor& c : blocks) {
+        if (c.block->type != type) continue;
+        const VkDeviceSize offset = alignUp(c.used, align);
+        if (offset + size <= c.block->size) {
+            c.used = offset + size;
+            return memory.rangeOf(*c.block, offset, size);
+        }
+    }
+
+    const VkDeviceSize want = std::max({ reserve[type], memory.blockSize(type), size });
+    GpuMemory::Block* block = memory.createBlock(type, want);
+    if (!block && want > size) block = memory.createBlock(type, size);
+    if (!block) throw std::runtime_error("[Memory] Out of device memory.");
+    block->arena = true;
+    block->free.clear();
+    blocks.push_back({ block, size });
+    return memory.rangeOf(*block, 0, size);
+}
+
+GpuAllocation GpuArena::bind(VkImage image, VkMemoryPropertyFlags required) {
+    VkMemoryRequirements req{};
+    vkGetImageMemoryRequirements(memory.device, image, &req);
+    const GpuAllocation a = allocate(req, required);
+    if (vkBindImageMemory(memory.device, image, a.memory, a.offset) != VK_SUCCESS) {
+        throw std::runtime_error("[Memory] Failed to bind image memory.");
+    }
+    return a;
+}
+
+GpuAllocation GpuArena::bind(VkBuffer buffer, VkMemoryPropertyFlags required) {
+    VkMemoryRequirements req{};
+    vkGetBufferMemoryRequirements(memory.device, buffer, &req);
+    const GpuAllocation a = allocate(req, required);
+    if (vkBindBufferMemory(memory.device, buffer, a.memory, a.offset) != VK_SUCCESS) {
+        throw std::runtime_error("[Memory] Failed to bind buffer memory.");
+    }
+    return a;
+}
+
+void GpuArena::reset() {
+    // A type that spilled into several blocks is merged into one of the combined size
+    // (rounded to a MiB for alignment slack), allocated by the next set
+    std::array<uint32_t, VK_MAX_MEMORY_TYPES> count{};
+    std::array<VkDeviceSize, VK_MAX_MEMORY_TYPES> used{};
+    for (const Cursor& c : blocks) {
+        ++count[c.block->type];
+        used[c.block->type] += c.used;
+    }
+    std::vector<Cursor> kept;
+    for (Cursor& c : blocks) {
+        const uint32_t type = c.block->type;
+        if (count[type] > 1) {
+            reserve[type] = alignUp(used[type], VkDeviceSize(1) << 20);
+            memory.releaseBlock(c.block);
+        } else {
+            c.used = 0;
+            kept.push_back(c);
+        }
+    }
+    blocks = std::move(kept);
+}
@@ -0,0 +1,138 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// A sub-range of a GpuMemory block; bind resources at memory + offset
+struct GpuAllocation {
+    VkDeviceMemory        memory = VK_NULL_HANDLE;   // the block, shared with other allocations
+    VkDeviceSize          offset = 0;
+    VkDeviceSize          size   = 0;
+    void*                 mapped = nullptr;          // host-visible types: into the block's mapping
+    VkMemoryPropertyFlags flags  = 0;                // of the memory type it came from
+
+    explicit operator bool() const { return memory != VK_NULL_HANDLE; }
+};
+
+/**
+ * GpuMemory
+ * =========
+ * Device-memory sub-allocator owned by VulkanContext. Images and buffers take ranges of
+ * large blocks per memory type instead of a vkAllocateMemory each, which keeps the
+ * renderer far below maxMemoryAllocationCount and out of the driver allocator on resizes.
+ * Requests larger than half a block get a block of their own. The memory properties are
+ * queried once.
+ *
+ * Host-visible blocks are mapped once when allocated (a VkDeviceMemory maps only once),
+ * and their allocations carry a pointer into that mapping. Ranges are aligned to
+ * bufferImageGranularity, so buffers and optimal images share blocks, and host-visible
+ * non-coherent ranges to nonCoherentAtomSize, so flush() and invalidate() stay inside them.
+ *
+ * Not thread-safe: like the context's pools, use it from the thread driving the context.
+ */
+class GpuMemory {
+public:
+    GpuMemory(VkPhysicalDevice physicalDevice, VkDevice device);
+    ~GpuMemory();   // frees every block; resources bound to them must already be destroyed
+
+    GpuMemory(const GpuMemory&) = delete;
+    GpuMemory& operator=(const GpuMemory&) = delete;
+
+    // First type in typeBits with all of props; throws when there is none
+    uint32_t findMemoryType(uint32_t typeBits, VkMemoryPropertyFlags props) const;
+    const VkPhysicalDeviceMemoryProperties& getProperties() const { return properties; }
+
+    // A range of a block of the first type with all of required; when preferred is set,
+    // types with all of preferred are tried first. Throws when the device is out of memory.
+    GpuAllocation allocate(const VkMemoryRequirements& req, VkMemoryPropertyFlags required,
+                           VkMemoryPropertyFlags preferred = 0);
+    // allocate() for the resource's requirements, then bind it
+    GpuAllocation bind(VkImage image, VkMemoryPropertyFlags required);
+    GpuAllocation bind(VkBuffer buffer, VkMemoryPropertyFlags required, VkMemoryPropertyFlags preferred = 0);
+    // Returns the range to its block and clears allocation; null allocations are ignored.
+    // Empty blocks are released, except the last shared block of a memory type.
+    void free(GpuAllocation& allocation);
+
+    // Host-visible non-coherent ranges; no-ops on coherent memory
+    void flush(const GpuAllocation& allocation) const;
+    void invalidate(const GpuAllocation& allocation) const;
+
+    uint32_t     getBlockCount()     const { return static_cast<uint32_t>(blocks.size()); }
+    VkDeviceSize getAllocatedBytes() const;   // in blocks, used or not
+
+    static constexpr VkDeviceSize kDeviceBlockSize = 64ull << 20;
+    static constexpr VkDeviceSize kHostBlockSize   = 16ull << 20;   // host-visible types (often BAR)
+
+private:
+    friend class GpuArena;
+
+    struct Range {
+        VkDeviceSize offset = 0;
+        VkDeviceSize size   = 0;
+    };
+    struct Block {
+        VkDeviceMemory     memory    = VK_NULL_HANDLE;
+        VkDeviceSize       size      = 0;
+        uint32_t           type      = 0;
+        void*              mapped    = nullptr;
+        bool               dedicated = false;   // one resource, released with it
+        bool               arena     = false;   // handed to a GpuArena, not in the free lists
+        std::vector<Range> free;                // sorted by offset, coalesced
+    };
+
+    Block*        createBlock(uint32_t type, VkDeviceSize size);
+    void          releaseBlock(Block* block);
+    uint32_t      pickType(uint32_t typeBits, VkMemoryPropertyFlags required, VkMemoryPropertyFlags preferred) const;
+    VkDeviceSize  blockSize(uint32_t type) const;
+    bool          nonCoherent(uint32_t type) const;     // host-visible without HOST_COHERENT
+    VkDeviceSize  alignment(uint32_t type, VkDeviceSize required) const;
+    VkDeviceSize  paddedSize(uint32_t type, VkDeviceSize size) const;   // non-coherent atoms
+    GpuAllocation rangeOf(const Block& block, VkDeviceSize offset, VkDeviceSize size) const;
+    // First fit of an aligned range in a sorted free list; splits the range it takes
+    static bool   take(std::vector<Range>& free, VkDeviceSize size, VkDeviceSize align, VkDeviceSize& offset);
+
+    VkPhysicalDevice                    physicalDevice = VK_NULL_HANDLE;
+    VkDevice                            device         = VK_NULL_HANDLE;
+    VkPhysicalDeviceMemoryProperties    properties{};
+    VkDeviceSize                        granularity    = 1;   // bufferImageGranularity
+    VkDeviceSize                        atomSize       = 1;   // nonCoherentAtomSize
+    std::vector<std::unique_ptr<Block>> blocks;
+};
+
+/**
+ * GpuArena
+ * ========
+ * Linear allocator over GpuMemory blocks for resources created and destroyed as a set
+ * (ComputePipeline's target-sized images and buffers). Nothing is freed one by one:
+ * reset() rewinds every block at once, so a recreate() reuses the same device memory and
+ * only allocates when the new set outgrows it. A set that needed several blocks of one
+ * type gets a single block of their combined size after the next reset.
+ */
+class GpuArena {
+public:
+    explicit GpuArena(GpuMemory& memory);
+    ~GpuArena();   // returns the blocks to GpuMemory
+
+    GpuArena(const GpuArena&) = delete;
+    GpuArena& operator=(const GpuArena&) = delete;
+
+    GpuAllocation allocate(const VkMemoryRequirements& req, VkMemoryPropertyFlags required);
+    GpuAllocation bind(VkImage image, VkMemoryPropertyFlags required);
+    GpuAllocation bind(VkBuffer buffer, VkMemoryPropertyFlags required);
+
+    // Invalidates every allocation; the resources bound to them must already be destroyed
+    // and no longer in use by the GPU
+    void reset();
+
+private:
+    struct Cursor {
+        GpuMemory::Block* block = nullptr;
+        VkDeviceSize      used  = 0;
+    };
+
+    GpuMemory&                                  memory;
+    std::vector<Cursor>                         blocks;
+    std::array<VkDeviceSize, VK_MAX_MEMORY_TYPES> reserve{};   // block size to start with, per type
+};
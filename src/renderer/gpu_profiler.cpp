@@ -0,0 +1,219 @@
+#include "gpu_profiler.h"
+#include "vulkan_context.h"
+
+#include <stdexcept>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <cmath>
+
+static const char* kStageNames[] = { "trace", "resolve", "barriers", "blit" };
+
+GpuProfiler::GpuProfiler(VulkanContext& context, uint32_t framesInFlight, bool pipelineStatistics,
+                         uint32_t historyLength)
+    : device(context.getDevice()) {
+
+    for (auto& s : series) s.samples.resize(std::max(historyLength, 1u));
+    hostWait.samples.resize(std::max(historyLength, 1u));
+
+    // Timestamps are written on both the compute and graphics queues
+    uint32_t qCount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(context.getPhysicalDevice(), &qCount, nullptr);
+    std::vector<VkQueueFamilyProperties> qProps(qCount);
+    vkGetPhysicalDeviceQueueFamilyProperties(context.getPhysicalDevice(), &qCount, qProps.data());
+
+    const uint32_t validBits = std::min(qProps[context.getComputeQueueFamily()].timestampValidBits,
+                                        qProps[context.getGraphicsQueueFamily()].timestampValidBits);
+    if (validBits == 0) {
+        std::cerr << "[Profiler] Warning: queues have no timestamp support; profiling disabled.\n";
+        return;
+    }
+    if (!context.supportsHostQueryReset()) {
+        std::cerr << "[Profiler] Warning: hostQueryReset not supported; profiling disabled.\n";
+        return;
+    }
+    mask = (validBits >= 64) ? ~0ull : ((1ull << validBits) - 1ull);
+
+    VkPhysicalDeviceProperties props{};
+    vkGetPhysicalDeviceProperties(context.getPhysicalDevice(), &props);
+    periodNs = props.limits.timestampPeriod;
+
+    statisticsEnabled = pipelineStatistics && context.supportsPipelineStatistics();
+    if (pipelineStatistics && !statisticsEnabled) {
+        std::cerr << "[Profiler] Warning: pipelineStatisticsQuery not supported; statistics disabled.\n";
+    }
+
+    slots.resize(framesInFlight);
+    for (auto& slot : slots) {
+        VkQueryPoolCreateInfo qci{ VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO };
+        qci.queryType = VK_QUERY_TYPE_TIMESTAMP;
+        qci.queryCount = kStageCount * 2;
+        if (vkCreateQueryPool(device, &qci, nullptr, &slot.timestamps) != VK_SUCCESS) {
+            throw std::runtime_error("[Profiler] Failed to create timestamp query pool.");
+        }
+        vkResetQueryPool(device, slot.timestamps, 0, qci.queryCount);
+
+        if (statisticsEnabled) {
+            VkQueryPoolCreateInfo sci{ VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO };
+            sci.queryType = VK_QUERY_TYPE_PIPELINE_STATISTICS;
+            sci.queryCount = 1;
+            sci.pipelineStatistics = VK_QUERY_PIPELINE_STATISTIC_COMPUTE_SHADER_INVOCATIONS_BIT;
+            if (vkCreateQueryPool(device, &sci, nullptr, &slot.statistics) != VK_SUCCESS) {
+                throw std::runtime_error("[Profiler] Failed to create pipeline statistics query pool.");
+            }
+            vkResetQueryPool(device, slot.statistics, 0, 1);
+        }
+    }
+
+    available = true;
+}
+
+GpuProfiler::~GpuProfiler() {
+    // Caller guarantees the GPU is idle
+    for (auto& slot : slots) {
+        if (slot.timestamps) vkDestroyQueryPool(device, slot.timestamps, nullptr);
+        if (slot.statistics) vkDestroyQueryPool(device, slot.statistics, nullptr);
+    }
+}
+
+bool GpuProfiler::collect(uint32_t slotIndex) {
+    if (!available) return false;
+    current = slotIndex;
+    Slot& slot = slots[slotIndex];
+
+    bool fresh = false;
+    for (uint32_t s = 0; s < kStageCount; ++s) {
+        if (!(slot.written & (1u << s))) continue;
+
+        // {value, availability} x 2; never waits
+        uint64_t data[4]{};
+        VkResult res = vkGetQueryPoolResults(device, slot.timestamps, s * 2, 2, sizeof(data), data,
+                                             2 * sizeof(uint64_t),
+                                             VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+        if ((res == VK_SUCCESS || res == VK_NOT_READY) && data[1] && data[3]) {
+            const uint64_t ticks = (data[2] - data[0]) & mask;
+            push(series[s], static_cast<float>(static_cast<double>(ticks) * periodNs * 1e-6));
+            fresh = true;
+        }
+    }
+
+    if (slot.statsWritten) {
+        uint64_t data[2]{};
+        VkResult res = vkGetQueryPoolResults(device, slot.statistics, 0, 1, sizeof(data), data,
+                                             sizeof(data),
+                                             VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+        if ((res == VK_SUCCESS || res == VK_NOT_READY) && data[1]) {
+            computeInvocations = data[0];
+        }
+        vkResetQueryPool(device, slot.statistics, 0, 1);
+        slot.statsWritten = false;
+    }
+
+    // The slot retired in FrameScheduler::beginFrame, so resetting from the host is safe
+    vkResetQueryPool(device, slot.timestamps, 0, kStageCount * 2);
+    slot.written = 0;
+    return fresh;
+}
+
+void GpuProfiler::begin(VkCommandBuffer cmd, Stage stage) {
+    if (!available) return;
+    vkCmdWriteTimestamp2(cmd, VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT, slots[current].timestamps, index(stage) * 2);
+}
+
+void GpuProfiler::end(VkCommandBuffer cmd, Stage stage) {
+    if (!available) return;
+    vkCmdWriteTimestamp2(cmd, VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT, slots[current].timestamps, index(stage) * 2 + 1);
+    slots[current].written |= 1u << index(stage);
+}
+
+void GpuProfiler::beginStatistics(VkCommandBuffer cmd) {
+    if (!statisticsEnabled) return;
+    vkCmdBeginQuery(cmd, slots[current].statistics, 0, 0);
+}
+
+void GpuProfiler::endStatistics(VkCommandBuffer cmd) {
+    if (!statisticsEnabled) return;
+    vkCmdEndQuery(cmd, slots[current].statistics, 0);
+    slots[current].statsWritten = true;
+}
+
+void GpuProfiler::addHostWait(float ms) {
+    push(hostWait, ms);
+}
+
+void GpuProfiler::push(Series& s, float ms) {
+    s.samples[s.next] = ms;
+    s.next = (s.next + 1) % s.samples.size();
+    s.count = std::min(s.count + 1, s.samples.size());
+    s.last = ms;
+    ++s.total;
+}
+
+GpuProfiler::Stats GpuProfiler::summarize(const Series& s) {
+    Stats st{};
+    if (s.count == 0) return st;
+
+    std::vector<float> sorted(s.samples.begin(), s.samples.begin() + static_cast<std::ptrdiff_t>(s.count));
+    std::sort(sorted.begin(), sorted.end());
+
+    double sum = 0.0;
+    for (float v : sorted) sum += v;
+
+    const size_t p99 = static_cast<size_t>(std::ceil(0.99 * static_cast<double>(sorted.size()))) - 1;
+    st.minMs = sorted.front();
+    st.avgMs = static_cast<float>(sum / static_cast<double>(sorted.size()));
+    st.p99Ms = sorted[std::min(p99, sorted.size() - 1)];
+    st.samples = static_cast<uint32_t>(sorted.size());
+    return st;
+}
+
+void GpuProfiler::reportRayStats(std::ostream& out) const {
+    const RayStats& r = rayStats;
+    if (r.samples == 0) return;
+    const double n = static_cast<double>(r.samples);
+
+    // Percentiles to the upper edge of the histogram bin that reaches them
+    auto percentile = [&r, n](double p) {
+        uint64_t seen = 0;
+        for (size_t b = 0; b < r.stepHistogram.size(); ++b) {
+            seen += r.stepHistogram[b];
+            if (seen >= p * n) return static_cast<uint64_t>(b + 1) * r.binWidth;
+        }
+        return static_cast<uint64_t>(r.stepHistogram.size()) * r.binWidth;
+    };
+    const uint64_t multiple = r.crossings[3] + r.crossings[4] + r.crossings[5] + r.crossings[6] + r.crossings[7];
+
+    out << std::fixed << std::setprecision(1);
+    out << "  rays      " << r.samples << " samples, steps " << r.steps / n << " avg / <" << percentile(0.5)
+        << " p50 / <" << percentile(0.99) << " p99\n";
+    out << "            captured " << 100.0 * r.fates[0] / n << "%, escaped " << 100.0 * r.fates[1] / n
+        << "%, step limit " << 100.0 * r.fates[2] / n << "%; disk crossings 0/1/2/3+: "
+        << 100.0 * r.crossings[0] / n << " / " << 100.0 * r.crossings[1] / n << " / "
+        << 100.0 * r.crossings[2] / n << " / " << 100.0 * multiple / n << "%\n";
+}
+
+void GpuProfiler::report(std::ostream& out) const {
+    const std::ios::fmtflags flags = out.flags();
+    const std::streamsize precision = out.precision();
+
+    auto line = [&out](const char* name, const Stats& st) {
+        if (st.samples == 0) return;
+        out << "  " << std::left << std::setw(10) << name << std::right << std::fixed << std::setprecision(3)
+            << st.minMs << " / " << st.avgMs << " / " << st.p99Ms << " ms (min/avg/p99)\n";
+    };
+
+    // Ray statistics come from the trace, not the query pools: reported without timestamps too
+    if (available) {
+        out << "[Profiler] last " << series[0].count << " frames (lag " << slots.size() << "):\n";
+        for (uint32_t s = 0; s < kStageCount; ++s) line(kStageNames[s], summarize(series[s]));
+        line("host wait", summarize(hostWait));
+        if (statisticsEnabled) {
+            out << "  compute invocations: " << computeInvocations << "\n";
+        }
+    } else if (rayStats.samples != 0) {
+        out << "[Profiler] no GPU timestamps; last frame's rays:\n";
+    }
+    reportRayStats(out);
+    out.flags(flags);
+    out.precision(precision);
+}
@@ -0,0 +1,125 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <array>
+#include <cstdint>
+#include <iosfwd>
+#include <vector>
+
+class VulkanContext;
+
+/**
+ * GpuProfiler
+ * ===========
+ * Per-stage GPU timings from timestamp queries, plus optional compute-invocation
+ * pipeline statistics, with rolling min / avg / p99 over the last N samples.
+ *
+ * Each frame slot owns its own query pools. Results are read in collect() when the
+ * slot comes around again (so they lag by framesInFlight), never with WAIT, and the
+ * queries are then reset on the host; recording never stalls a queue.
+ *
+ * Timestamps are written at ALL_COMMANDS on both ends, so a stage's time is the time
+ * its commands occupy the queue after prior work drained, not overlapping with it.
+ */
+class GpuProfiler {
+public:
+    enum class Stage : uint32_t {
+        Trace = 0,   // geodesic trace dispatch
+        Resolve,     // upscale / temporal accumulation
+        Barriers,    // pre-blit ownership acquire + swapchain transition (graphics queue)
+        Blit,        // storage -> swapchain blit and the trailing barriers
+        Count
+    };
+
+    struct Stats {
+        float    minMs   = 0.0f;
+        float    avgMs   = 0.0f;
+        float    p99Ms   = 0.0f;
+        uint32_t samples = 0;
+    };
+
+    // One frame's per-sample trace counters (ComputePipelineOptions::rayStatistics)
+    struct RayStats {
+        uint64_t                samples  = 0;
+        uint64_t                steps    = 0;      // summed over all samples
+        std::array<uint64_t, 3> fates{};           // captured, escaped, step limit
+        std::array<uint64_t, 8> crossings{};       // samples with 0..6 and 7+ raymarched disk crossings
+        std::vector<uint64_t>   stepHistogram;     // samples per binWidth steps
+        uint32_t                binWidth = 1;
+    };
+
+    GpuProfiler(VulkanContext& context, uint32_t framesInFlight, bool pipelineStatistics,
+                uint32_t historyLength = 240);
+    ~GpuProfiler();
+
+    GpuProfiler(const GpuProfiler&) = delete;
+    GpuProfiler& operator=(const GpuProfiler&) = delete;
+
+    // False when the device can't provide timestamps (no valid bits, no host query reset)
+    bool isAvailable() const { return available; }
+
+    // Reads the slot's results from its previous use and rearms its queries. Call once
+    // per frame after FrameScheduler::beginFrame() returned the slot. Returns true if
+    // fresh samples were read.
+    bool collect(uint32_t slot);
+
+    // Record into the current slot (the one passed to collect)
+    void begin(VkCommandBuffer cmd, Stage stage);
+    void end(VkCommandBuffer cmd, Stage stage);
+    void beginStatistics(VkCommandBuffer cmd);
+    void endStatistics(VkCommandBuffer cmd);
+
+    // CPU time blocked on frame pacing / acquire, for comparison with the GPU stages
+    void addHostWait(float ms);
+
+    float    lastMs(Stage stage) const { return series[index(stage)].last; }
+    // Samples of the stage read so far; lastMs() is new when this moved (Benchmark)
+    uint64_t sampleCount(Stage stage) const { return series[index(stage)].total; }
+    Stats    stats(Stage stage) const { return summarize(series[index(stage)]); }
+    Stats    hostWaitStats()     const { return summarize(hostWait); }
+    uint64_t lastComputeInvocations() const { return computeInvocations; }
+
+    // Latest ray statistics, reported with the stage timings
+    void            setRayStats(const RayStats& stats) { rayStats = stats; }
+    const RayStats& lastRayStats() const { return rayStats; }
+
+    // One line per stage: "name min/avg/p99 ms" (skipped without timestamps), then the ray
+    // statistics if any
+    void report(std::ostream& out) const;
+
+private:
+    static constexpr uint32_t kStageCount = static_cast<uint32_t>(Stage::Count);
+    static uint32_t index(Stage s) { return static_cast<uint32_t>(s); }
+
+    struct Series {
+        std::vector<float> samples;    // ring
+        size_t             next  = 0;
+        size_t             count = 0;
+        float              last  = 0.0f;
+        uint64_t           total = 0;      // every push, not capped by the ring
+    };
+
+    struct Slot {
+        VkQueryPool timestamps = VK_NULL_HANDLE;   // 2 per stage
+        VkQueryPool statistics = VK_NULL_HANDLE;   // 1 query, compute invocations
+        uint32_t    written    = 0;                // stage bitmask
+        bool        statsWritten = false;
+    };
+
+    void push(Series& s, float ms);
+    void reportRayStats(std::ostream& out) const;
+    static Stats summarize(const Series& s);
+
+    VkDevice                 device = VK_NULL_HANDLE;
+    bool                     available = false;
+    bool                     statisticsEnabled = false;
+    float                    periodNs = 1.0f;
+    uint64_t                 mask = ~0ull;
+
+    std::vector<Slot>        slots;
+    uint32_t                 current = 0;
+
+    std::array<Series, kStageCount> series{};
+    Series                   hostWait;
+    uint64_t                 computeInvocations = 0;
+    RayStats                 rayStats;
+};
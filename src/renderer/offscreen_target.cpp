@@ -0,0 +1,70 @@
+#include "offscreen_target.h"
+#include "vulkan_context.h"
+
+#include <stdexcept>
+#include <iostream>
+
+OffscreenTarget::OffscreenTarget(VulkanContext& context, VkExtent2D size, uint32_t imageCount)
+    : ctx(context), device(context.getDevice()), extent(size) {
+
+    if (extent.width == 0 || extent.height == 0 || imageCount == 0) {
+        throw std::runtime_error("[Offscreen] Target needs a non-empty extent and at least one image.");
+    }
+
+    // Same rule as the swapchain: direct compute output needs format-less storage writes
+    storageUsage = ctx.supportsStorageWriteWithoutFormat();
+    format = storageUsage ? VK_FORMAT_R8G8B8A8_UNORM : VK_FORMAT_R8G8B8A8_SRGB;
+
+    // Traced on compute, copied out on graphics: CONCURRENT like the swapchain images
+    const uint32_t families[2] = { ctx.getComputeQueueFamily(), ctx.getGraphicsQueueFamily() };
+    const bool shared = families[0] != families[1];
+
+    VkImageUsageFlags usage = VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+    if (storageUsage) usage |= VK_IMAGE_USAGE_STORAGE_BIT;
+
+    images.resize(imageCount, VK_NULL_HANDLE);
+    memories.resize(imageCount);
+    views.resize(imageCount, VK_NULL_HANDLE);
+
+    for (uint32_t i = 0; i < imageCount; ++i) {
+        VkImageCreateInfo ici{ VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO };
+        ici.imageType = VK_IMAGE_TYPE_2D;
+        ici.format = format;
+        ici.extent = { extent.width, extent.height, 1 };
+        ici.mipLevels = 1;
+        ici.arrayLayers = 1;
+        ici.samples = VK_SAMPLE_COUNT_1_BIT;
+        ici.tiling = VK_IMAGE_TILING_OPTIMAL;
+        ici.usage = usage;
+        ici.sharingMode = shared ? VK_SHARING_MODE_CONCURRENT : VK_SHARING_MODE_EXCLUSIVE;
+        ici.queueFamilyIndexCount = shared ? 2u : 0u;
+        ici.pQueueFamilyIndices = shared ? families : nullptr;
+        ici.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+        if (vkCreateImage(device, &ici, nullptr, &images[i]) != VK_SUCCESS) {
+            throw std::runtime_error("[Offscreen] Failed to create target image.");
+        }
+
+        memories[i] = ctx.getMemory().bind(images[i], VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+        VkImageViewCreateInfo vci{ VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO };
+        vci.image = images[i];
+        vci.viewType = VK_IMAGE_VIEW_TYPE_2D;
+        vci.format = format;
+        vci.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+        if (vkCreateImageView(device, &vci, nullptr, &views[i]) != VK_SUCCESS) {
+            throw std::runtime_error("[Offscreen] Failed to create target image view.");
+        }
+    }
+
+    std::cout << "[Offscreen] " << imageCount << " target images, " << extent.width << "x" << extent.height
+              << (storageUsage ? " (storage, direct compute output)" : " (blit)") << ".\n";
+}
+
+OffscreenTarget::~OffscreenTarget() {
+    for (size_t i = 0; i < images.size(); ++i) {
+        if (views[i])    vkDestroyImageView(device, views[i], nullptr);
+        if (images[i])   vkDestroyImage(device, images[i], nullptr);
+        ctx.getMemory().free(memories[i]);
+    }
+}
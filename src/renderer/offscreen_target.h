@@ -0,0 +1,51 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <vector>
+#include <cstdint>
+
+#include "render_target.h"
+#include "gpu_memory.h"
+
+class VulkanContext;
+
+/**
+ * OffscreenTarget
+ * ===============
+ * Swapchain stand-in for headless rendering: a fixed set of device-local RGBA8 images
+ * that ComputePipeline writes exactly like swapchain images, left in TRANSFER_SRC so
+ * the frame can be copied out to a readback buffer.
+ *
+ * With format-less storage writes the images are UNORM + STORAGE (the shader encodes
+ * sRGB, direct output). Otherwise they are SRGB and filled by the storage -> target blit,
+ * which does the encode. Either way the bytes are 8-bit sRGB RGBA.
+ */
+class OffscreenTarget : public RenderTarget {
+public:
+    OffscreenTarget(VulkanContext& context, VkExtent2D extent, uint32_t imageCount);
+    ~OffscreenTarget() override;
+
+    OffscreenTarget(const OffscreenTarget&) = delete;
+    OffscreenTarget& operator=(const OffscreenTarget&) = delete;
+
+    VkFormat      getImageFormat()  const override { return format; }
+    VkExtent2D    getExtent()       const override { return extent; }
+    size_t        getImageCount()   const override { return images.size(); }
+    bool          hasStorageUsage() const override { return storageUsage; }
+    VkImageLayout getFinalLayout()  const override { return VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL; }
+
+    VkImageView getImageView(size_t index) const override { return views[index]; }
+    VkImage     getImage(size_t index)     const override { return images[index]; }
+
+    static constexpr uint32_t kBytesPerPixel = 4;
+
+private:
+    VulkanContext&              ctx;
+    VkDevice                    device       = VK_NULL_HANDLE;
+    VkExtent2D                  extent{0, 0};
+    VkFormat                    format       = VK_FORMAT_R8G8B8A8_UNORM;
+    bool                        storageUsage = false;
+
+    std::vector<VkImage>        images;
+    std::vector<GpuAllocation>  memories;
+    std::vector<VkImageView>    views;
+};
@@ -0,0 +1,135 @@
+#include "pipeline_cache.h"
+#include "../core/mapped_file.h"
+
+#include <stdexcept>
+#include <iostream>
+#include <fstream>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+#include <vector>
+#include <filesystem>
+
+namespace {
+    // Precedes the driver's blob in the file; any mismatch means the blob is stale
+    struct FileHeader {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t vendorID;
+        uint32_t deviceID;
+        uint32_t driverVersion;
+        uint8_t  uuid[VK_UUID_SIZE];
+        uint32_t reserved;         // keeps dataSize aligned without padding (the header is memcmp'd)
+        uint64_t dataSize;
+    };
+
+    constexpr uint32_t kMagic   = 0x43504752;   // "RGPC"
+    constexpr uint32_t kVersion = 1;
+
+    FileHeader makeHeader(const VkPhysicalDeviceProperties& props, size_t dataSize) {
+        FileHeader h{};
+        h.magic = kMagic;
+        h.version = kVersion;
+        h.vendorID = props.vendorID;
+        h.deviceID = props.deviceID;
+        h.driverVersion = props.driverVersion;
+        std::memcpy(h.uuid, props.pipelineCacheUUID, VK_UUID_SIZE);
+        h.dataSize = dataSize;
+        return h;
+    }
+}
+
+std::string PipelineCache::cacheDirectory() {
+    if (const char* dir = std::getenv("GARGANTUA_CACHE_DIR")) return dir;
+#ifdef _WIN32
+    if (const char* local = std::getenv("LOCALAPPDATA")) return std::string(local) + "/Gargantua";
+#else
+    if (const char* xdg = std::getenv("XDG_CACHE_HOME")) return std::string(xdg) + "/gargantua";
+    if (const char* home = std::getenv("HOME")) return std::string(home) + "/.cache/gargantua";
+#endif
+    std::error_code ec;
+    return (std::filesystem::temp_directory_path(ec) / "gargantua").string();
+}
+
+std::string PipelineCache::deviceKey(const VkPhysicalDeviceProperties& props) {
+    static const char* hex = "0123456789abcdef";
+    std::string key;
+    for (uint8_t b : props.pipelineCacheUUID) { key += hex[b >> 4]; key += hex[b & 15]; }
+    return key;
+}
+
+PipelineCache::PipelineCache(VkPhysicalDevice physicalDevice, VkDevice dev) : device(dev) {
+    vkGetPhysicalDeviceProperties(physicalDevice, &props);
+    path = cacheDirectory() + "/pipelines_" + deviceKey(props) + ".bin";
+
+    // Seed from disk when the header matches this device and driver exactly
+    const MappedFile file = MappedFile::tryOpen(path);
+    const uint8_t* initialData = nullptr;
+    size_t initialSize = 0;
+    if (file.size() > sizeof(FileHeader)) {
+        FileHeader stored{};
+        std::memcpy(&stored, file.data(), sizeof(stored));
+        const FileHeader expected = makeHeader(props, file.size() - sizeof(FileHeader));
+        if (std::memcmp(&stored, &expected, sizeof(FileHeader)) == 0) {
+            initialData = file.data() + sizeof(FileHeader);
+            initialSize = file.size() - sizeof(FileHeader);
+        } else {
+            std::cout << "[PipelineCache] Ignoring " << path << " (other driver or truncated).\n";
+        }
+    }
+
+    VkPipelineCacheCreateInfo ci{ VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO };
+    ci.initialDataSize = initialSize;
+    ci.pInitialData = initialData;
+    VkResult res = vkCreatePipelineCache(device, &ci, nullptr, &cache);
+    if (res != VK_SUCCESS && initialData) {
+        // A driver may still reject data it cannot parse; start empty then
+        ci.initialDataSize = 0;
+        ci.pInitialData = nullptr;
+        initialSize = 0;
+        res = vkCreatePipelineCache(device, &ci, nullptr, &cache);
+    }
+    if (res != VK_SUCCESS) throw std::runtime_error("[PipelineCache] Failed to create pipeline cache.");
+
+    savedSize = initialSize;
+    if (initialSize) {
+        std::cout << "[PipelineCache] Loaded " << (initialSize + 1023) / 1024 << " KiB from " << path << "\n";
+    }
+}
+
+PipelineCache::~PipelineCache() {
+    if (cache == VK_NULL_HANDLE) return;
+    save();
+    vkDestroyPipelineCache(device, cache, nullptr);
+}
+
+void PipelineCache::save() noexcept {
+    size_t size = 0;
+    if (vkGetPipelineCacheData(device, cache, &size, nullptr) != VK_SUCCESS || size == 0) return;
+    if (size == savedSize) return;
+
+    std::vector<uint8_t> data(size);
+    if (vkGetPipelineCacheData(device, cache, &size, data.data()) != VK_SUCCESS) return;
+
+    // A cache is an optimisation: report failures, never fail the run for them
+    std::error_code ec;
+    std::filesystem::create_directories(std::filesystem::path(path).parent_path(), ec);
+
+    const std::string tmp = path + ".tmp";
+    {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        const FileHeader header = makeHeader(props, size);
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(size));
+        if (!out) {
+            std::cerr << "[PipelineCache] Warning: failed to write " << tmp << "\n";
+            return;
+        }
+    }
+    std::filesystem::rename(tmp, path, ec);
+    if (ec) {
+        std::cerr << "[PipelineCache] Warning: failed to move " << tmp << " to " << path << "\n";
+        return;
+    }
+    savedSize = size;
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <cstddef>
+#include <string>
+
+/**
+ * PipelineCache
+ * =============
+ * VkPipelineCache persisted across runs, so launches and recreate() reuse the driver's
+ * compiled shaders instead of recompiling gargantua.comp. One file per physical device
+ * (named by its pipelineCacheUUID) under the user cache directory, or GARGANTUA_CACHE_DIR.
+ *
+ * The file starts with our own header (vendor, device, driver version, UUID, blob size);
+ * a blob from another driver build is ignored rather than handed to the driver.
+ * Written atomically on destruction, and only if the driver added pipelines.
+ */
+class PipelineCache {
+public:
+    PipelineCache(VkPhysicalDevice physicalDevice, VkDevice device);
+    ~PipelineCache();   // saves, then destroys; the device must still be alive
+
+    PipelineCache(const PipelineCache&) = delete;
+    PipelineCache& operator=(const PipelineCache&) = delete;
+
+    VkPipelineCache get() const { return cache; }
+
+    // Writes the current contents now (also done by the destructor); never throws
+    void save() noexcept;
+
+    // User cache directory (or GARGANTUA_CACHE_DIR), shared with other per-device data
+    static std::string cacheDirectory();
+    // Hex pipelineCacheUUID: names per-device files in cacheDirectory()
+    static std::string deviceKey(const VkPhysicalDeviceProperties& props);
+
+private:
+    VkDevice             device = VK_NULL_HANDLE;
+    VkPhysicalDeviceProperties props{};
+    VkPipelineCache      cache  = VK_NULL_HANDLE;
+    std::string          path;
+    size_t               savedSize = 0;   // blob size on disk; unchanged caches are not rewritten
+};
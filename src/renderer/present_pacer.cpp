@@ -0,0 +1,76 @@
+#include "present_pacer.h"
+#include "swapchain.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <ostream>
+
+namespace {
+    // A minimized or occluded window may not display for a long time; don't hang the loop on it
+    constexpr uint64_t kPaceTimeoutNs = 100'000'000ull;
+}
+
+PresentPacer::PresentPacer(Swapchain& sc, uint32_t queued)
+    : swapchain(sc), maxQueued(std::max(queued, 1u)) {}
+
+bool PresentPacer::isPacing() const { return swapchain.supportsPresentWait(); }
+
+void PresentPacer::pace() {
+    const uint64_t last = swapchain.getLastPresentId();
+    if (!isPacing() || last < maxQueued) return;
+
+    const uint64_t target = last - (maxQueued - 1);
+    if (target <= displayed) return;
+    if (swapchain.waitForPresent(target, kPaceTimeoutNs)) resolve(target);
+}
+
+void PresentPacer::inputSampled(Clock::time_point time) {
+    if (sampled) return;   // the first event is the one that waited longest
+    sampled = true;
+    sampledInput = time;
+}
+
+void PresentPacer::presented() {
+    if (sampled) {
+        sampled = false;
+        if (isPacing()) {
+            pending.push_back(Pending{ swapchain.getLastPresentId(), sampledInput });
+        } else {
+            addSample(sampledInput);
+        }
+    }
+    // Oldest first, without blocking
+    while (!pending.empty() && swapchain.waitForPresent(pending.front().presentId, 0)) {
+        resolve(pending.front().presentId);
+    }
+}
+
+void PresentPacer::resolve(uint64_t displayedId) {
+    displayed = std::max(displayed, displayedId);
+    while (!pending.empty() && pending.front().presentId <= displayed) {
+        addSample(pending.front().input);
+        pending.pop_front();
+    }
+}
+
+void PresentPacer::addSample(Clock::time_point input) {
+    const float ms = std::chrono::duration<float, std::milli>(Clock::now() - input).count();
+    sumMs += ms;
+    maxMs = std::max(maxMs, ms);
+    ++count;
+}
+
+void PresentPacer::report(std::ostream& out) {
+    if (count == 0) return;
+    const std::ios::fmtflags flags = out.flags();
+    const std::streamsize precision = out.precision();
+
+    out << " | Latency: " << std::fixed << std::setprecision(1) << sumMs / count << " / " << maxMs
+        << " ms avg/max (input to " << (isPacing() ? "display" : "present call") << ")";
+
+    out.flags(flags);
+    out.precision(precision);
+    sumMs = 0.0;
+    maxMs = 0.0f;
+    count = 0;
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <iosfwd>
+
+class Swapchain;
+
+/**
+ * PresentPacer
+ * ============
+ * Low-latency frame pacing (--low-latency) and input-to-present measurement.
+ *
+ * FrameScheduler only throttles the CPU to framesInFlight frames ahead of the GPU, so
+ * camera input is sampled up to that many frames before it reaches the screen. With
+ * VK_KHR_present_wait, pace() instead blocks until at most maxQueued presents are still
+ * waiting for display, and the caller samples input right after it: the frame is
+ * recorded from state that is as fresh as the display allows.
+ *
+ * Latency is measured from the first input event a frame consumed to its present being
+ * displayed (vkWaitForPresentKHR). Outside pace() the present ids are polled once per
+ * frame, so unpaced samples are late by up to a frame. Without present wait the sample
+ * ends when vkQueuePresentKHR returns, a lower bound on the real latency.
+ */
+class PresentPacer {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    PresentPacer(Swapchain& swapchain, uint32_t maxQueued);
+
+    PresentPacer(const PresentPacer&) = delete;
+    PresentPacer& operator=(const PresentPacer&) = delete;
+
+    bool isPacing()       const;   // present wait available: pace() blocks
+    // Blocks until at most maxQueued presents are pending display (at most 100 ms)
+    void pace();
+    // The frame being recorded consumed input first seen at time; call before present()
+    void inputSampled(Clock::time_point time);
+    // After Swapchain::present(): ties the sampled input to the present id
+    void presented();
+
+    // Appends " | Latency: avg / max ms (...)" for the samples since the last report
+    void report(std::ostream& out);
+
+private:
+    struct Pending {
+        uint64_t          presentId = 0;
+        Clock::time_point input;
+    };
+
+    void resolve(uint64_t displayedId);   // samples whose present is on screen
+    void addSample(Clock::time_point input);
+
+    Swapchain&            swapchain;
+    uint32_t              maxQueued = 1;
+    bool                  sampled   = false;   // inputSampled() since the last present
+    Clock::time_point     sampledInput;
+    std::deque<Pending>   pending;             // ordered by present id
+    uint64_t              displayed = 0;       // highest id known to be on screen
+
+    double                sumMs = 0.0;
+    float                 maxMs = 0.0f;
+    uint32_t              count = 0;
+};
@@ -0,0 +1,32 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * RenderTarget
+ * ============
+ * The set of images ComputePipeline writes a finished frame into: the swapchain when
+ * presenting, or OffscreenTarget in headless mode. Images must be usable from both the
+ * compute and graphics families without ownership transfers (CONCURRENT or one family).
+ *
+ * Each frame ends with the image in getFinalLayout(): PRESENT_SRC for a swapchain,
+ * TRANSFER_SRC for targets that are read back.
+ */
+class RenderTarget {
+public:
+    virtual ~RenderTarget() = default;
+
+    virtual VkFormat      getImageFormat()  const = 0;
+    virtual VkExtent2D    getExtent()       const = 0;
+    virtual size_t        getImageCount()   const = 0;
+    virtual bool          hasStorageUsage() const = 0;   // compute may write the images directly
+    virtual VkImageLayout getFinalLayout()  const = 0;
+
+    virtual VkImageView   getImageView(size_t index) const = 0;
+    virtual VkImage       getImage(size_t index)     const = 0;
+
+    // Bumped whenever the images are replaced (swapchain recreation); ComputePipeline
+    // rebuilds its target-sized resources when it changes. Fixed targets keep 0.
+    virtual uint64_t      getGeneration()   const { return 0; }
+};
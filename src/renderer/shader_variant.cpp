@@ -0,0 +1,87 @@
+#include "shader_variant.h"
+
+#include <cstddef>
+
+TraceVariant TraceVariant::preset(QualityPreset quality) {
+    TraceVariant v;
+    switch (quality) {
+        case QualityPreset::Low:
+            v.samplesPerAxis = 1;
+            v.maxSteps = 500;
+            v.stepSize = 0.16f;
+            v.diskSteps = 6;
+            v.photonRing = false;
+            break;
+        case QualityPreset::Medium:
+            v.samplesPerAxis = 2;
+            v.maxSteps = 800;
+            v.stepSize = 0.12f;
+            v.diskSteps = 8;
+            break;
+        case QualityPreset::High:
+            break;
+        case QualityPreset::Ultra:
+            v.samplesPerAxis = 3;
+            v.maxSteps = 2400;
+            v.stepSize = 0.04f;
+            v.diskSteps = 24;
+            break;
+    }
+    return v;
+}
+
+TraceVariant TraceVariant::withPreset(QualityPreset quality) const {
+    TraceVariant v = preset(quality);
+    v.disk = disk;
+    v.debugView = debugView;
+    v.groupWidth = groupWidth;
+    v.groupHeight = groupHeight;
+    return v;
+}
+
+bool TraceVariant::sameGeodesic(const TraceVariant& other) const {
+    return maxSteps == other.maxSteps && stepSize == other.stepSize
+        && glow == other.glow && photonRing == other.photonRing;
+}
+
+GeodesicSpecConstants GeodesicSpecConstants::from(const TraceVariant& variant) {
+    GeodesicSpecConstants c{};
+    c.maxSteps = variant.maxSteps;
+    c.stepSize = variant.stepSize;
+    c.glow = variant.glow ? VK_TRUE : VK_FALSE;
+    c.photonRing = variant.photonRing ? VK_TRUE : VK_FALSE;
+    return c;
+}
+
+void GeodesicSpecConstants::appendEntries(std::vector<VkSpecializationMapEntry>& entries, uint32_t baseOffset) {
+    entries.push_back({ 10, baseOffset + static_cast<uint32_t>(offsetof(GeodesicSpecConstants, maxSteps)),   sizeof(int32_t) });
+    entries.push_back({ 11, baseOffset + static_cast<uint32_t>(offsetof(GeodesicSpecConstants, stepSize)),   sizeof(float) });
+    entries.push_back({ 12, baseOffset + static_cast<uint32_t>(offsetof(GeodesicSpecConstants, glow)),       sizeof(VkBool32) });
+    entries.push_back({ 13, baseOffset + static_cast<uint32_t>(offsetof(GeodesicSpecConstants, photonRing)), sizeof(VkBool32) });
+}
+
+bool parseQualityPreset(const std::string& name, QualityPreset& quality) {
+    if (name == "low")    { quality = QualityPreset::Low;    return true; }
+    if (name == "medium") { quality = QualityPreset::Medium; return true; }
+    if (name == "high")   { quality = QualityPreset::High;   return true; }
+    if (name == "ultra")  { quality = QualityPreset::Ultra;  return true; }
+    return false;
+}
+
+bool parseDebugView(const std::string& name, DebugView& view) {
+    if (name == "none")      { view = DebugView::None;      return true; }
+    if (name == "fate")      { view = DebugView::RayFate;   return true; }
+    if (name == "direction") { view = DebugView::Direction; return true; }
+    if (name == "steps")     { view = DebugView::Steps;     return true; }
+    return false;
+}
+
+const char* qualityPresetName(QualityPreset quality) {
+    switch (quality) {
+        case QualityPreset::Low:    return "low";
+        case QualityPreset::Medium: return "medium";
+        case QualityPreset::High:   return "high";
+        case QualityPreset::Ultra:  return "ultra";
+    }
+    return "?";
+}
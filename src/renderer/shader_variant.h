@@ -0,0 +1,63 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// gargantua.comp DEBUG_VIEW
+enum class DebugView : int32_t {
+    None      = 0,   // shaded image
+    RayFate   = 1,   // red: disk coverage, green: escaped, blue: step limit, black: captured
+    Direction = 2,   // escape direction as colour (lensing map)
+    Steps     = 3,   // step count heatmap, white: step limit (not in wavefront mode)
+};
+
+enum class QualityPreset { Low, Medium, High, Ultra };
+
+/**
+ * TraceVariant
+ * ============
+ * The quality and feature specialization constants of the trace shader. Each distinct
+ * variant is its own pipeline, so the driver unrolls the step loops and drops disabled
+ * features entirely; ComputePipeline keeps every variant it has built, so switching back
+ * and forth at runtime costs nothing after the first use.
+ *
+ * maxSteps/stepSize/glow/photonRing live in geodesic.glsl and also specialize the
+ * deflection LUT bake, so a LUT-backed trace sees the same paths as an integrated one.
+ */
+struct TraceVariant {
+    int32_t   samplesPerAxis = 2;       // AA of the supersampled trace (temporal traces 1)
+    int32_t   maxSteps       = 1200;    // MAX_GEODESIC_STEPS
+    float     stepSize       = 0.08f;   // STEP_SIZE, outer step tier
+    int32_t   diskSteps      = 12;      // DISK_STEPS, raymarch samples per disk crossing
+    bool      disk           = true;
+    bool      glow           = true;
+    bool      photonRing     = true;
+    DebugView debugView      = DebugView::None;
+    uint32_t  groupWidth     = 16;      // local_size_x_id / local_size_y_id (WorkgroupTuner)
+    uint32_t  groupHeight    = 16;
+
+    static TraceVariant preset(QualityPreset quality);   // High is the default above
+    TraceVariant withPreset(QualityPreset quality) const; // preset quality; keeps disk, debug view, workgroup
+
+    bool operator==(const TraceVariant&) const = default;
+    bool sameGeodesic(const TraceVariant& other) const;  // equal geodesic.glsl constants
+};
+
+// geodesic.glsl's constants (ids 10..13) as specialization data, shared by every shader that includes it
+struct GeodesicSpecConstants {
+    int32_t  maxSteps;     // constant_id = 10
+    float    stepSize;     // constant_id = 11
+    VkBool32 glow;         // constant_id = 12
+    VkBool32 photonRing;   // constant_id = 13
+
+    static GeodesicSpecConstants from(const TraceVariant& variant);
+
+    // Map entries for a GeodesicSpecConstants placed at baseOffset in the specialization data
+    static void appendEntries(std::vector<VkSpecializationMapEntry>& entries, uint32_t baseOffset);
+};
+
+// Command-line names: low|medium|high|ultra and none|fate|direction|steps
+bool        parseQualityPreset(const std::string& name, QualityPreset& quality);
+bool        parseDebugView(const std::string& name, DebugView& view);
+const char* qualityPresetName(QualityPreset quality);
@@ -0,0 +1,251 @@
+#include "sky_environment.h"
+#include "vulkan_context.h"
+#include "compute_pass.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <iostream>
+
+namespace {
+    // Must match BakeUniforms in sky_bake.comp
+    struct BakePushConstants {
+        int32_t size;
+        int32_t level;
+    };
+}
+
+SkyEnvironment::SkyEnvironment(VulkanContext& context, const std::string& shaderDir, uint32_t faceSize)
+    : ctx(context), device(context.getDevice()), enabled(faceSize > 0) {
+
+    if (enabled) {
+        size = faceSize;
+        levels = 1;
+        while ((size >> levels) > 0) ++levels;
+    }
+    createImage();
+    createSampler();
+    createDescriptors();
+
+    if (enabled) {
+        bakePass = std::make_unique<ComputePass>(ctx, MappedFile(shaderDir + "/sky_bake.comp.spv"),
+            std::vector<VkDescriptorSetLayout>{ bakeLayout }, static_cast<uint32_t>(sizeof(BakePushConstants)));
+        std::cout << "[Sky] Baked background enabled (" << size << "^2 x 6, " << levels << " levels).\n";
+    }
+}
+
+SkyEnvironment::~SkyEnvironment() {
+    // Caller guarantees the GPU is idle (ComputePipeline drains the scheduler first)
+    bakePass.reset();
+    if (pool)       vkDestroyDescriptorPool(device, pool, nullptr);
+    if (bakeLayout) vkDestroyDescriptorSetLayout(device, bakeLayout, nullptr);
+    if (setLayout)  vkDestroyDescriptorSetLayout(device, setLayout, nullptr);
+    if (sampler)    vkDestroySampler(device, sampler, nullptr);
+    for (VkImageView view : levelViews) vkDestroyImageView(device, view, nullptr);
+    if (cubeView)   vkDestroyImageView(device, cubeView, nullptr);
+    if (image)      vkDestroyImage(device, image, nullptr);
+    ctx.getMemory().free(memory);
+}
+
+void SkyEnvironment::createImage() {
+    VkImageCreateInfo ici{};
+    ici.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    ici.flags = VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT;
+    ici.imageType = VK_IMAGE_TYPE_2D;
+    ici.format = kFormat;
+    ici.extent = { size, size, 1 };
+    ici.mipLevels = levels;
+    ici.arrayLayers = 6;
+    ici.samples = VK_SAMPLE_COUNT_1_BIT;
+    ici.tiling = VK_IMAGE_TILING_OPTIMAL;
+    ici.usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_STORAGE_BIT;
+    ici.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    ici.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+    if (vkCreateImage(device, &ici, nullptr, &image) != VK_SUCCESS) {
+        throw std::runtime_error("[Sky] Failed to create cubemap image.");
+    }
+
+    memory = ctx.getMemory().bind(image, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+    VkImageViewCreateInfo vci{};
+    vci.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    vci.image = image;
+    vci.viewType = VK_IMAGE_VIEW_TYPE_CUBE;
+    vci.format = kFormat;
+    vci.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, levels, 0, 6 };
+
+    if (vkCreateImageView(device, &vci, nullptr, &cubeView) != VK_SUCCESS) {
+        throw std::runtime_error("[Sky] Failed to create cubemap view.");
+    }
+
+    if (!enabled) return;
+
+    // Storage images bind one level; the bake addresses faces as array layers
+    levelViews.resize(levels, VK_NULL_HANDLE);
+    vci.viewType = VK_IMAGE_VIEW_TYPE_2D_ARRAY;
+    for (uint32_t level = 0; level < levels; ++level) {
+        vci.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, level, 1, 0, 6 };
+        if (vkCreateImageView(device, &vci, nullptr, &levelViews[level]) != VK_SUCCESS) {
+            throw std::runtime_error("[Sky] Failed to create cubemap level view.");
+        }
+    }
+}
+
+void SkyEnvironment::createSampler() {
+    VkSamplerCreateInfo sci{ VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO };
+    sci.magFilter = VK_FILTER_LINEAR;
+    sci.minFilter = VK_FILTER_LINEAR;
+    sci.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+    sci.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    sci.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    sci.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    sci.maxLod = static_cast<float>(levels);
+    if (vkCreateSampler(device, &sci, nullptr, &sampler) != VK_SUCCESS) {
+        throw std::runtime_error("[Sky] Failed to create sampler.");
+    }
+}
+
+void SkyEnvironment::createDescriptors() {
+    VkDescriptorSetLayoutBinding sampled{};
+    sampled.binding = 0;
+    sampled.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    sampled.descriptorCount = 1;
+    sampled.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+    VkDescriptorSetLayoutCreateInfo lci{};
+    lci.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    lci.bindingCount = 1;
+    lci.pBindings = &sampled;
+    if (vkCreateDescriptorSetLayout(device, &lci, nullptr, &setLayout) != VK_SUCCESS) {
+        throw std::runtime_error("[Sky] Failed to create descriptor set layout.");
+    }
+
+    VkDescriptorSetLayoutBinding storage[2]{};
+    for (uint32_t i = 0; i < 2; ++i) {
+        storage[i].binding = i;
+        storage[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+        storage[i].descriptorCount = 1;
+        storage[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    }
+    lci.bindingCount = 2;
+    lci.pBindings = storage;
+    if (vkCreateDescriptorSetLayout(device, &lci, nullptr, &bakeLayout) != VK_SUCCESS) {
+        throw std::runtime_error("[Sky] Failed to create bake descriptor set layout.");
+    }
+
+    const uint32_t bakeCount = enabled ? levels : 0u;
+    VkDescriptorPoolSize poolSizes[2] = {
+        { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1 },
+        { VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 2 * levels },
+    };
+    VkDescriptorPoolCreateInfo pci{};
+    pci.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    pci.maxSets = 1 + bakeCount;
+    pci.poolSizeCount = 2;
+    pci.pPoolSizes = poolSizes;
+    if (vkCreateDescriptorPool(device, &pci, nullptr, &pool) != VK_SUCCESS) {
+        throw std::runtime_error("[Sky] Failed to create descriptor pool.");
+    }
+
+    VkDescriptorSetAllocateInfo ai{};
+    ai.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    ai.descriptorPool = pool;
+    ai.descriptorSetCount = 1;
+    ai.pSetLayouts = &setLayout;
+    if (vkAllocateDescriptorSets(device, &ai, &set) != VK_SUCCESS) {
+        throw std::runtime_error("[Sky] Failed to allocate descriptor set.");
+    }
+
+    const VkDescriptorImageInfo cubeInfo{ sampler, cubeView, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
+    VkWriteDescriptorSet write{};
+    write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write.dstSet = set;
+    write.dstBinding = 0;
+    write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    write.descriptorCount = 1;
+    write.pImageInfo = &cubeInfo;
+    vkUpdateDescriptorSets(device, 1, &write, 0, nullptr);
+
+    if (!enabled) return;
+
+    std::vector<VkDescriptorSetLayout> layouts(bakeCount, bakeLayout);
+    bakeSets.resize(bakeCount, VK_NULL_HANDLE);
+    ai.descriptorSetCount = bakeCount;
+    ai.pSetLayouts = layouts.data();
+    if (vkAllocateDescriptorSets(device, &ai, bakeSets.data()) != VK_SUCCESS) {
+        throw std::runtime_error("[Sky] Failed to allocate bake descriptor sets.");
+    }
+
+    // Level 0 has no source; it binds itself there so the set stays complete
+    for (uint32_t level = 0; level < levels; ++level) {
+        VkDescriptorImageInfo infos[2]{};
+        infos[0] = { VK_NULL_HANDLE, levelViews[level],                  VK_IMAGE_LAYOUT_GENERAL };
+        infos[1] = { VK_NULL_HANDLE, levelViews[level ? level - 1 : 0], VK_IMAGE_LAYOUT_GENERAL };
+
+        VkWriteDescriptorSet writes[2]{};
+        for (uint32_t i = 0; i < 2; ++i) {
+            writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            writes[i].dstSet = bakeSets[level];
+            writes[i].dstBinding = i;
+            writes[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+            writes[i].descriptorCount = 1;
+            writes[i].pImageInfo = &infos[i];
+        }
+        vkUpdateDescriptorSets(device, 2, writes, 0, nullptr);
+    }
+}
+
+void SkyEnvironment::record(VkCommandBuffer cmd) {
+    if (initialized) return;
+
+    VkImageMemoryBarrier2 barrier{ VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2 };
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = image;
+    barrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, levels, 0, 6 };
+
+    VkDependencyInfo dep{ VK_STRUCTURE_TYPE_DEPENDENCY_INFO };
+    dep.imageMemoryBarrierCount = 1;
+    dep.pImageMemoryBarriers = &barrier;
+
+    if (enabled) {
+        barrier.srcStageMask = VK_PIPELINE_STAGE_2_NONE;
+        barrier.dstStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+        barrier.dstAccessMask = VK_ACCESS_2_SHADER_WRITE_BIT;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        barrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+        vkCmdPipelineBarrier2(cmd, &dep);
+
+        // Each level reads the one the previous dispatch wrote
+        VkMemoryBarrier2 raw{ VK_STRUCTURE_TYPE_MEMORY_BARRIER_2 };
+        raw.srcStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+        raw.srcAccessMask = VK_ACCESS_2_SHADER_WRITE_BIT;
+        raw.dstStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+        raw.dstAccessMask = VK_ACCESS_2_SHADER_READ_BIT;
+
+        VkDependencyInfo depRaw{ VK_STRUCTURE_TYPE_DEPENDENCY_INFO };
+        depRaw.memoryBarrierCount = 1;
+        depRaw.pMemoryBarriers = &raw;
+
+        for (uint32_t level = 0; level < levels; ++level) {
+            if (level > 0) vkCmdPipelineBarrier2(cmd, &depRaw);
+            const BakePushConstants pc{ static_cast<int32_t>(size), static_cast<int32_t>(level) };
+            const uint32_t edge = std::max(size >> level, 1u);
+            bakePass->bind(cmd, &bakeSets[level], 1);
+            bakePass->pushConstants(cmd, &pc, sizeof(pc));
+            vkCmdDispatch(cmd, (edge + 7) / 8, (edge + 7) / 8, 6);
+        }
+
+        barrier.srcStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+        barrier.srcAccessMask = VK_ACCESS_2_SHADER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_2_SHADER_SAMPLED_READ_BIT;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+    } else {
+        barrier.srcStageMask = VK_PIPELINE_STAGE_2_NONE;
+        barrier.dstStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    }
+    barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    vkCmdPipelineBarrier2(cmd, &dep);
+    initialized = true;
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "gpu_memory.h"
+
+class VulkanContext;
+class ComputePass;
+
+/**
+ * SkyEnvironment
+ * ==============
+ * The procedural background (stars, nebula; sky.glsl) baked into a mipmapped cubemap
+ * (SKY_CUBEMAP). Without it every escaping ray evaluates the hash noise itself; with it
+ * an escape is one trilinear fetch, and the mip chain filters the star field where
+ * lensing or a small render squeezes many texels into one sample.
+ *
+ * sky_bake.comp writes level 0 and box-filters each further level from the one before,
+ * all in compute on the trace queue, inline with the first frame. The sky does not
+ * change afterwards. The set layout is always part of the trace pipeline layout; when
+ * disabled the cube is a 1x1 placeholder that the shader never reads.
+ */
+class SkyEnvironment {
+public:
+    // faceSize 0 disables the bake (rays evaluate background() directly)
+    SkyEnvironment(VulkanContext& context, const std::string& shaderDir, uint32_t faceSize);
+    ~SkyEnvironment();
+
+    SkyEnvironment(const SkyEnvironment&) = delete;
+    SkyEnvironment& operator=(const SkyEnvironment&) = delete;
+
+    // Records the bake (or the placeholder's layout transition) on first use and nothing
+    // afterwards. Call before the trace dispatch, on the trace queue.
+    void record(VkCommandBuffer cmd);
+
+    bool                  isEnabled()    const { return enabled; }
+    VkDescriptorSetLayout getSetLayout() const { return setLayout; }
+    VkDescriptorSet       getSet()       const { return set; }
+
+    static constexpr VkFormat kFormat = VK_FORMAT_R16G16B16A16_SFLOAT;
+
+private:
+    void createImage();
+    void createSampler();
+    void createDescriptors();
+
+    VulkanContext&         ctx;
+    VkDevice               device     = VK_NULL_HANDLE;
+    bool                   enabled    = false;
+    uint32_t               size       = 1;               // level 0 face edge
+    uint32_t               levels     = 1;
+
+    VkImage                image      = VK_NULL_HANDLE;  // 6 layers, cube compatible
+    GpuAllocation          memory;
+    VkImageView            cubeView   = VK_NULL_HANDLE;  // all levels, for sampling
+    std::vector<VkImageView> levelViews;                 // 2D array per level, for the bake
+    VkSampler              sampler    = VK_NULL_HANDLE;
+
+    VkDescriptorSetLayout  setLayout  = VK_NULL_HANDLE;  // binding 0: cube sampler
+    VkDescriptorSetLayout  bakeLayout = VK_NULL_HANDLE;  // binding 0: level, 1: level - 1
+    VkDescriptorPool       pool       = VK_NULL_HANDLE;
+    VkDescriptorSet        set        = VK_NULL_HANDLE;
+    std::vector<VkDescriptorSet> bakeSets;               // one per level
+    std::unique_ptr<ComputePass> bakePass;
+
+    bool                   initialized = false;          // baked and in SHADER_READ_ONLY_OPTIMAL
+};
@@ -3,6 +3,7 @@
 
 #include "swapchain.h"
 #include "vulkan_context.h"
+#include "frame_scheduler.h"
 #include "../core/window.h"
 
 #include <stdexcept>
@@ -10,6 +11,24 @@
 #include <limits>
 #include <algorithm>
 
+const char* presentModeName(VkPresentModeKHR mode) {
+    switch (mode) {
+        case VK_PRESENT_MODE_IMMEDIATE_KHR:    return "immediate";
+        case VK_PRESENT_MODE_MAILBOX_KHR:      return "mailbox";
+        case VK_PRESENT_MODE_FIFO_KHR:         return "fifo";
+        case VK_PRESENT_MODE_FIFO_RELAXED_KHR: return "fifo-relaxed";
+        default:                               return "other";
+    }
+}
+
+bool parsePresentMode(const std::string& name, VkPresentModeKHR& mode) {
+    for (VkPresentModeKHR m : { VK_PRESENT_MODE_IMMEDIATE_KHR, VK_PRESENT_MODE_MAILBOX_KHR,
+                                VK_PRESENT_MODE_FIFO_KHR, VK_PRESENT_MODE_FIFO_RELAXED_KHR }) {
+        if (name == presentModeName(m)) { mode = m; return true; }
+    }
+    return false;
+}
+
 static VkImageView createImageView(VkDevice device, VkImage image, VkFormat format) {
     VkImageViewCreateInfo ci{};
     ci.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
@@ -33,19 +52,29 @@ static VkImageView createImageView(VkDevice device, VkImage image, VkFormat form
     return view;
 }
 
-Swapchain::Swapchain(VulkanContext& context, Window& window)
-    : vulkanContext(context), windowRef(window) {
+Swapchain::Swapchain(VulkanContext& context, Window& window, FrameScheduler& frameScheduler,
+                     const SwapchainOptions& options)
+    : vulkanContext(context), windowRef(window), scheduler(frameScheduler),
+      allowStorageUsage(options.allowStorage), requestedPresentMode(options.presentMode) {
 
     surface = vulkanContext.getSurface();
     if (surface == VK_NULL_HANDLE) {
         throw std::runtime_error("[Swapchain] VulkanContext has no surface; call initializeForSurface first.");
     }
 
-    createSwapchain();
+    if (vulkanContext.supportsPresentWait()) {
+        waitForPresentFn = reinterpret_cast<PFN_vkWaitForPresentKHR>(
+            vkGetDeviceProcAddr(vulkanContext.getDevice(), "vkWaitForPresentKHR"));
+    }
+
+    createSwapchain(VK_NULL_HANDLE);
     createImageViews();
 
     std::cout << "[Swapchain] Ready with " << swapchainImages.size()
-              << " images, format " << static_cast<int>(swapchainImageFormat) << ".\n";
+              << " images, format " << static_cast<int>(swapchainImageFormat)
+              << ", present mode " << presentModeName(presentMode)
+              << (storageUsage ? " (storage, direct compute output)" : "")
+              << (waitForPresentFn ? ", present wait" : "") << ".\n";
 }
 
 Swapchain::~Swapchain() { cleanup(); }
@@ -63,7 +92,24 @@ void Swapchain::cleanup() {
     }
 }
 
-VkSurfaceFormatKHR Swapchain::chooseSwapSurfaceFormat(const std::vector<VkSurfaceFormatKHR>& formats) {
+bool Swapchain::formatSupportsStorage(VkFormat format) const {
+    VkFormatProperties props{};
+    vkGetPhysicalDeviceFormatProperties(vulkanContext.getPhysicalDevice(), format, &props);
+    return (props.optimalTilingFeatures & VK_FORMAT_FEATURE_STORAGE_IMAGE_BIT) != 0;
+}
+
+VkSurfaceFormatKHR Swapchain::chooseSwapSurfaceFormat(const std::vector<VkSurfaceFormatKHR>& formats, bool wantStorage) {
+    // SRGB formats can't be storage images; the shader encodes to sRGB itself in that mode
+    if (wantStorage) {
+        for (VkFormat preferred : { VK_FORMAT_B8G8R8A8_UNORM, VK_FORMAT_R8G8B8A8_UNORM }) {
+            for (const auto& f : formats) {
+                if (f.format == preferred && f.colorSpace == VK_COLOR_SPACE_SRGB_NONLINEAR_KHR
+                    && formatSupportsStorage(f.format)) {
+                    return f;
+                }
+            }
+        }
+    }
     for (const auto& f : formats) {
         if (f.format == VK_FORMAT_B8G8R8A8_SRGB && f.colorSpace == VK_COLOR_SPACE_SRGB_NONLINEAR_KHR) {
             return f;
@@ -73,7 +119,12 @@ VkSurfaceFormatKHR Swapchain::chooseSwapSurfaceFormat(const std::vector<VkSurfac
 }
 
 VkPresentModeKHR Swapchain::chooseSwapPresentMode(const std::vector<VkPresentModeKHR>& modes) {
-    for (const auto& m : modes) if (m == VK_PRESENT_MODE_MAILBOX_KHR) return m;
+    // FIFO is always supported
+    if (std::find(modes.begin(), modes.end(), requestedPresentMode) != modes.end()) return requestedPresentMode;
+    if (generation == 0) {
+        std::cerr << "[Swapchain] Warning: present mode " << presentModeName(requestedPresentMode)
+                  << " not supported; using fifo.\n";
+    }
     return VK_PRESENT_MODE_FIFO_KHR;
 }
 
@@ -90,7 +141,7 @@ VkExtent2D Swapchain::chooseSwapExtent(const VkSurfaceCapabilitiesKHR& capabilit
     }
 }
 
-void Swapchain::createSwapchain() {
+void Swapchain::createSwapchain(VkSwapchainKHR oldSwapchain) {
     VkPhysicalDevice pd = vulkanContext.getPhysicalDevice();
     VkDevice         device = vulkanContext.getDevice();
 
@@ -109,8 +160,17 @@ void Swapchain::createSwapchain() {
     std::vector<VkPresentModeKHR> presentModes(presentModeCount);
     vkGetPhysicalDeviceSurfacePresentModesKHR(pd, surface, &presentModeCount, presentModes.data());
 
-    VkSurfaceFormatKHR surfaceFormat = chooseSwapSurfaceFormat(formats);
-    VkPresentModeKHR presentMode = chooseSwapPresentMode(presentModes);
+    // Direct compute output needs STORAGE on the surface, a storage-capable UNORM format,
+    // and format-less storage writes in the shader (BGRA vs the shader's RGBA layout).
+    const bool wantStorage = allowStorageUsage
+        && (capabilities.supportedUsageFlags & VK_IMAGE_USAGE_STORAGE_BIT) != 0
+        && vulkanContext.supportsStorageWriteWithoutFormat();
+
+    VkSurfaceFormatKHR surfaceFormat = chooseSwapSurfaceFormat(formats, wantStorage);
+    storageUsage = wantStorage
+        && (surfaceFormat.format == VK_FORMAT_B8G8R8A8_UNORM || surfaceFormat.format == VK_FORMAT_R8G8B8A8_UNORM)
+        && formatSupportsStorage(surfaceFormat.format);
+    presentMode = chooseSwapPresentMode(presentModes);
     VkExtent2D extent = chooseSwapExtent(capabilities);
 
     uint32_t imageCount = capabilities.minImageCount + 1;
@@ -126,8 +186,9 @@ void Swapchain::createSwapchain() {
     ci.imageColorSpace = surfaceFormat.colorSpace;
     ci.imageExtent = extent;
     ci.imageArrayLayers = 1;
-    // No STORAGE bit here; we blit from our offscreen storage image
+    // STORAGE only when the compute pass can write us directly; TRANSFER_DST keeps the blit fallback
     ci.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+    if (storageUsage) ci.imageUsage |= VK_IMAGE_USAGE_STORAGE_BIT;
 
     uint32_t graphicsFamily = vulkanContext.getGraphicsQueueFamily();
     uint32_t presentFamily  = vulkanContext.getPresentQueueFamily();
@@ -151,7 +212,7 @@ void Swapchain::createSwapchain() {
     ci.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
     ci.presentMode = presentMode;
     ci.clipped = VK_TRUE;
-    ci.oldSwapchain = VK_NULL_HANDLE;
+    ci.oldSwapchain = oldSwapchain;   // lets the driver reuse its resources; retired either way
 
     if (vkCreateSwapchainKHR(device, &ci, nullptr, &swapchain) != VK_SUCCESS) {
         throw std::runtime_error("[Swapchain] Failed to create swapchain.");
@@ -164,6 +225,7 @@ void Swapchain::createSwapchain() {
 
     swapchainImageFormat = surfaceFormat.format;
     swapchainExtent = extent;
+    firstChainId = lastPresentId + 1;
 }
 
 void Swapchain::createImageViews() {
@@ -181,10 +243,22 @@ void Swapchain::recreate() {
         glfwWaitEvents();
     } while (w == 0 || h == 0);
 
-    vkDeviceWaitIdle(vulkanContext.getDevice());
-    cleanup();
-    createSwapchain();
+    // Frames still in flight keep using the old images and views; their presents have no
+    // completion signal without VK_EXT_swapchain_maintenance1, so the old chain waits out a
+    // full ring of frames after the GPU passes their submissions
+    VkSwapchainKHR           oldSwapchain = swapchain;
+    std::vector<VkImageView> oldViews     = std::move(swapchainImageViews);
+    swapchain = VK_NULL_HANDLE;
+    swapchainImageViews.clear();
+
+    createSwapchain(oldSwapchain);
     createImageViews();
+    ++generation;
+
+    scheduler.deferDestroy([device = vulkanContext.getDevice(), oldSwapchain, oldViews]() {
+        for (VkImageView view : oldViews) vkDestroyImageView(device, view, nullptr);
+        vkDestroySwapchainKHR(device, oldSwapchain, nullptr);
+    }, scheduler.getFramesInFlight());
 
     std::cout << "[Swapchain] Recreated at " << swapchainExtent.width << "x" << swapchainExtent.height << ".\n";
 }
@@ -229,7 +303,17 @@ void Swapchain::present(uint32_t imageIndex, VkSemaphore waitSemaphore) {
     pi.pSwapchains = &swapchain;
     pi.pImageIndices = &imageIndex;
 
+    // Ids only have to increase per swapchain; one counter keeps them unique across chains
+    VkPresentIdKHR presentId{ VK_STRUCTURE_TYPE_PRESENT_ID_KHR };
+    const uint64_t id = lastPresentId + 1;
+    if (waitForPresentFn) {
+        presentId.swapchainCount = 1;
+        presentId.pPresentIds = &id;
+        pi.pNext = &presentId;
+    }
+
     VkResult res = vkQueuePresentKHR(vulkanContext.getPresentQueue(), &pi);
+    if (waitForPresentFn) lastPresentId = id;
 
     if (res == VK_ERROR_OUT_OF_DATE_KHR || res == VK_SUBOPTIMAL_KHR) {
         recreate();
@@ -239,3 +323,14 @@ void Swapchain::present(uint32_t imageIndex, VkSemaphore waitSemaphore) {
         throw std::runtime_error("[Swapchain] Failed to present swapchain image.");
     }
 }
+
+bool Swapchain::waitForPresent(uint64_t presentId, uint64_t timeoutNs) {
+    if (!waitForPresentFn || presentId < firstChainId) return true;
+    const VkResult res = waitForPresentFn(vulkanContext.getDevice(), swapchain, presentId, timeoutNs);
+    if (res == VK_TIMEOUT) return false;
+    // Out of date or suboptimal: present() recreates on its next call, nothing to wait for
+    if (res != VK_SUCCESS && res != VK_ERROR_OUT_OF_DATE_KHR && res != VK_SUBOPTIMAL_KHR) {
+        throw std::runtime_error("[Swapchain] Failed waiting for present.");
+    }
+    return true;
+}
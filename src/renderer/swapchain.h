@@ -1,52 +1,88 @@
 #pragma once
 
 #include <vulkan/vulkan.h>
+#include <string>
 #include <vector>
 
+#include "render_target.h"
+
 class VulkanContext;
 class Window;
+class FrameScheduler;
+
+const char* presentModeName(VkPresentModeKHR mode);                  // immediate|mailbox|fifo|fifo-relaxed
+bool        parsePresentMode(const std::string& name, VkPresentModeKHR& mode);
+
+struct SwapchainOptions {
+    bool             allowStorage = true;                          // direct compute output when possible
+    VkPresentModeKHR presentMode  = VK_PRESENT_MODE_MAILBOX_KHR;   // falls back to FIFO when unsupported
+};
 
 /**
  * Swapchain
  * =========
  * Responsible for creating and managing the Vulkan swapchain and its images/views.
  * Supports presentation, window resize handling, and compute shader writes via STORAGE usage.
+ *
+ * With allowStorage, a UNORM format whose optimal tiling supports storage writes is
+ * preferred and the images get STORAGE usage, so the compute pass can write them directly.
+ * Otherwise (or if the surface can't do it) the usual SRGB format is used and we blit.
+ *
+ * recreate() never idles the device: the current chain is handed to the new one as
+ * oldSwapchain, and it and its views are destroyed through the scheduler once the frames
+ * that may still present its images are done. getGeneration() tells users to follow.
+ *
+ * With VK_KHR_present_id / VK_KHR_present_wait every present carries an increasing id,
+ * and waitForPresent() blocks until one is on screen (PresentPacer builds on that).
  */
-class Swapchain {
+class Swapchain : public RenderTarget {
 public:
-    Swapchain(VulkanContext& context, Window& window);
-    ~Swapchain();
+    Swapchain(VulkanContext& context, Window& window, FrameScheduler& scheduler, const SwapchainOptions& options = {});
+    ~Swapchain() override;
 
     // Non-copyable
     Swapchain(const Swapchain&) = delete;
     Swapchain& operator=(const Swapchain&) = delete;
 
     // --- Core lifecycle ---
-    void     recreate();   // Recreate on window resize
+    void     recreate();   // Recreate on window resize (or out-of-date), retiring the old chain
     uint32_t acquireNextImage(VkSemaphore semaphore);   // Acquire next image index
     void     present(uint32_t imageIndex, VkSemaphore waitSemaphore); // Present to screen
 
+    // --- Present pacing (VK_KHR_present_wait) ---
+    bool     supportsPresentWait() const { return waitForPresentFn != nullptr; }
+    uint64_t getLastPresentId()    const { return lastPresentId; }   // 0 before the first present
+    // Blocks until presentId (from getLastPresentId()) is displayed or timeoutNs passed.
+    // Ids presented on a chain since replaced count as done. False on timeout.
+    bool     waitForPresent(uint64_t presentId, uint64_t timeoutNs);
+    VkPresentModeKHR getPresentMode() const { return presentMode; }
+
     // --- Accessors ---
-    VkFormat   getImageFormat() const { return swapchainImageFormat; }
-    VkExtent2D getExtent()     const { return swapchainExtent; }
-    size_t     getImageCount() const { return swapchainImages.size(); }
+    VkFormat      getImageFormat()  const override { return swapchainImageFormat; }
+    VkExtent2D    getExtent()       const override { return swapchainExtent; }
+    size_t        getImageCount()   const override { return swapchainImages.size(); }
+    bool          hasStorageUsage() const override { return storageUsage; }
+    VkImageLayout getFinalLayout()  const override { return VK_IMAGE_LAYOUT_PRESENT_SRC_KHR; }
 
-    VkImageView getImageView(size_t index) const { return swapchainImageViews[index]; }
-    VkImage     getImage(size_t index)     const { return swapchainImages[index]; }
+    VkImageView getImageView(size_t index) const override { return swapchainImageViews[index]; }
+    VkImage     getImage(size_t index)     const override { return swapchainImages[index]; }
+    uint64_t    getGeneration()            const override { return generation; }
 
 private:
     // --- Internal creation helpers ---
-    void createSwapchain();
+    void createSwapchain(VkSwapchainKHR oldSwapchain);
     void createImageViews();
     void cleanup();
 
-    VkSurfaceFormatKHR chooseSwapSurfaceFormat(const std::vector<VkSurfaceFormatKHR>& formats);
+    VkSurfaceFormatKHR chooseSwapSurfaceFormat(const std::vector<VkSurfaceFormatKHR>& formats, bool wantStorage);
+    bool               formatSupportsStorage(VkFormat format) const;
     VkPresentModeKHR   chooseSwapPresentMode(const std::vector<VkPresentModeKHR>& modes);
     VkExtent2D         chooseSwapExtent(const VkSurfaceCapabilitiesKHR& capabilities);
 
 private:
     VulkanContext&  vulkanContext;
     Window&         windowRef;
+    FrameScheduler& scheduler;
     VkSurfaceKHR    surface = VK_NULL_HANDLE;
 
     VkSwapchainKHR             swapchain = VK_NULL_HANDLE;
@@ -54,4 +90,13 @@ private:
     std::vector<VkImageView>   swapchainImageViews;
     VkFormat                   swapchainImageFormat = VK_FORMAT_B8G8R8A8_SRGB;
     VkExtent2D                 swapchainExtent{0, 0};
+    bool                       allowStorageUsage = true;
+    VkPresentModeKHR           requestedPresentMode = VK_PRESENT_MODE_MAILBOX_KHR;
+    VkPresentModeKHR           presentMode = VK_PRESENT_MODE_FIFO_KHR;   // in use
+    bool                       storageUsage = false;   // images created with STORAGE usage
+    uint64_t                   generation = 0;         // recreations so far
+
+    PFN_vkWaitForPresentKHR    waitForPresentFn = nullptr;   // null without present_wait
+    uint64_t                   lastPresentId  = 0;          // increasing across recreations
+    uint64_t                   firstChainId   = 1;          // first id presented on the current chain
 };
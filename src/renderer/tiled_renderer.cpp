@@ -0,0 +1,279 @@
+#include "tiled_renderer.h"
+#include "vulkan_context.h"
+#include "frame_scheduler.h"
+#include "offscreen_target.h"
+#include "frame_readback.h"
+#include "../core/image_io.h"
+
+#include <stdexcept>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+#include <filesystem>
+#include <thread>
+
+TiledRenderer::Device::Device(VulkanContext& context, uint32_t framesInFlight, VkExtent2D tileExtent,
+                              const std::string& shaderSpvPath, const ComputePipelineOptions& options)
+    : ctx(context) {
+    scheduler = std::make_unique<FrameScheduler>(ctx, framesInFlight);
+    target    = std::make_unique<OffscreenTarget>(ctx, tileExtent, framesInFlight);
+    compute   = std::make_unique<ComputePipeline>(ctx, *target, *scheduler, shaderSpvPath, options);
+
+    VkSemaphoreCreateInfo sci{ VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO };
+    tracedSems.resize(framesInFlight, VK_NULL_HANDLE);
+    for (auto& sem : tracedSems) {
+        if (vkCreateSemaphore(ctx.getDevice(), &sci, nullptr, &sem) != VK_SUCCESS) {
+            throw std::runtime_error("[Tiled] Failed to create semaphore.");
+        }
+    }
+}
+
+TiledRenderer::Device::~Device() {
+    scheduler->waitIdle();
+    for (auto sem : tracedSems) {
+        if (sem) vkDestroySemaphore(ctx.getDevice(), sem, nullptr);
+    }
+}
+
+TiledRenderer::TiledRenderer(const std::vector<VulkanContext*>& contexts, uint32_t framesInFlight,
+                             const std::string& shaderSpvPath, ComputePipelineOptions options,
+                             const TiledRenderSettings& tiledSettings)
+    : settings(tiledSettings) {
+
+    if (contexts.empty()) throw std::runtime_error("[Tiled] Needs at least one Vulkan context.");
+    if (settings.imageSize.width == 0 || settings.imageSize.height == 0) {
+        throw std::runtime_error("[Tiled] Image size must be non-zero.");
+    }
+    settings.tileSize = std::clamp(settings.tileSize, 16u, 4096u);
+    tilesX = (settings.imageSize.width  + settings.tileSize - 1) / settings.tileSize;
+    tilesY = (settings.imageSize.height + settings.tileSize - 1) / settings.tileSize;
+
+    // A still has no history to accumulate into and a fixed quality target
+    options.temporalAccumulation = false;
+    options.dynamicResolution = false;
+
+    pipelineOptions = options;
+    tileExtent = { std::min(settings.tileSize, settings.imageSize.width),
+                   std::min(settings.tileSize, settings.imageSize.height) };
+    for (VulkanContext* context : contexts) {
+        devices.push_back(std::make_unique<Device>(*context, framesInFlight, tileExtent, shaderSpvPath, options));
+    }
+
+    std::cout << "[Tiled] " << settings.imageSize.width << "x" << settings.imageSize.height << " in "
+              << tilesX << "x" << tilesY << " tiles of " << settings.tileSize << " px on "
+              << devices.size() << " GPU(s).\n";
+}
+
+// Devices wait for their own queues before releasing anything
+TiledRenderer::~TiledRenderer() = default;
+
+std::vector<uint32_t> TiledRenderer::progressiveOrder(uint32_t tilesX, uint32_t tilesY) {
+    uint32_t step = 1;
+    while (step * 2 < std::max(tilesX, tilesY)) step *= 2;
+
+    std::vector<uint32_t> order;
+    order.reserve(static_cast<size_t>(tilesX) * tilesY);
+    std::vector<uint8_t> emitted(static_cast<size_t>(tilesX) * tilesY, 0);
+
+    // Each level fills the lattice points the coarser levels skipped
+    for (; step >= 1; step /= 2) {
+        for (uint32_t y = 0; y < tilesY; y += step) {
+            for (uint32_t x = 0; x < tilesX; x += step) {
+                const uint32_t index = y * tilesX + x;
+                if (!emitted[index]) { emitted[index] = 1; order.push_back(index); }
+            }
+        }
+        if (step == 1) break;
+    }
+    return order;
+}
+
+VkRect2D TiledRenderer::tileRect(uint32_t index) const {
+    const uint32_t x = (index % tilesX) * settings.tileSize;
+    const uint32_t y = (index / tilesX) * settings.tileSize;
+    VkRect2D r{};
+    r.offset = { static_cast<int32_t>(x), static_cast<int32_t>(y) };
+    r.extent = { std::min(settings.tileSize, settings.imageSize.width  - x),
+                 std::min(settings.tileSize, settings.imageSize.height - y) };
+    return r;
+}
+
+std::string TiledRenderer::progressHeader(const CameraData& camera) const {
+    // Everything that changes a tile's pixels: image and tile geometry, camera, the trace
+    // variant, integrator, metric, sampling and baked-texture options and the scene.
+    // 9 significant digits round-trip a float, so a resumed run compares exactly.
+    const ComputePipelineOptions& o = pipelineOptions;
+    const TraceVariant& v = o.variant;
+    const SceneParams& s = o.scene;
+    std::ostringstream out;
+    out << std::setprecision(9)
+        << "gargantua-tiles 2 " << settings.imageSize.width << " " << settings.imageSize.height << " "
+        << settings.tileSize << " " << camera.x << " " << camera.y << " " << camera.zoom << " " << camera.time
+        << " variant " << v.samplesPerAxis << " " << v.maxSteps << " " << v.stepSize << " " << v.diskSteps << " "
+        << v.disk << v.glow << v.photonRing << " " << static_cast<int>(v.debugView)
+        << " geodesic " << static_cast<int>(o.integrator) << " " << o.integratorTolerance << " "
+        << static_cast<int>(o.metric) << " " << o.spin << " " << o.farFieldRadius << " " << o.deflectionLut
+        << " sampling " << o.blockClassification << o.adaptiveSampling << " " << o.adaptiveThreshold
+        << " shading " << o.skyFaceSize << " " << o.diskTextures << o.halfShading << o.wavefront
+        << " scene " << s.exposure << " " << s.gamma << " " << s.saturation << " " << s.contrast << " "
+        << s.diskSpeed << " " << s.diskBrightness << " " << s.focalLength << " " << s.pitch << " " << s.orbitRate;
+    return out.str();
+}
+
+bool TiledRenderer::loadCheckpoint() {
+    const std::string progressPath = settings.outputPath + ".progress";
+    std::ifstream file(progressPath);
+    if (!file) return false;
+
+    std::string line;
+    if (!std::getline(file, line) || line != header) {
+        std::cerr << "[Tiled] Warning: " << progressPath << " is for different settings or camera; starting over.\n";
+        return false;
+    }
+
+    std::vector<uint8_t> rgb;
+    uint32_t w = 0, h = 0;
+    if (!image_io::readPpm(settings.outputPath, rgb, w, h)
+        || w != settings.imageSize.width || h != settings.imageSize.height) {
+        std::cerr << "[Tiled] Warning: partial image " << settings.outputPath << " unreadable; starting over.\n";
+        return false;
+    }
+
+    std::vector<uint8_t> finished(getTileCount(), 0);
+    uint32_t count = 0;
+    uint32_t index = 0;
+    while (file >> index) {
+        if (index < finished.size() && !finished[index]) { finished[index] = 1; ++count; }
+    }
+
+    image = std::move(rgb);
+    done = std::move(finished);
+    doneCount = count;
+    return true;
+}
+
+void TiledRenderer::writeCheckpoint(bool final) {
+    image_io::writePpm(settings.outputPath, image.data(), settings.imageSize.width, settings.imageSize.height);
+
+    const std::string progressPath = settings.outputPath + ".progress";
+    if (final) {
+        std::error_code ec;
+        std::filesystem::remove(progressPath, ec);
+        return;
+    }
+
+    // Written after the image: a crash in between leaves an older tile list, never a newer one
+    const std::string tmp = progressPath + ".tmp";
+    {
+        std::ofstream file(tmp, std::ios::trunc);
+        if (!file) throw std::runtime_error("[Tiled] Failed to write " + tmp);
+        file << header << "\n";
+        for (uint32_t i = 0; i < done.size(); ++i) {
+            if (done[i]) file << i << "\n";
+        }
+        if (!file) throw std::runtime_error("[Tiled] Failed to write " + tmp);
+    }
+    std::error_code ec;
+    std::filesystem::rename(tmp, progressPath, ec);
+    if (ec) throw std::runtime_error("[Tiled] Failed to move " + tmp + " to " + progressPath);
+}
+
+void TiledRenderer::stitch(const uint8_t* rgba, uint32_t tileIndex) {
+    std::lock_guard<std::mutex> lock(stitchMutex);
+    const VkRect2D r = tileRect(tileIndex);
+    const uint32_t srcPitch = tileExtent.width;
+
+    for (uint32_t row = 0; row < r.extent.height; ++row) {
+        const uint8_t* src = rgba + static_cast<size_t>(row) * srcPitch * OffscreenTarget::kBytesPerPixel;
+        uint8_t* dst = image.data()
+            + ((static_cast<size_t>(r.offset.y) + row) * settings.imageSize.width + r.offset.x) * 3;
+        image_io::rgbaToRgb(src, dst, r.extent.width);
+    }
+
+    if (!done[tileIndex]) { done[tileIndex] = 1; ++doneCount; ++stitchedThisRun; }
+
+    const auto now = std::chrono::steady_clock::now();
+    if (stitchedThisRun % 32 == 0 || doneCount == getTileCount()) {
+        const std::chrono::duration<float> elapsed = now - start;
+        const float eta = elapsed.count() / static_cast<float>(stitchedThisRun)
+                        * static_cast<float>(getTileCount() - doneCount);
+        std::cout << "[Tiled] " << doneCount << "/" << getTileCount() << " tiles, ~"
+                  << static_cast<int>(eta) << " s left\n";
+    }
+    if (std::chrono::duration<float>(now - lastCheckpoint).count() >= settings.checkpointSeconds
+        && doneCount < getTileCount()) {
+        writeCheckpoint(false);
+        lastCheckpoint = now;
+        std::cout << "[Tiled] Checkpoint: " << doneCount << "/" << getTileCount() << " tiles\n";
+    }
+}
+
+void TiledRenderer::traceTiles(Device& device, const std::vector<uint32_t>& order, const CameraData& camera) {
+    FrameReadback readback(device.ctx, *device.scheduler, tileExtent, settings.ringSize,
+                           [this](const uint8_t* rgba, uint32_t tileIndex) { stitch(rgba, tileIndex); });
+
+    // Dynamic distribution: each GPU takes the next tile in progressive order when it has a free slot
+    for (size_t n = nextTile++; n < order.size() && !aborted; n = nextTile++) {
+        const uint32_t slot = device.scheduler->beginFrame();
+
+        device.compute->setTile(tileRect(order[n]), settings.imageSize);
+        device.compute->dispatch(slot, VK_NULL_HANDLE, device.tracedSems[slot], camera);
+        readback.capture(device.target->getImage(slot), device.tracedSems[slot], order[n]);
+
+        device.scheduler->endFrame();
+        ++device.tilesTraced;
+    }
+    readback.flush();
+    device.compute->clearTile();
+}
+
+void TiledRenderer::render(const CameraData& camera) {
+    header = progressHeader(camera);
+    if (!(settings.resume && loadCheckpoint())) {
+        image.assign(static_cast<size_t>(settings.imageSize.width) * settings.imageSize.height * 3, 0);
+        done.assign(getTileCount(), 0);
+        doneCount = 0;
+    } else {
+        std::cout << "[Tiled] Resuming: " << doneCount << "/" << getTileCount() << " tiles already done\n";
+    }
+
+    std::vector<uint32_t> order = progressiveOrder(tilesX, tilesY);
+    order.erase(std::remove_if(order.begin(), order.end(), [this](uint32_t i) { return done[i] != 0; }),
+                order.end());
+
+    start = std::chrono::steady_clock::now();
+    lastCheckpoint = start;
+    stitchedThisRun = 0;
+    nextTile = 0;
+    aborted = false;
+    error.clear();
+
+    // One host thread per GPU; each context is only ever used from its own thread
+    std::vector<std::thread> threads;
+    for (auto& device : devices) {
+        device->tilesTraced = 0;
+        threads.emplace_back([this, &device, &order, &camera] {
+            try {
+                traceTiles(*device, order, camera);
+            } catch (const std::exception& e) {
+                std::lock_guard<std::mutex> lock(stitchMutex);
+                if (error.empty()) error = e.what();
+                aborted = true;
+            }
+        });
+    }
+    for (auto& t : threads) t.join();
+    if (!error.empty()) throw std::runtime_error(error);
+
+    writeCheckpoint(true);
+    const std::chrono::duration<float> elapsed = std::chrono::steady_clock::now() - start;
+    std::cout << "[Tiled] Wrote " << settings.outputPath << " in " << elapsed.count() << " s";
+    if (devices.size() > 1) {
+        std::cout << " (tiles per GPU:";
+        for (const auto& device : devices) std::cout << " " << device->tilesTraced;
+        std::cout << ")";
+    }
+    std::cout << "\n";
+}
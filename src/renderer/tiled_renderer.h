@@ -0,0 +1,106 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "compute_pipeline.h"
+
+class VulkanContext;
+class FrameScheduler;
+class OffscreenTarget;
+
+struct TiledRenderSettings {
+    VkExtent2D  imageSize{ 7680, 4320 };
+    uint32_t    tileSize          = 512;     // edge of a square tile; one submission each
+    uint32_t    ringSize          = 4;       // readback buffers in flight to the stitcher
+    std::string outputPath        = "gargantua_still.ppm";
+    float       checkpointSeconds = 30.0f;   // partial image + progress file cadence
+    bool        resume            = true;    // continue from a matching <outputPath>.progress
+};
+
+/**
+ * TiledRenderer
+ * =============
+ * Poster-size stills on a tile-sized target. Each tile is its own submission (short
+ * enough to stay clear of driver watchdogs), traced with ComputePipeline::setTile so rays
+ * match an untiled render, then streamed through FrameReadback into a host-side image.
+ *
+ * Tiles go in progressive order: a coarse, evenly spread subset first, then the gaps, so
+ * an early checkpoint already shows the whole composition. Checkpoints write the partial
+ * image and <outputPath>.progress (settings, camera, finished tiles); a later run with the
+ * same settings and camera loads both and renders only the missing tiles.
+ *
+ * With several contexts (one per GPU) every device gets its own scheduler, target and
+ * pipeline and a host thread that pulls the next tile from the shared progressive order,
+ * so faster GPUs and cheaper tiles balance out; all results stitch into one image.
+ */
+class TiledRenderer {
+public:
+    // Temporal accumulation and dynamic resolution are turned off (single-shot stills).
+    // Contexts must outlive the renderer.
+    TiledRenderer(const std::vector<VulkanContext*>& contexts, uint32_t framesInFlight,
+                  const std::string& shaderSpvPath, ComputePipelineOptions options,
+                  const TiledRenderSettings& settings);
+    ~TiledRenderer();
+
+    TiledRenderer(const TiledRenderer&) = delete;
+    TiledRenderer& operator=(const TiledRenderer&) = delete;
+
+    // Renders every unfinished tile and writes the final image (removing the progress file)
+    void render(const CameraData& camera);
+
+    uint32_t getTileCount() const { return tilesX * tilesY; }
+
+    // Quadtree order over a tilesX x tilesY grid: tiles on a 2^k lattice before 2^(k-1)
+    static std::vector<uint32_t> progressiveOrder(uint32_t tilesX, uint32_t tilesY);
+
+private:
+    // Everything one GPU needs; members are destroyed bottom-up, the scheduler last
+    struct Device {
+        Device(VulkanContext& context, uint32_t framesInFlight, VkExtent2D tileExtent,
+               const std::string& shaderSpvPath, const ComputePipelineOptions& options);
+        ~Device();
+
+        VulkanContext&                   ctx;
+        std::unique_ptr<FrameScheduler>  scheduler;
+        std::unique_ptr<OffscreenTarget> target;    // one tile per frame slot
+        std::unique_ptr<ComputePipeline> compute;
+        std::vector<VkSemaphore>         tracedSems;
+        uint32_t                         tilesTraced = 0;
+    };
+
+    void     traceTiles(Device& device, const std::vector<uint32_t>& order, const CameraData& camera);   // per-GPU thread
+    VkRect2D tileRect(uint32_t index) const;
+    void     stitch(const uint8_t* rgba, uint32_t tileIndex);        // readback writer threads
+    void     writeCheckpoint(bool final);
+    bool     loadCheckpoint();                                        // matches header
+    std::string progressHeader(const CameraData& camera) const;
+
+    TiledRenderSettings              settings;
+    ComputePipelineOptions           pipelineOptions;   // as the devices were built (progress header)
+    uint32_t                         tilesX = 0;
+    uint32_t                         tilesY = 0;
+    VkExtent2D                       tileExtent{0, 0};
+
+    std::vector<std::unique_ptr<Device>> devices;
+
+    // Work distribution while render() runs
+    std::atomic<size_t>              nextTile{0};
+    std::atomic<bool>                aborted{false};
+
+    // Guarded by stitchMutex while render() runs (the writer threads of every device)
+    std::mutex                       stitchMutex;
+    std::vector<uint8_t>             image;     // RGB, imageSize
+    std::vector<uint8_t>             done;      // per tile
+    uint32_t                         doneCount = 0;
+    uint32_t                         stitchedThisRun = 0;
+    std::string                      header;
+    std::string                      error;     // first failure of any device thread
+    std::chrono::steady_clock::time_point start{};
+    std::chrono::steady_clock::time_point lastCheckpoint{};
+};
@@ -1,11 +1,13 @@
 #include "vulkan_context.h"
+#include "pipeline_cache.h"
+#include "gpu_memory.h"
 
 #include <vector>
 #include <string>
 #include <iostream>
 #include <stdexcept>
 #include <cstring>
-#include <optional>
+#include <utility>
 #include <algorithm>
 
 #define GLFW_INCLUDE_VULKAN
@@ -59,16 +61,24 @@ namespace {
 
 // ---------- Ctor / Dtor ----------
 
-VulkanContext::VulkanContext(bool enableValidation, VkSurfaceKHR surf) {
+VulkanContext::VulkanContext(bool enableValidation, VkSurfaceKHR surf, bool headlessDevice, int gpuIndex) {
 #ifdef _DEBUG
     validationEnabled = enableValidation;
 #else
     validationEnabled = false;
 #endif
+    headless = headlessDevice;
+    deviceIndex = gpuIndex;
 
     createInstance();
 
-    if (surf != VK_NULL_HANDLE) {
+    if (headless) {
+        if (surf != VK_NULL_HANDLE)
+            throw std::runtime_error("[Vulkan] Headless context cannot take a surface.");
+        selectPhysicalDevice();
+        createLogicalDevice();
+        createCommandPools();
+    } else if (surf != VK_NULL_HANDLE) {
         initializeForSurface(surf);
     } else {
         std::cout << "[Vulkan] Instance ready. Waiting for surface to finish device init...\n";
@@ -83,6 +93,8 @@ VulkanContext::~VulkanContext() noexcept {
 
 void VulkanContext::initializeForSurface(VkSurfaceKHR surf) {
     if (initializedForSurface) return;
+    if (headless)
+        throw std::runtime_error("[Vulkan] initializeForSurface called on a headless context.");
     if (surf == VK_NULL_HANDLE)
         throw std::runtime_error("[Vulkan] initializeForSurface called with null surface.");
 
@@ -94,6 +106,10 @@ void VulkanContext::initializeForSurface(VkSurfaceKHR surf) {
     initializedForSurface = true;
 }
 
+VkPipelineCache VulkanContext::getPipelineCache() const {
+    return pipelineCache ? pipelineCache->get() : VK_NULL_HANDLE;
+}
+
 // ---------- Teardown ----------
 
 void VulkanContext::shutdown() noexcept {
@@ -101,6 +117,9 @@ void VulkanContext::shutdown() noexcept {
     if (device != VK_NULL_HANDLE) {
         // vkDeviceWaitIdle(device); // optional, enable if needed.
 
+        pipelineCache.reset();
+        memory.reset();
+
         if (graphicsCmdPool != VK_NULL_HANDLE) {
             vkDestroyCommandPool(device, graphicsCmdPool, nullptr);
             graphicsCmdPool = VK_NULL_HANDLE;
@@ -166,14 +185,17 @@ void VulkanContext::createInstance() {
     appInfo.engineVersion = VK_MAKE_VERSION(1, 0, 0);
     appInfo.apiVersion = VK_API_VERSION_1_3;
 
-    // Ask GLFW for required instance extensions (surface + platform)
-    uint32_t glfwExtCount = 0;
-    const char** glfwExts = glfwGetRequiredInstanceExtensions(&glfwExtCount);
-    if (!glfwExts || glfwExtCount == 0) {
-        throw std::runtime_error("[Vulkan] GLFW did not provide required instance extensions.");
+    // Ask GLFW for required instance extensions (surface + platform).
+    // Headless nodes may have no window system at all, so GLFW is never touched there.
+    std::vector<const char*> exts;
+    if (!headless) {
+        uint32_t glfwExtCount = 0;
+        const char** glfwExts = glfwGetRequiredInstanceExtensions(&glfwExtCount);
+        if (!glfwExts || glfwExtCount == 0) {
+            throw std::runtime_error("[Vulkan] GLFW did not provide required instance extensions.");
+        }
+        exts.assign(glfwExts, glfwExts + glfwExtCount);
     }
-
-    std::vector<const char*> exts(glfwExts, glfwExts + glfwExtCount);
 #ifdef _DEBUG
     exts.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
 #endif
@@ -196,11 +218,12 @@ void VulkanContext::createInstance() {
 }
 
 void VulkanContext::selectPhysicalDevice() {
-    if (surface == VK_NULL_HANDLE) {
+    if (surface == VK_NULL_HANDLE && !headless) {
         throw std::runtime_error("[Vulkan] selectPhysicalDevice called without surface.");
     }
 
-    std::cout << "[Vulkan] Selecting physical device (with surface support)...\n";
+    std::cout << "[Vulkan] Selecting physical device"
+              << (headless ? " (headless)" : " (with surface support)") << "...\n";
 
     uint32_t count = 0;
     vkEnumeratePhysicalDevices(instance, &count, nullptr);
@@ -215,37 +238,57 @@ void VulkanContext::selectPhysicalDevice() {
         printPhysicalDeviceInfo(pd);
     }
 
-    std::optional<VkPhysicalDevice> best;
-    int bestScore = -1;
+    // Suitable devices, best first; deviceIndex picks among them (multi-GPU offline renders)
+    std::vector<std::pair<int, VkPhysicalDevice>> ranked;
 
     for (const auto& pd : devices) {
         if (!deviceHasCompute(pd)) continue;
 
-        // Must also support presenting to our surface from *some* queue
+        // Must also support presenting to our surface from *some* queue (unless headless)
         uint32_t qCount = 0;
         vkGetPhysicalDeviceQueueFamilyProperties(pd, &qCount, nullptr);
-        std::vector<VkQueueFamilyProperties> qProps(qCount);
-        vkGetPhysicalDeviceQueueFamilyProperties(pd, &qCount, qProps.data());
 
-        bool anyPresent = false;
-        for (uint32_t i = 0; i < qCount; ++i) {
-            if (queueFamilySupportsPresent(pd, i, surface)) { anyPresent = true; break; }
+        bool anyPresent = headless;
+        for (uint32_t i = 0; i < qCount && !anyPresent; ++i) {
+            if (queueFamilySupportsPresent(pd, i, surface)) anyPresent = true;
         }
         if (!anyPresent) continue;
 
-        int score = devicePreferenceScore(pd);
-        if (score > bestScore) { bestScore = score; best = pd; }
+        ranked.emplace_back(devicePreferenceScore(pd), pd);
     }
 
-    if (!best.has_value()) {
-        throw std::runtime_error("[Vulkan] No suitable GPU with compute + present support.");
+    // Software rasterizers only count when there is nothing else
+    const bool anyHardware = std::any_of(ranked.begin(), ranked.end(), [](const auto& r) {
+        VkPhysicalDeviceProperties p{};
+        vkGetPhysicalDeviceProperties(r.second, &p);
+        return p.deviceType != VK_PHYSICAL_DEVICE_TYPE_CPU;
+    });
+    if (anyHardware) {
+        ranked.erase(std::remove_if(ranked.begin(), ranked.end(), [](const auto& r) {
+            VkPhysicalDeviceProperties p{};
+            vkGetPhysicalDeviceProperties(r.second, &p);
+            return p.deviceType == VK_PHYSICAL_DEVICE_TYPE_CPU;
+        }), ranked.end());
     }
+    std::stable_sort(ranked.begin(), ranked.end(),
+                     [](const auto& a, const auto& b) { return a.first > b.first; });
 
-    physicalDevice = *best;
+    if (ranked.empty()) {
+        throw std::runtime_error(headless ? "[Vulkan] No suitable GPU with compute support."
+                                          : "[Vulkan] No suitable GPU with compute + present support.");
+    }
+    suitableDeviceCount = static_cast<uint32_t>(ranked.size());
+
+    const uint32_t index = deviceIndex < 0 ? 0u : static_cast<uint32_t>(deviceIndex);
+    if (index >= suitableDeviceCount) {
+        throw std::runtime_error("[Vulkan] GPU index " + std::to_string(index) + " out of range ("
+                                 + std::to_string(suitableDeviceCount) + " suitable).");
+    }
+    physicalDevice = ranked[index].second;
 
     VkPhysicalDeviceProperties props{};
     vkGetPhysicalDeviceProperties(physicalDevice, &props);
-    std::cout << "[Vulkan] Selected GPU: " << props.deviceName
+    std::cout << "[Vulkan] Selected GPU " << index << "/" << suitableDeviceCount << ": " << props.deviceName
               << " (" << deviceTypeName(props.deviceType) << ")\n";
 }
 
@@ -258,6 +301,15 @@ bool VulkanContext::deviceHasCompute(const VkPhysicalDevice& pd) {
     return false;
 }
 
+bool VulkanContext::deviceHasExtension(VkPhysicalDevice pd, const char* name) {
+    uint32_t count = 0;
+    vkEnumerateDeviceExtensionProperties(pd, nullptr, &count, nullptr);
+    std::vector<VkExtensionProperties> exts(count);
+    vkEnumerateDeviceExtensionProperties(pd, nullptr, &count, exts.data());
+    for (const auto& e : exts) if (std::strcmp(e.extensionName, name) == 0) return true;
+    return false;
+}
+
 void VulkanContext::printPhysicalDeviceInfo(const VkPhysicalDevice& pd) {
     VkPhysicalDeviceProperties props{};
     vkGetPhysicalDeviceProperties(pd, &props);
@@ -306,15 +358,19 @@ uint32_t VulkanContext::findGraphicsQueueFamily(const VkPhysicalDevice& pd) {
 
 void VulkanContext::createLogicalDevice() {
     if (physicalDevice == VK_NULL_HANDLE)  throw std::runtime_error("[Vulkan] createLogicalDevice called before selecting a GPU.");
-    if (surface == VK_NULL_HANDLE)         throw std::runtime_error("[Vulkan] createLogicalDevice requires a valid surface.");
+    if (surface == VK_NULL_HANDLE && !headless)
+        throw std::runtime_error("[Vulkan] createLogicalDevice requires a valid surface.");
 
     std::cout << "[Vulkan] Creating logical device...\n";
 
     computeQueueFamily  = findComputeQueueFamily(physicalDevice);
     graphicsQueueFamily = findGraphicsQueueFamily(physicalDevice);
 
-    // Prefer graphics family for present; fallback to any present-capable family
-    if (queueFamilySupportsPresent(physicalDevice, graphicsQueueFamily, surface)) {
+    // Prefer graphics family for present; fallback to any present-capable family.
+    // Headless: no present queue; presentQueueFamily stays UINT32_MAX.
+    if (headless) {
+        presentQueueFamily = UINT32_MAX;
+    } else if (queueFamilySupportsPresent(physicalDevice, graphicsQueueFamily, surface)) {
         presentQueueFamily = graphicsQueueFamily;
     } else {
         uint32_t qCount = 0;
@@ -330,7 +386,7 @@ void VulkanContext::createLogicalDevice() {
     uniqueFamilies.push_back(computeQueueFamily);
     if (graphicsQueueFamily != computeQueueFamily)
         uniqueFamilies.push_back(graphicsQueueFamily);
-    if (presentQueueFamily != graphicsQueueFamily && presentQueueFamily != computeQueueFamily)
+    if (!headless && presentQueueFamily != graphicsQueueFamily && presentQueueFamily != computeQueueFamily)
         uniqueFamilies.push_back(presentQueueFamily);
 
     float priority = 1.0f;
@@ -345,6 +401,23 @@ void VulkanContext::createLogicalDevice() {
         queueInfos.push_back(qi);
     }
 
+    // --- Enable Vulkan 1.2 features (timeline semaphores for FrameScheduler) ---
+    VkPhysicalDeviceVulkan12Features v12{};
+    v12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+    v12.timelineSemaphore = VK_TRUE;    // REQUIRED for FrameScheduler
+
+    // Optional 1.2 features: host query reset (GpuProfiler), fp16 arithmetic (mixed-precision shading)
+    {
+        VkPhysicalDeviceVulkan12Features have12{ VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES };
+        VkPhysicalDeviceFeatures2 have{ VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2 };
+        have.pNext = &have12;
+        vkGetPhysicalDeviceFeatures2(physicalDevice, &have);
+        hostQueryReset = have12.hostQueryReset == VK_TRUE;
+        v12.hostQueryReset = hostQueryReset ? VK_TRUE : VK_FALSE;
+        shaderFloat16 = have12.shaderFloat16 == VK_TRUE;
+        v12.shaderFloat16 = shaderFloat16 ? VK_TRUE : VK_FALSE;
+    }
+
     // --- Enable Vulkan 1.3 features (Synchronization2) ---
     VkPhysicalDeviceVulkan13Features v13{};
     v13.synchronization2 = VK_TRUE;     // REQUIRED for vkCmdPipelineBarrier2 & vkQueueSubmit2
@@ -352,15 +425,50 @@ void VulkanContext::createLogicalDevice() {
     v13.maintenance4     = VK_TRUE;     // optional
 
     v13.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES;
+    v13.pNext = &v12;
+
+    // --- Core features (only what we actually use, and only if present) ---
+    VkPhysicalDeviceFeatures supported{};
+    vkGetPhysicalDeviceFeatures(physicalDevice, &supported);
+    storageWriteWithoutFormat = supported.shaderStorageImageWriteWithoutFormat == VK_TRUE;
+    if (!storageWriteWithoutFormat) {
+        std::cerr << "[Vulkan] Warning: shaderStorageImageWriteWithoutFormat not supported; "
+                     "direct swapchain output disabled.\n";
+    }
 
     VkPhysicalDeviceFeatures2 features2{};
     features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
-    features2.pNext = &v13;         // chain 1.3 features
+    features2.pNext = &v13;         // chain 1.3 -> 1.2 features
+    features2.features.shaderStorageImageWriteWithoutFormat = storageWriteWithoutFormat ? VK_TRUE : VK_FALSE;
 
-    const char* deviceExtensions[] = {
-        VK_KHR_SWAPCHAIN_EXTENSION_NAME
-        // , VK_KHR_SWAPCHAIN_MAINTENANCE_1_EXTENSION_NAME  // optional, if you adopt present fences
-    };
+    pipelineStatistics = supported.pipelineStatisticsQuery == VK_TRUE;
+    features2.features.pipelineStatisticsQuery = pipelineStatistics ? VK_TRUE : VK_FALSE;
+
+    std::vector<const char*> deviceExtensions;
+    if (!headless) {
+        deviceExtensions.push_back(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
+        // VK_KHR_SWAPCHAIN_MAINTENANCE_1_EXTENSION_NAME  // optional, if you adopt present fences
+    }
+
+    // Optional present ids and waiting on them (low-latency pacing, see PresentPacer)
+    VkPhysicalDevicePresentIdFeaturesKHR   presentIdFeatures{ VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_ID_FEATURES_KHR };
+    VkPhysicalDevicePresentWaitFeaturesKHR presentWaitFeatures{ VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_WAIT_FEATURES_KHR };
+    if (!headless && deviceHasExtension(physicalDevice, VK_KHR_PRESENT_ID_EXTENSION_NAME)
+                  && deviceHasExtension(physicalDevice, VK_KHR_PRESENT_WAIT_EXTENSION_NAME)) {
+        presentIdFeatures.pNext = &presentWaitFeatures;
+        VkPhysicalDeviceFeatures2 have{ VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2 };
+        have.pNext = &presentIdFeatures;
+        vkGetPhysicalDeviceFeatures2(physicalDevice, &have);
+        presentWait = presentIdFeatures.presentId == VK_TRUE && presentWaitFeatures.presentWait == VK_TRUE;
+    }
+    if (presentWait) {
+        presentIdFeatures.presentId = VK_TRUE;
+        presentWaitFeatures.presentWait = VK_TRUE;
+        presentWaitFeatures.pNext = features2.pNext;
+        features2.pNext = &presentIdFeatures;
+        deviceExtensions.push_back(VK_KHR_PRESENT_ID_EXTENSION_NAME);
+        deviceExtensions.push_back(VK_KHR_PRESENT_WAIT_EXTENSION_NAME);
+    }
 
     std::vector<const char*> layers;
     if (validationEnabled) layers.push_back(kValidationLayer);
@@ -369,8 +477,8 @@ void VulkanContext::createLogicalDevice() {
     dci.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
     dci.queueCreateInfoCount = static_cast<uint32_t>(queueInfos.size());
     dci.pQueueCreateInfos    = queueInfos.data();
-    dci.enabledExtensionCount = static_cast<uint32_t>(std::size(deviceExtensions));
-    dci.ppEnabledExtensionNames = deviceExtensions;
+    dci.enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size());
+    dci.ppEnabledExtensionNames = deviceExtensions.empty() ? nullptr : deviceExtensions.data();
     dci.enabledLayerCount = static_cast<uint32_t>(layers.size());
     dci.ppEnabledLayerNames = layers.empty() ? nullptr : layers.data();
     dci.pNext = &features2;     // IMPORTANT: pass features2 via pNext
@@ -382,12 +490,15 @@ void VulkanContext::createLogicalDevice() {
 
     vkGetDeviceQueue(device, computeQueueFamily,  0, &computeQueue);
     vkGetDeviceQueue(device, graphicsQueueFamily, 0, &graphicsQueue);
-    vkGetDeviceQueue(device, presentQueueFamily,  0, &presentQueue);
+    if (!headless) vkGetDeviceQueue(device, presentQueueFamily, 0, &presentQueue);
 
     std::cout << "[Vulkan] Logical device created.\n";
     std::cout << "  Compute  queue family: " << computeQueueFamily  << "\n";
     std::cout << "  Graphics queue family: " << graphicsQueueFamily << "\n";
-    std::cout << "  Present  queue family: " << presentQueueFamily  << "\n";
+    if (!headless) std::cout << "  Present  queue family: " << presentQueueFamily << "\n";
+
+    pipelineCache = std::make_unique<PipelineCache>(physicalDevice, device);
+    memory = std::make_unique<GpuMemory>(physicalDevice, device);
 }
 
 void VulkanContext::createCommandPools() {
@@ -1,10 +1,19 @@
 #pragma once
 #include <vulkan/vulkan.h>
 #include <cstdint>
+#include <memory>
+
+class PipelineCache;
+class GpuMemory;
 
 class VulkanContext {
 public:
-    explicit VulkanContext(bool enableValidation = true, VkSurfaceKHR surface = VK_NULL_HANDLE);
+    // headless: no window-system extensions, no surface, no swapchain; the device is
+    // created immediately and only compute/graphics queues exist (no present queue).
+    // deviceIndex picks among the suitable GPUs ranked best first (-1: the best one);
+    // one context per index drives several GPUs, each with its own instance and device.
+    explicit VulkanContext(bool enableValidation = true, VkSurfaceKHR surface = VK_NULL_HANDLE,
+                           bool headless = false, int deviceIndex = -1);
     ~VulkanContext() noexcept;
 
     VulkanContext(const VulkanContext&) = delete;
@@ -13,6 +22,9 @@ public:
     // If you created the context without a surface, call this once when you have it.
     void initializeForSurface(VkSurfaceKHR surface);
 
+    bool              isHeadless()             const { return headless; }
+    uint32_t          getSuitableDeviceCount() const { return suitableDeviceCount; }   // known after device selection
+
     // Getters
     VkInstance        getInstance()            const { return instance; }
     VkPhysicalDevice  getPhysicalDevice()      const { return physicalDevice; }
@@ -26,6 +38,15 @@ public:
     uint32_t          getGraphicsQueueFamily() const { return graphicsQueueFamily; }
     uint32_t          getPresentQueueFamily()  const { return presentQueueFamily; }
     VkSurfaceKHR      getSurface()             const { return surface; }
+    VkPipelineCache   getPipelineCache()       const;   // persisted across runs, see PipelineCache
+    GpuMemory&        getMemory()              const { return *memory; }   // images and buffers, see GpuMemory
+
+    // Optional features detected (and enabled) at device creation
+    bool              supportsStorageWriteWithoutFormat() const { return storageWriteWithoutFormat; }
+    bool              supportsHostQueryReset()            const { return hostQueryReset; }
+    bool              supportsPipelineStatistics()        const { return pipelineStatistics; }
+    bool              supportsShaderFloat16()             const { return shaderFloat16; }
+    bool              supportsPresentWait()               const { return presentWait; }   // present_id + present_wait
 
     // ---- Legacy shim (keeps old code building) ----
     // Old code used context.getCommandPool() for compute work.
@@ -42,6 +63,7 @@ private:
     // Helpers
     static bool      checkValidationLayerSupport();
     static bool      deviceHasCompute(const VkPhysicalDevice& pd);
+    static bool      deviceHasExtension(VkPhysicalDevice pd, const char* name);
     static void      printPhysicalDeviceInfo(const VkPhysicalDevice& pd);
     static uint32_t  findComputeQueueFamily(const VkPhysicalDevice& pd);
     static uint32_t  findGraphicsQueueFamily(const VkPhysicalDevice& pd);
@@ -64,6 +86,9 @@ private:
 
     VkSurfaceKHR      surface               = VK_NULL_HANDLE;
 
+    std::unique_ptr<PipelineCache> pipelineCache;   // created with the device, saved before it goes
+    std::unique_ptr<GpuMemory>     memory;          // created with the device, freed before it goes
+
     // Families
     uint32_t          computeQueueFamily    = UINT32_MAX;
     uint32_t          graphicsQueueFamily   = UINT32_MAX;
@@ -72,4 +97,12 @@ private:
     // State
     bool              validationEnabled     = false;
     bool              initializedForSurface = false;
+    bool              headless              = false;
+    int               deviceIndex           = -1;
+    uint32_t          suitableDeviceCount   = 0;
+    bool              storageWriteWithoutFormat = false;
+    bool              hostQueryReset        = false;
+    bool              pipelineStatistics    = false;
+    bool              shaderFloat16         = false;
+    bool              presentWait           = false;
 };
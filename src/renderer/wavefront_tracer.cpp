@@ -0,0 +1,247 @@
+#include "wavefront_tracer.h"
+#include "vulkan_context.h"
+#include "compute_pass.h"
+
+#include <stdexcept>
+#include <iostream>
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+// Must match the buffer and push_constant layouts in wavefront.comp
+namespace {
+    constexpr uint32_t kRayBytes    = 6 * 4 * sizeof(float);   // WavefrontRay: six vec4
+    constexpr uint32_t kGroupSize   = 64;                      // local_size_x
+    constexpr VkDeviceSize kIntegrateArgsOffset = 16;
+    constexpr VkDeviceSize kDiskArgsOffset      = 32;
+    constexpr VkDeviceSize kCountersBytes       = 48;
+
+    struct WavefrontPushConstants {
+        CameraData camera;
+        int32_t    renderWidth, renderHeight;
+        int32_t    tileX, tileY;
+        int32_t    imageWidth, imageHeight;
+        int32_t    rowOffset;      // slice
+        int32_t    rowCount;
+        uint32_t   list;           // active list the integrate stage consumes
+        uint32_t   phase;          // prepare: 0 after integrate, 1 after disk shading
+        uint32_t   sceneSlot;      // ComputePipeline's scene ring slot
+    };
+
+    // Stage constants appended to the trace's specialization; data must outlive the build
+    struct StageSpecialization {
+        std::vector<VkSpecializationMapEntry> entries;
+        std::vector<uint8_t>                  data;
+        VkSpecializationInfo                  info{};
+
+        StageSpecialization(const VkSpecializationInfo& trace, uint32_t stage) {
+            entries.assign(trace.pMapEntries, trace.pMapEntries + trace.mapEntryCount);
+            const uint8_t* src = static_cast<const uint8_t*>(trace.pData);
+            data.assign(src, src + trace.dataSize);
+
+            const uint32_t values[3] = { stage, WavefrontTracer::kChunkSteps, WavefrontTracer::kCapacity };
+            for (uint32_t i = 0; i < 3; ++i) {
+                const uint32_t offset = static_cast<uint32_t>(data.size());
+                data.resize(offset + sizeof(uint32_t));
+                std::memcpy(data.data() + offset, &values[i], sizeof(uint32_t));
+                entries.push_back({ 30 + i, offset, sizeof(uint32_t) });
+            }
+            info = { static_cast<uint32_t>(entries.size()), entries.data(), data.size(), data.data() };
+        }
+    };
+
+    // Every stage reads what the previous one wrote, including the indirect arguments
+    void stageBarrier(VkCommandBuffer cmd) {
+        VkMemoryBarrier2 barrier{ VK_STRUCTURE_TYPE_MEMORY_BARRIER_2 };
+        barrier.srcStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+        barrier.srcAccessMask = VK_ACCESS_2_SHADER_WRITE_BIT;
+        barrier.dstStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT;
+        barrier.dstAccessMask = VK_ACCESS_2_SHADER_READ_BIT | VK_ACCESS_2_SHADER_WRITE_BIT
+                              | VK_ACCESS_2_INDIRECT_COMMAND_READ_BIT;
+
+        VkDependencyInfo dep{ VK_STRUCTURE_TYPE_DEPENDENCY_INFO };
+        dep.memoryBarrierCount = 1;
+        dep.pMemoryBarriers = &barrier;
+        vkCmdPipelineBarrier2(cmd, &dep);
+    }
+
+    uint32_t groupsFor(uint32_t invocations) {
+        return (invocations + kGroupSize - 1) / kGroupSize;
+    }
+}
+
+WavefrontTracer::WavefrontTracer(VulkanContext& context, const std::string& spvPath, VkDescriptorSetLayout output,
+                                 VkDescriptorSetLayout sky, VkDescriptorSetLayout disk)
+    : ctx(context), device(context.getDevice()), shaderPath(spvPath), outputLayout(output), skyLayout(sky),
+      diskLayout(disk) {
+
+    createBuffer(rays,     static_cast<VkDeviceSize>(kCapacity) * kRayBytes, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+    createBuffer(queues,   static_cast<VkDeviceSize>(kCapacity) * 3 * sizeof(uint32_t), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+    createBuffer(counters, kCountersBytes, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT);
+    createDescriptors();
+
+    std::cout << "[Wavefront] " << kCapacity << " rays per slice, " << kChunkSteps << " steps per round ("
+              << (rays.size + queues.size) / (1024 * 1024) << " MiB).\n";
+}
+
+WavefrontTracer::~WavefrontTracer() {
+    // Caller guarantees the GPU is idle (ComputePipeline drains the scheduler first)
+    for (auto& stage : stages) stage.reset();
+    if (pool)      vkDestroyDescriptorPool(device, pool, nullptr);
+    if (setLayout) vkDestroyDescriptorSetLayout(device, setLayout, nullptr);
+    for (Buffer* b : { &rays, &queues, &counters }) {
+        if (b->buffer) vkDestroyBuffer(device, b->buffer, nullptr);
+        ctx.getMemory().free(b->memory);
+    }
+}
+
+void WavefrontTracer::createBuffer(Buffer& b, VkDeviceSize size, VkBufferUsageFlags usage) {
+    VkBufferCreateInfo bci{ VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO };
+    bci.size = size;
+    bci.usage = usage;
+    bci.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    if (vkCreateBuffer(device, &bci, nullptr, &b.buffer) != VK_SUCCESS) {
+        throw std::runtime_error("[Wavefront] Failed to create ray buffer.");
+    }
+
+    b.memory = ctx.getMemory().bind(b.buffer, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    b.size = size;
+}
+
+void WavefrontTracer::createDescriptors() {
+    VkDescriptorSetLayoutBinding bindings[3]{};
+    for (uint32_t i = 0; i < 3; ++i) {
+        bindings[i].binding = i;
+        bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        bindings[i].descriptorCount = 1;
+        bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    }
+
+    VkDescriptorSetLayoutCreateInfo lci{ VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO };
+    lci.bindingCount = 3;
+    lci.pBindings = bindings;
+    if (vkCreateDescriptorSetLayout(device, &lci, nullptr, &setLayout) != VK_SUCCESS) {
+        throw std::runtime_error("[Wavefront] Failed to create descriptor set layout.");
+    }
+
+    VkDescriptorPoolSize poolSize{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 3 };
+    VkDescriptorPoolCreateInfo pci{ VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO };
+    pci.maxSets = 1;
+    pci.poolSizeCount = 1;
+    pci.pPoolSizes = &poolSize;
+    if (vkCreateDescriptorPool(device, &pci, nullptr, &pool) != VK_SUCCESS) {
+        throw std::runtime_error("[Wavefront] Failed to create descriptor pool.");
+    }
+
+    VkDescriptorSetAllocateInfo ai{ VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO };
+    ai.descriptorPool = pool;
+    ai.descriptorSetCount = 1;
+    ai.pSetLayouts = &setLayout;
+    if (vkAllocateDescriptorSets(device, &ai, &set) != VK_SUCCESS) {
+        throw std::runtime_error("[Wavefront] Failed to allocate descriptor set.");
+    }
+
+    VkDescriptorBufferInfo infos[3] = {
+        { rays.buffer,     0, VK_WHOLE_SIZE },
+        { queues.buffer,   0, VK_WHOLE_SIZE },
+        { counters.buffer, 0, VK_WHOLE_SIZE },
+    };
+    VkWriteDescriptorSet writes[3]{};
+    for (uint32_t i = 0; i < 3; ++i) {
+        writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        writes[i].dstSet = set;
+        writes[i].dstBinding = i;
+        writes[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        writes[i].descriptorCount = 1;
+        writes[i].pBufferInfo = &infos[i];
+    }
+    vkUpdateDescriptorSets(device, 3, writes, 0, nullptr);
+}
+
+void WavefrontTracer::build(const VkSpecializationInfo& traceSpecialization, int32_t samplesPerAxis, int32_t maxSteps) {
+    for (uint32_t stage = 0; stage < StageCount; ++stage) {
+        const StageSpecialization spec(traceSpecialization, stage);
+        if (stages[stage]) {
+            stages[stage]->rebuild(&spec.info);
+        } else {
+            // set 0: output image (the trace's), set 1: ray state and queues, set 2: sky,
+            // set 3: disk textures
+            stages[stage] = std::make_unique<ComputePass>(ctx, MappedFile(shaderPath),
+                std::vector<VkDescriptorSetLayout>{ outputLayout, setLayout, skyLayout, diskLayout },
+                static_cast<uint32_t>(sizeof(WavefrontPushConstants)), &spec.info);
+        }
+    }
+
+    samplesPerPixel = static_cast<uint32_t>(samplesPerAxis * samplesPerAxis);
+    rounds = (static_cast<uint32_t>(std::max(maxSteps, 1)) + kChunkSteps - 1) / kChunkSteps + kDiskPauses;
+}
+
+void WavefrontTracer::record(VkCommandBuffer cmd, VkDescriptorSet outputSet, VkDescriptorSet skySet,
+                             VkDescriptorSet diskSet, const CameraData& camera, uint32_t sceneSlot, VkExtent2D traced,
+                             VkOffset2D tileOffset, VkExtent2D imageSize) {
+    const uint32_t rowSamples = traced.width * samplesPerPixel;
+    if (rowSamples > kCapacity) {
+        throw std::runtime_error("[Wavefront] Image row exceeds the ray buffer capacity.");
+    }
+    const uint32_t sliceRows = std::min(kCapacity / rowSamples, traced.height);
+
+    WavefrontPushConstants pc{};
+    pc.camera = camera;
+    pc.renderWidth  = static_cast<int32_t>(traced.width);
+    pc.renderHeight = static_cast<int32_t>(traced.height);
+    pc.tileX = tileOffset.x;
+    pc.tileY = tileOffset.y;
+    pc.imageWidth  = static_cast<int32_t>(imageSize.width);
+    pc.imageHeight = static_cast<int32_t>(imageSize.height);
+    pc.sceneSlot = sceneSlot;
+
+    // The previous frame's stages used the same buffers earlier on this queue
+    stageBarrier(cmd);
+
+    const VkDescriptorSet sets[4] = { outputSet, set, skySet, diskSet };
+    auto run = [&](Stage stage, uint32_t groups) {
+        stages[stage]->bind(cmd, sets, 4);
+        stages[stage]->pushConstants(cmd, &pc, sizeof(pc));
+        vkCmdDispatch(cmd, groups, 1, 1);
+    };
+    auto runIndirect = [&](Stage stage, VkDeviceSize offset) {
+        stages[stage]->bind(cmd, sets, 4);
+        stages[stage]->pushConstants(cmd, &pc, sizeof(pc));
+        vkCmdDispatchIndirect(cmd, counters.buffer, offset);
+    };
+
+    for (uint32_t row = 0; row < traced.height; row += sliceRows) {
+        pc.rowOffset = static_cast<int32_t>(row);
+        pc.rowCount  = static_cast<int32_t>(std::min(sliceRows, traced.height - row));
+        const uint32_t sliceSamples = static_cast<uint32_t>(pc.rowCount) * rowSamples;
+
+        run(Reset, 1);
+        stageBarrier(cmd);
+        run(Generate, groupsFor(sliceSamples));
+        stageBarrier(cmd);
+
+        // Size the first integrate from active list 0
+        pc.list = 1;
+        pc.phase = 1;
+        run(Prepare, 1);
+        stageBarrier(cmd);
+
+        // Each round: integrate list -> list ^ 1 (+ disk queue), shade the queue -> list ^ 1
+        for (uint32_t round = 0; round < rounds; ++round) {
+            pc.list = round & 1u;
+            runIndirect(Integrate, kIntegrateArgsOffset);
+            stageBarrier(cmd);
+            pc.phase = 0;
+            run(Prepare, 1);
+            stageBarrier(cmd);
+            runIndirect(Disk, kDiskArgsOffset);
+            stageBarrier(cmd);
+            pc.phase = 1;
+            run(Prepare, 1);
+            stageBarrier(cmd);
+        }
+
+        run(Resolve, groupsFor(static_cast<uint32_t>(pc.rowCount) * traced.width));
+        stageBarrier(cmd);
+    }
+}
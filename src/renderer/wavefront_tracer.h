@@ -0,0 +1,89 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "compute_pipeline.h"
+#include "gpu_memory.h"
+
+class VulkanContext;
+class ComputePass;
+
+/**
+ * WavefrontTracer
+ * ===============
+ * Alternative to the per-pixel trace loop (ComputePipelineOptions::wavefront). Rays
+ * leave the geodesic loop after very different step counts, and a disk crossing runs
+ * the disk raymarch inline, so a warp of gargantua.comp waits for its slowest lane.
+ * Here the state of every sample lives in a buffer and wavefront.comp advances it in
+ * stages: generate camera rays, then repeatedly integrate CHUNK_STEPS steps of every
+ * active ray and raymarch the disk for the rays that crossed it, each stage over a
+ * compacted queue sized by indirect dispatch, and finally resolve into the output image.
+ *
+ * The image is traced in row slices of at most kCapacity samples, with a fixed number of
+ * rounds per slice (see record()); rays still running after the last round are shaded
+ * as step-limited. The buffers are shared by all frames: every trace runs on one queue.
+ */
+class WavefrontTracer {
+public:
+    // spvPath is wavefront.comp.spv or its fp16 build; outputLayout is the trace's set 0
+    // layout (storage image at binding 0, scene ring at 4), skyLayout and diskLayout SkyEnvironment's
+    // and DiskTextures'
+    WavefrontTracer(VulkanContext& context, const std::string& spvPath, VkDescriptorSetLayout outputLayout,
+                    VkDescriptorSetLayout skyLayout, VkDescriptorSetLayout diskLayout);
+    ~WavefrontTracer();
+
+    WavefrontTracer(const WavefrontTracer&) = delete;
+    WavefrontTracer& operator=(const WavefrontTracer&) = delete;
+
+    // (Re)builds the stage pipelines from the trace's specialization (the same
+    // TraceSpecConstants as gargantua.comp). The caller guarantees no submitted frame
+    // still uses the old pipelines.
+    void build(const VkSpecializationInfo& traceSpecialization, int32_t samplesPerAxis, int32_t maxSteps);
+
+    // Records the whole trace of traced pixels into outputSet's image, which must be in
+    // GENERAL layout. Rays are generated like gargantua.comp's for an imageSize image
+    // with the traced rect at tileOffset; sceneSlot selects the frame's scene state in
+    // outputSet's ring. Call on the trace queue.
+    void record(VkCommandBuffer cmd, VkDescriptorSet outputSet, VkDescriptorSet skySet, VkDescriptorSet diskSet,
+                const CameraData& camera, uint32_t sceneSlot, VkExtent2D traced, VkOffset2D tileOffset,
+                VkExtent2D imageSize);
+
+    // Samples per slice; must match CAPACITY (constant_id = 32) in wavefront.comp
+    static constexpr uint32_t kCapacity   = 1u << 19;
+    static constexpr uint32_t kChunkSteps = 64;    // integration steps per ray per round
+    static constexpr uint32_t kDiskPauses = 8;     // extra rounds for disk crossings
+
+private:
+    enum Stage : uint32_t { Reset, Generate, Integrate, Disk, Prepare, Resolve, StageCount };
+
+    struct Buffer {
+        VkBuffer        buffer = VK_NULL_HANDLE;
+        GpuAllocation   memory;
+        VkDeviceSize    size   = 0;
+    };
+
+    void createBuffer(Buffer& buffer, VkDeviceSize size, VkBufferUsageFlags usage);
+    void createDescriptors();
+
+    VulkanContext&         ctx;
+    VkDevice               device       = VK_NULL_HANDLE;
+    std::string            shaderPath;
+    VkDescriptorSetLayout  outputLayout = VK_NULL_HANDLE;
+    VkDescriptorSetLayout  skyLayout    = VK_NULL_HANDLE;
+    VkDescriptorSetLayout  diskLayout   = VK_NULL_HANDLE;
+
+    Buffer                 rays;        // WavefrontRay per sample of the slice
+    Buffer                 queues;      // two active lists + disk queue, kCapacity each
+    Buffer                 counters;    // queue sizes and the indirect dispatch arguments
+
+    VkDescriptorSetLayout  setLayout    = VK_NULL_HANDLE;   // binding 0: rays, 1: queues, 2: counters
+    VkDescriptorPool       pool         = VK_NULL_HANDLE;
+    VkDescriptorSet        set          = VK_NULL_HANDLE;
+    std::array<std::unique_ptr<ComputePass>, StageCount> stages;
+
+    uint32_t               samplesPerPixel = 1;
+    uint32_t               rounds          = 1;             // integrate + disk rounds per slice
+};
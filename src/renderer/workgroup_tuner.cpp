@@ -0,0 +1,185 @@
+#include "workgroup_tuner.h"
+#include "vulkan_context.h"
+#include "frame_scheduler.h"
+#include "pipeline_cache.h"
+
+#include <stdexcept>
+#include <iostream>
+#include <fstream>
+#include <algorithm>
+#include <filesystem>
+
+namespace {
+    // Wide, square and tall shapes from 32 to 256 invocations
+    constexpr VkExtent2D kShapes[] = {
+        { 8, 4 }, { 4, 8 }, { 8, 8 }, { 16, 4 }, { 32, 2 },
+        { 16, 8 }, { 8, 16 }, { 32, 4 }, { 64, 2 },
+        { 16, 16 }, { 32, 8 }, { 64, 4 },
+    };
+}
+
+WorkgroupTuner::WorkgroupTuner(VulkanContext& context, FrameScheduler& frameScheduler, FrameScheduler::Queue q)
+    : ctx(context), scheduler(frameScheduler), queue(q), device(context.getDevice()) {
+
+    const bool compute = queue == FrameScheduler::Queue::Compute;
+    vkQueue = compute ? ctx.getComputeQueue() : ctx.getGraphicsQueue();
+    pool    = compute ? ctx.getComputeCommandPool() : ctx.getGraphicsCommandPool();
+
+    VkPhysicalDeviceProperties props{};
+    vkGetPhysicalDeviceProperties(ctx.getPhysicalDevice(), &props);
+    periodNs = props.limits.timestampPeriod;
+    driverVersion = props.driverVersion;
+    path = PipelineCache::cacheDirectory() + "/workgroup_" + PipelineCache::deviceKey(props) + ".txt";
+
+    uint32_t qCount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(ctx.getPhysicalDevice(), &qCount, nullptr);
+    std::vector<VkQueueFamilyProperties> qProps(qCount);
+    vkGetPhysicalDeviceQueueFamilyProperties(ctx.getPhysicalDevice(), &qCount, qProps.data());
+
+    const uint32_t family = compute ? ctx.getComputeQueueFamily() : ctx.getGraphicsQueueFamily();
+    const uint32_t validBits = qProps[family].timestampValidBits;
+    if (validBits == 0) {
+        std::cerr << "[Tuner] Warning: trace queue has no timestamp support; autotune disabled.\n";
+        return;
+    }
+    mask = (validBits >= 64) ? ~0ull : ((1ull << validBits) - 1ull);
+
+    capacity = static_cast<uint32_t>(std::size(kShapes)) * 2;
+    VkQueryPoolCreateInfo qci{ VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO };
+    qci.queryType = VK_QUERY_TYPE_TIMESTAMP;
+    qci.queryCount = capacity;
+    if (vkCreateQueryPool(device, &qci, nullptr, &queries) != VK_SUCCESS) {
+        throw std::runtime_error("[Tuner] Failed to create timestamp query pool.");
+    }
+    available = true;
+}
+
+WorkgroupTuner::~WorkgroupTuner() {
+    // benchmark() waits for its submit, so the pool is idle here
+    if (queries) vkDestroyQueryPool(device, queries, nullptr);
+}
+
+std::vector<VkExtent2D> WorkgroupTuner::candidates() const {
+    VkPhysicalDeviceProperties props{};
+    vkGetPhysicalDeviceProperties(ctx.getPhysicalDevice(), &props);
+    const auto& limits = props.limits;
+
+    std::vector<VkExtent2D> shapes;
+    for (const VkExtent2D& s : kShapes) {
+        if (s.width <= limits.maxComputeWorkGroupSize[0] && s.height <= limits.maxComputeWorkGroupSize[1]
+            && s.width * s.height <= limits.maxComputeWorkGroupInvocations) {
+            shapes.push_back(s);
+        }
+    }
+    return shapes;
+}
+
+std::vector<WorkgroupTuner::Result> WorkgroupTuner::benchmark(
+        const std::vector<VkExtent2D>& shapes,
+        const std::function<void(VkCommandBuffer)>& setup,
+        const std::function<void(VkCommandBuffer, size_t)>& dispatch,
+        uint32_t repeats) {
+
+    if (!available || shapes.empty()) return {};
+    if (shapes.size() * 2 > capacity) throw std::runtime_error("[Tuner] Too many candidates.");
+    repeats = std::max(repeats, 1u);
+
+    VkCommandBufferAllocateInfo ai{ VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO };
+    ai.commandPool = pool;
+    ai.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    ai.commandBufferCount = 1;
+    VkCommandBuffer cmd = VK_NULL_HANDLE;
+    if (vkAllocateCommandBuffers(device, &ai, &cmd) != VK_SUCCESS) {
+        throw std::runtime_error("[Tuner] Failed to allocate command buffer.");
+    }
+
+    VkCommandBufferBeginInfo bi{ VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
+    bi.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    vkBeginCommandBuffer(cmd, &bi);
+    vkCmdResetQueryPool(cmd, queries, 0, static_cast<uint32_t>(shapes.size()) * 2);
+
+    setup(cmd);
+
+    // Every dispatch writes the same scratch image: WAW barriers also keep them from overlapping
+    VkMemoryBarrier2 serialize{ VK_STRUCTURE_TYPE_MEMORY_BARRIER_2 };
+    serialize.srcStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+    serialize.srcAccessMask = VK_ACCESS_2_SHADER_WRITE_BIT;
+    serialize.dstStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+    serialize.dstAccessMask = VK_ACCESS_2_SHADER_READ_BIT | VK_ACCESS_2_SHADER_WRITE_BIT;
+    VkDependencyInfo dep{ VK_STRUCTURE_TYPE_DEPENDENCY_INFO };
+    dep.memoryBarrierCount = 1;
+    dep.pMemoryBarriers = &serialize;
+
+    for (size_t i = 0; i < shapes.size(); ++i) {
+        vkCmdPipelineBarrier2(cmd, &dep);
+        dispatch(cmd, i);                        // warm-up
+        vkCmdPipelineBarrier2(cmd, &dep);
+
+        const uint32_t q = static_cast<uint32_t>(i) * 2;
+        vkCmdWriteTimestamp2(cmd, VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT, queries, q);
+        for (uint32_t r = 0; r < repeats; ++r) {
+            if (r) vkCmdPipelineBarrier2(cmd, &dep);
+            dispatch(cmd, i);
+        }
+        vkCmdWriteTimestamp2(cmd, VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT, queries, q + 1);
+    }
+    vkEndCommandBuffer(cmd);
+
+    VkCommandBufferSubmitInfo cb{ VK_STRUCTURE_TYPE_COMMAND_BUFFER_SUBMIT_INFO };
+    cb.commandBuffer = cmd;
+
+    const TimelinePoint done = scheduler.signal(queue);
+    VkSemaphoreSubmitInfo signalDone{ VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO };
+    signalDone.semaphore = done.semaphore;
+    signalDone.value = done.value;
+    signalDone.stageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+
+    VkSubmitInfo2 sub{ VK_STRUCTURE_TYPE_SUBMIT_INFO_2 };
+    sub.commandBufferInfoCount = 1;
+    sub.pCommandBufferInfos = &cb;
+    sub.signalSemaphoreInfoCount = 1;
+    sub.pSignalSemaphoreInfos = &signalDone;
+
+    if (vkQueueSubmit2(vkQueue, 1, &sub, VK_NULL_HANDLE) != VK_SUCCESS) {
+        vkFreeCommandBuffers(device, pool, 1, &cmd);
+        throw std::runtime_error("[Tuner] Failed to submit benchmark.");
+    }
+    scheduler.wait(done);
+    vkFreeCommandBuffers(device, pool, 1, &cmd);
+
+    std::vector<uint64_t> stamps(shapes.size() * 2);
+    if (vkGetQueryPoolResults(device, queries, 0, static_cast<uint32_t>(stamps.size()),
+                              stamps.size() * sizeof(uint64_t), stamps.data(), sizeof(uint64_t),
+                              VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT) != VK_SUCCESS) {
+        throw std::runtime_error("[Tuner] Failed to read timestamps.");
+    }
+
+    std::vector<Result> results;
+    for (size_t i = 0; i < shapes.size(); ++i) {
+        const uint64_t ticks = ((stamps[i * 2 + 1] & mask) - (stamps[i * 2] & mask)) & mask;
+        results.push_back({ shapes[i], static_cast<float>(ticks * periodNs * 1e-6 / repeats) });
+    }
+    std::stable_sort(results.begin(), results.end(), [](const Result& a, const Result& b) { return a.ms < b.ms; });
+    return results;
+}
+
+bool WorkgroupTuner::load(VkExtent2D& size) const {
+    std::ifstream file(path);
+    uint32_t version = 0, w = 0, h = 0;
+    if (!(file >> version >> w >> h) || version != driverVersion || w == 0 || h == 0) return false;
+
+    // Only shapes this device still accepts
+    for (const VkExtent2D& s : candidates()) {
+        if (s.width == w && s.height == h) { size = s; return true; }
+    }
+    return false;
+}
+
+void WorkgroupTuner::store(VkExtent2D size) const {
+    std::error_code ec;
+    std::filesystem::create_directories(std::filesystem::path(path).parent_path(), ec);
+
+    std::ofstream file(path, std::ios::trunc);
+    file << driverVersion << " " << size.width << " " << size.height << "\n";
+    if (!file) std::cerr << "[Tuner] Warning: failed to write " << path << "\n";
+}
@@ -0,0 +1,65 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "frame_scheduler.h"
+
+class VulkanContext;
+
+/**
+ * WorkgroupTuner
+ * ==============
+ * Picks the trace shader's workgroup shape per device. The geodesic loop is divergent
+ * and register-heavy, so the fastest shape depends on vendor and generation (8x8 on one
+ * GPU, 32x4 on another). benchmark() times every candidate with GPU timestamps on the
+ * queue that traces. The winner is stored next to the pipeline cache, keyed by
+ * pipelineCacheUUID and driver version, so later runs skip the benchmark.
+ */
+class WorkgroupTuner {
+public:
+    struct Result {
+        VkExtent2D size{};
+        float      ms = 0.0f;   // mean over the timed repeats
+    };
+
+    WorkgroupTuner(VulkanContext& context, FrameScheduler& scheduler, FrameScheduler::Queue queue);
+    ~WorkgroupTuner();
+
+    WorkgroupTuner(const WorkgroupTuner&) = delete;
+    WorkgroupTuner& operator=(const WorkgroupTuner&) = delete;
+
+    // False when the queue has no timestamps; benchmark() then returns nothing
+    bool isAvailable() const { return available; }
+
+    // Shapes within the device's workgroup limits
+    std::vector<VkExtent2D> candidates() const;
+
+    // One submit: setup once, then per candidate a warm-up dispatch and `repeats` timed ones,
+    // serialized by barriers. Blocks until done. Results come back fastest first.
+    std::vector<Result> benchmark(const std::vector<VkExtent2D>& candidates,
+                                  const std::function<void(VkCommandBuffer)>& setup,
+                                  const std::function<void(VkCommandBuffer, size_t candidate)>& dispatch,
+                                  uint32_t repeats = 3);
+
+    // Stored winner for this device and driver, if any
+    bool load(VkExtent2D& size) const;
+    void store(VkExtent2D size) const;
+
+private:
+    VulkanContext&  ctx;
+    FrameScheduler& scheduler;
+    FrameScheduler::Queue queue;
+    VkDevice        device   = VK_NULL_HANDLE;
+    VkQueue         vkQueue  = VK_NULL_HANDLE;
+    VkCommandPool   pool     = VK_NULL_HANDLE;
+    VkQueryPool     queries  = VK_NULL_HANDLE;
+    uint32_t        capacity = 0;      // timestamps in the pool
+    bool            available = false;
+    float           periodNs = 1.0f;
+    uint64_t        mask     = ~0ull;
+    uint32_t        driverVersion = 0;
+    std::string     path;
+};